@@ -6,3 +6,5 @@ SUBDIRS += modbus
 SUBDIRS += core
 SUBDIRS += client
 SUBDIRS += server
+SUBDIRS += loadgen
+SUBDIRS += benchmarks
@@ -0,0 +1,38 @@
+TEMPLATE = app
+
+TARGET = bench_alloc
+
+CONFIG += console no_keywords
+CONFIG -= app_bundle
+
+DESTDIR  = ../../bin
+
+QT    = core gui widgets network serialport xml
+
+unix:QMAKE_RPATHDIR += .
+
+# Note: poll cycle is measured on the client runtime, so client application is built in (except 'main.cpp')
+INCLUDEPATH += . \
+    $$PWD/../.. \
+    $$PWD/../../modbus \
+    $$PWD/../../core/sdk \
+    $$PWD/../../core/core \
+    $$PWD/../../core \
+    $$PWD/../../client \
+    $$PWD/../../client/core \
+    $$PWD/../../loadgen
+
+include($$PWD/../../client/core/core.pri)
+include($$PWD/../../client/project/project.pri)
+include($$PWD/../../client/gui/gui.pri)
+include($$PWD/../../client/runtime/runtime.pri)
+
+HEADERS += \
+    $$PWD/../../loadgen/loadgen.h
+
+SOURCES += \
+    $$PWD/../../loadgen/loadgen.cpp \
+    main.cpp
+
+LIBS  += -L../../bin -lcore
+LIBS  += -L../../bin -lModbus
@@ -0,0 +1,463 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+// Heap allocations of the steady-state request path against in-process Modbus::ServerTCP over 127.0.0.1:
+// 'alloc_protocol' - Modbus::Client/ClientPort request (build request, write, read, parse);
+// 'alloc_poll'     - complete poll cycle of the client runtime: mbClientPortRunnable with its
+//                    mbClientDeviceRunnable's (schedule, arbitrate, request, statistics, Tx/Rx trace)
+//                    and delivery of read values (mbClientRunMessage::setComplete -> mbClientRunItem ->
+//                    mbClientDataViewItem::update) to data view items. Server changes one register
+//                    on every read, so both changed and unchanged values are delivered.
+// malloc family is hooked (glibc) and calls are counted only inside 'process'/'request' calls
+// of the client and the server and inside 'run'/'idleTimeout' of the port runnable after warm-up.
+// Mode fails if any allocation was made. Justified exceptions (not counted):
+// - event loop of the thread (Qt registers timer and dispatches socket notifier events on heap);
+// - queued 'valueChanged' notification of changed data view item to the view in GUI thread
+//   (one event per changed value, view isn't connected here, so the signal itself is measured);
+// - logger thread which formats Tx/Rx trace records and log lines.
+//
+// Usage: bench_alloc [requests] [warm-up requests] [tcp port]
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QAbstractEventDispatcher>
+
+#include <ModbusClient.h>
+#include <ModbusClientPort.h>
+#include <ModbusPortTCP.h>
+#include <ModbusServerTCP.h>
+
+#include <client.h>
+#include <project/client_port.h>
+#include <project/client_device.h>
+#include <project/client_dataview.h>
+#include <runtime/client_runtime.h>
+#include <runtime/client_rundevice.h>
+#include <runtime/client_runitem.h>
+#include <runtime/client_portrunnable.h>
+#include <runtime/client_stats.h>
+
+#include "loadgen.h"
+
+static thread_local bool s_armed = false;  // current thread is within measured call
+static std::atomic<bool> s_counting(false); // warm-up is finished
+static std::atomic<quint64> s_allocs(0);
+
+static inline void count()
+{
+    if (s_armed && s_counting.load(std::memory_order_relaxed))
+        s_allocs.fetch_add(1, std::memory_order_relaxed);
+}
+
+#ifdef __GLIBC__
+extern "C" {
+
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t n, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+
+void *malloc(size_t size)
+{
+    count();
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    count();
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    count();
+    return __libc_realloc(ptr, size);
+}
+
+void *memalign(size_t alignment, size_t size)
+{
+    count();
+    return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size)
+{
+    count();
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **ptr, size_t alignment, size_t size)
+{
+    count();
+    void *p = __libc_memalign(alignment, size);
+    if (!p)
+        return ENOMEM;
+    *ptr = p;
+    return 0;
+}
+
+} // extern "C"
+#endif // __GLIBC__
+
+class Armed
+{
+public:
+    Armed() { s_armed = true; }
+    ~Armed() { s_armed = false; }
+};
+
+// Client application core without UI: data view items check up the state of its runtime
+class AllocClient : public mbClient
+{
+public:
+    AllocClient() { m_runtime = new mbClientRuntime(this); }
+};
+
+// Memory device that changes the first holding register on every read
+class AllocDevice : public LoadDevice
+{
+public:
+    AllocDevice() : m_reads(0) {}
+
+public:
+    Modbus::StatusCode readHoldingRegisters(uint8_t unit, uint16_t offset, uint16_t count, uint16_t *values) override
+    {
+        Modbus::StatusCode r = LoadDevice::readHoldingRegisters(unit, offset, count, values);
+        if (Modbus::StatusIsGood(r) && (offset == 0) && count)
+            values[0] = ++m_reads;
+        return r;
+    }
+
+private:
+    uint16_t m_reads;
+};
+
+class AllocServer : public QThread
+{
+public:
+    explicit AllocServer(quint16 port) : m_port(port), m_ctrlRun(true), m_ready(false) {}
+
+public:
+    inline bool isReady() const { return m_ready; }
+    void stop()
+    {
+        m_ctrlRun = false;
+        QAbstractEventDispatcher *dispatcher = eventDispatcher();
+        if (dispatcher)
+            dispatcher->wakeUp();
+    }
+
+protected:
+    void run() override
+    {
+        QEventLoop loop;
+        QTimer timer;
+        timer.setSingleShot(true);
+        AllocDevice device;
+        Modbus::ServerTCP port(&device);
+        port.setPort(m_port);
+        port.setEventDriven(true);
+        while (m_ctrlRun)
+        {
+            loop.processEvents();
+            Modbus::StatusCode r;
+            {
+                Armed a;
+                r = port.process();
+            }
+            if (!m_ready)
+            {
+                if (Modbus::StatusIsBad(r))
+                    break;
+                m_ready = port.isOpen();
+            }
+            int timeout = port.idleTimeout();
+            if (timeout > 0)
+            {
+                timer.start(timeout);
+                loop.processEvents(QEventLoop::WaitForMoreEvents);
+            }
+            else if (timeout < 0) // no connections yet
+            {
+                timer.stop();
+                loop.processEvents(QEventLoop::WaitForMoreEvents);
+            }
+        }
+        port.close();
+    }
+
+private:
+    quint16 m_port;
+    std::atomic<bool> m_ctrlRun;
+    std::atomic<bool> m_ready;
+};
+
+static bool bench(quint16 tcpPort, int window, bool trace, int requests, int warmup)
+{
+    const Modbus::PortTCP::Strings &s = Modbus::PortTCP::Strings::instance();
+    Modbus::Settings settings;
+    settings[s.type] = Modbus::enumKey(Modbus::TCP);
+    settings[s.host] = QStringLiteral("127.0.0.1");
+    settings[s.port] = tcpPort;
+    settings[s.timeout] = 3000;
+
+    Modbus::ClientPort *port = Modbus::createClientPort(settings);
+    port->setPipelineWindow(static_cast<uint32_t>(window));
+    port->setTraceEnabled(trace);
+    quint64 traced = 0;
+    // receiver reads bytes but doesn't keep them, so trace buffer of the port is reused
+    QObject::connect(port, &Modbus::ClientPort::signalTx, [&traced](const QString &, const QByteArray &bytes) { traced += static_cast<quint64>(bytes.size()); });
+    QObject::connect(port, &Modbus::ClientPort::signalRx, [&traced](const QString &, const QByteArray &bytes) { traced += static_cast<quint64>(bytes.size()); });
+    QVector<Modbus::Client*> clients;
+    QVector<int> ops;
+    for (int i = 0; i < window; i++)
+    {
+        clients.append(new Modbus::Client(1, port, port));
+        ops.append(i);
+    }
+
+    uint16_t values[MB_MAX_REGISTERS] = {};
+    uint8_t bits[MB_MAX_BYTES] = {};
+    QEventLoop loop;
+    QTimer timer;
+    timer.setSingleShot(true);
+    int done = 0, errors = 0;
+    quint64 allocs = s_allocs;
+    while (done < warmup + requests)
+    {
+        loop.processEvents();
+        for (int i = 0; i < clients.count(); i++)
+        {
+            Modbus::Client *c = clients.at(i);
+            uint16_t offset = static_cast<uint16_t>((ops.at(i) * 10) % 1000);
+            Modbus::StatusCode r;
+            {
+                Armed a;
+                switch (ops.at(i) % 4)
+                {
+                case 0:  r = c->readHoldingRegisters(offset, 16, values); break;
+                case 1:  r = c->writeMultipleRegisters(offset, 16, values); break;
+                case 2:  r = c->readCoils(offset, 32, bits); break;
+                default: r = c->writeSingleCoil(offset, true); break;
+                }
+            }
+            if (Modbus::StatusIsProcessing(r))
+                continue;
+            if (Modbus::StatusIsBad(r))
+                errors++;
+            ops[i] += window;
+            if (++done == warmup)
+            {
+                allocs = s_allocs;
+                s_counting = true;
+            }
+        }
+        timer.start(1);
+        loop.processEvents(QEventLoop::WaitForMoreEvents);
+    }
+    s_counting = false;
+    allocs = s_allocs - allocs;
+    port->close();
+    delete port;
+
+    bool ok = !errors && !allocs;
+    printf("bench=alloc_protocol mode=tcp window=%d trace=%d requests=%d errors=%d traced_bytes=%llu allocs=%llu allocs_per_request=%.3f result=%s\n",
+           window, trace ? 1 : 0, requests, errors,
+           static_cast<unsigned long long>(traced),
+           static_cast<unsigned long long>(allocs),
+           static_cast<double>(allocs) / requests,
+           ok ? "ok" : "fail");
+    return ok;
+}
+
+static bool benchPoll(quint16 tcpPort, bool trace, int devices, int requests, int warmup)
+{
+    mbClient::global()->setLogFlags(trace ? (mb::Log_Error | mb::Log_TxRx) : mb::LogFlags(mb::Log_Error));
+    mbClientPort port;
+    port.setName(QStringLiteral("Port"));
+    port.setType(Modbus::TCP);
+    port.setHost(QStringLiteral("127.0.0.1"));
+    port.setPort(tcpPort);
+    port.setPipelineWindow(4);
+
+    // every device has 10 registers (the first one changes), float input and coils polled
+    // without period, so port is always busy; items are bound to the runtime the same way
+    // as 'mbClientRuntime::createComponents()' does
+    mbClientStats stats;
+    QList<mbClientDevice*> devs;
+    QList<mbClientDataViewItem*> items;
+    QList<mbClientRunItem*> runItems;
+    QList<mbClientRunDevice*> runDevices;
+    quint64 changes = 0;
+    for (int d = 0; d < devices; d++)
+    {
+        mbClientDevice *dev = new mbClientDevice;
+        dev->setName(QString("Device%1").arg(d+1));
+        dev->setUnit(1);
+        devs.append(dev);
+        QList<mbClientRunItem*> deviceItems;
+        for (int i = 0; i < 12; i++)
+        {
+            mbClientDataViewItem *item = new mbClientDataViewItem;
+            item->setDevice(dev);
+            item->setPeriod(0);
+            if (i < 10)
+                item->setAddress(Modbus::Memory_4x, static_cast<quint16>(i));
+            else if (i == 10)
+            {
+                item->setAddress(Modbus::Memory_3x, 0);
+                item->setFormat(mb::Float);
+            }
+            else
+                item->setAddress(Modbus::Memory_0x, 0);
+            if (i == 0)
+                QObject::connect(item, &mbClientDataViewItem::valueChanged, [&changes]() { changes++; });
+            item->update(mb::Status_MbInitializing, mb::currentTimestamp());
+            mbClientRunItem *ri = new mbClientRunItem(item->handle(), item->addressType(), item->addressOffset(),
+                                                      item->count(), item->period(), item->sizeOf());
+            items.append(item);
+            deviceItems.append(ri);
+        }
+        runItems.append(deviceItems);
+        mbClientRunDevice *rd = new mbClientRunDevice(dev->settings());
+        rd->setStats(stats.createDevice(port.name(), dev->name()));
+        rd->pushItemsToRead(deviceItems);
+        runDevices.append(rd);
+    }
+
+    quint64 done = 0, errors = 0, allocs = s_allocs;
+    {
+        // Note: loop is the same as 'mbClientRunThread::run()'
+        mbClientPortRunnable runnable(port.settings(), runDevices);
+        QEventLoop loop;
+        QTimer timer;
+        timer.setSingleShot(true);
+        timer.setTimerType(Qt::PreciseTimer);
+        QElapsedTimer elapsed;
+        elapsed.start();
+        bool counting = false;
+        while (done < static_cast<quint64>(warmup + requests) && elapsed.elapsed() < 60000)
+        {
+            Modbus::updateMonotonicTime();
+            loop.processEvents();
+            int timeout;
+            {
+                Armed a;
+                runnable.run();
+                timeout = runnable.idleTimeout();
+            }
+            done = 0;
+            errors = 0;
+            Q_FOREACH (mbClientRunDevice *rd, runDevices)
+            {
+                done += rd->stats()->total().requests;
+                errors += rd->stats()->total().requests - rd->stats()->total().good;
+            }
+            if (!counting && done >= static_cast<quint64>(warmup))
+            {
+                counting = true;
+                allocs = s_allocs;
+                s_counting = true;
+            }
+            if (timeout == 0)
+                continue;
+            if (timeout > 0)
+                timer.start(timeout);
+            else
+                timer.stop();
+            loop.processEvents(QEventLoop::WaitForMoreEvents);
+        }
+        s_counting = false;
+        allocs = s_allocs - allocs;
+        runnable.close();
+    }
+    qDeleteAll(runDevices);
+    qDeleteAll(runItems);
+    qDeleteAll(items);
+    qDeleteAll(devs);
+
+    quint64 measured = done > static_cast<quint64>(warmup) ? done - static_cast<quint64>(warmup) : 0;
+    bool ok = !errors && !allocs && (measured >= static_cast<quint64>(requests));
+    printf("bench=alloc_poll mode=tcp devices=%d trace=%d requests=%llu errors=%llu changes=%llu allocs=%llu allocs_per_request=%.3f result=%s\n",
+           devices, trace ? 1 : 0,
+           static_cast<unsigned long long>(measured),
+           static_cast<unsigned long long>(errors),
+           static_cast<unsigned long long>(changes),
+           static_cast<unsigned long long>(allocs),
+           measured ? static_cast<double>(allocs) / measured : 0.0,
+           ok ? "ok" : "fail");
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    AllocClient client;
+    // log lines and Tx/Rx trace are formatted by the logger thread but not printed
+    QObject::disconnect(client.logger(), &mbCoreLogger::signalMessages, &client, nullptr);
+    QObject::connect(client.logger(), &mbCoreLogger::signalMessages, [&client](const QStringList &) { client.logger()->confirmBatch(); });
+    QStringList args = app.arguments();
+    int requests = args.count() > 1 ? args.at(1).toInt() : 10000;
+    int warmup   = args.count() > 2 ? args.at(2).toInt() : 1000;
+    quint16 port = args.count() > 3 ? args.at(3).toUShort() : 15021;
+    if (requests < 1)
+        requests = 1;
+    if (warmup < 1)
+        warmup = 1;
+#ifndef __GLIBC__
+    printf("bench=alloc_protocol error=no_malloc_hook result=fail\n");
+    return 1;
+#endif
+
+    AllocServer server(port);
+    server.start();
+    while (!server.isReady() && !server.isFinished())
+        QThread::msleep(1);
+    if (!server.isReady())
+    {
+        server.wait();
+        printf("bench=alloc_protocol error=server_open result=fail\n");
+        return 1;
+    }
+
+    bool ok = true;
+    ok = bench(port, 1, false, requests, warmup) && ok;
+    ok = bench(port, 1, true , requests, warmup) && ok;
+    ok = bench(port, 4, false, requests, warmup) && ok;
+    ok = benchPoll(port, false, 1, requests, warmup) && ok;
+    ok = benchPoll(port, true , 1, requests, warmup) && ok;
+    ok = benchPoll(port, false, 4, requests, warmup) && ok;
+
+    server.stop();
+    server.wait();
+    client.logger()->stop();
+    client.logger()->takeBatch();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,12 @@
+TEMPLATE = subdirs
+
+CONFIG += ordered
+
+SUBDIRS += memoryblock \
+    runloop \
+    checksum \
+    hex \
+    micro \
+    loopback \
+    idletcp \
+    alloc
@@ -0,0 +1,125 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// Throughput of Modbus::crc16 and Modbus::lrc against previous bit-by-bit/byte-by-byte
+// implementations. Before measuring, results are checked to be bit-exact with previous
+// implementations for random buffers of every length up to given max size.
+//
+// Usage: bench_checksum [size] [milliseconds]
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+
+#include <Modbus.h>
+
+static uint16_t crc16_ref(const uint8_t *bytes, uint32_t count)
+{
+    uint16_t crc = 0xFFFF;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        crc ^= bytes[i];
+        for (uint32_t j = 0; j < 8; j++)
+        {
+            uint16_t temp = crc & 0x0001;
+            crc >>= 1;
+            if (temp) crc ^= 0xA001;
+        }
+    }
+    return crc;
+}
+
+static uint8_t lrc_ref(const uint8_t *bytes, uint32_t count)
+{
+    uint8_t lrc = 0x00;
+    for (; count; count--)
+        lrc += *bytes++;
+    return static_cast<uint8_t>(-static_cast<int8_t>(lrc));
+}
+
+// every length and every start alignment within 8 bytes
+static int verify(std::vector<uint8_t> &buff, int size)
+{
+    int mismatches = 0;
+    for (int pass = 0; pass < 4; pass++)
+    {
+        for (size_t i = 0; i < buff.size(); i++)
+            buff[i] = (pass == 3) ? 0xFF : static_cast<uint8_t>(rand());
+        for (int align = 0; align < 8; align++)
+        {
+            for (int len = 0; len <= size; len++)
+            {
+                const uint8_t *p = buff.data() + align;
+                if (Modbus::crc16(p, len) != crc16_ref(p, len))
+                    mismatches++;
+                if (Modbus::lrc(p, len) != lrc_ref(p, len))
+                    mismatches++;
+            }
+        }
+    }
+    return mismatches;
+}
+
+template <class T>
+static double measure(T func, const uint8_t *buff, int size, int duration)
+{
+    QElapsedTimer timer;
+    timer.start();
+    quint64 bytes = 0;
+    volatile unsigned sink = 0;
+    while (timer.elapsed() < duration)
+    {
+        for (int i = 0; i < 1000; i++)
+            sink = sink + func(buff, size);
+        bytes += static_cast<quint64>(size) * 1000;
+    }
+    return bytes / (timer.elapsed() / 1000.0) / (1024.0 * 1024.0);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+    int size     = args.count() > 1 ? args.at(1).toInt() : MB_RTU_IO_BUFF_SZ;
+    int duration = args.count() > 2 ? args.at(2).toInt() : 1000;
+    if (size < 1)
+        size = 1;
+
+    std::vector<uint8_t> buff(static_cast<size_t>(size) + 8);
+    int mismatches = verify(buff, size);
+
+    printf("bench=checksum func=crc16 size=%d ref_mb_per_sec=%.1f mb_per_sec=%.1f mismatches=%d\n",
+           size,
+           measure(crc16_ref, buff.data(), size, duration),
+           measure(Modbus::crc16, buff.data(), size, duration),
+           mismatches);
+    printf("bench=checksum func=lrc size=%d ref_mb_per_sec=%.1f mb_per_sec=%.1f mismatches=%d\n",
+           size,
+           measure(lrc_ref, buff.data(), size, duration),
+           measure(Modbus::lrc, buff.data(), size, duration),
+           mismatches);
+    return mismatches ? 1 : 0;
+}
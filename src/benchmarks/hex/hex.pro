@@ -0,0 +1,20 @@
+TEMPLATE = app
+
+TARGET = bench_hex
+
+CONFIG += console no_keywords
+CONFIG -= app_bundle
+
+DESTDIR  = ../../bin
+
+QT    = core
+
+unix:QMAKE_RPATHDIR += .
+
+INCLUDEPATH += . \
+    $$PWD/../../modbus
+
+SOURCES += \
+    main.cpp
+
+LIBS  += -L../../bin -lModbus
@@ -0,0 +1,155 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// Throughput of hex conversions used by ASCII port and Tx/Rx trace formatters
+// (Modbus::bytesToAscii, Modbus::asciiToBytes, Modbus::bytesToString) against
+// previous implementations for frames of different size. Results of new and
+// previous implementations are compared for every measured size.
+//
+// Usage: bench_hex [milliseconds] [size1 size2 ...]
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+
+#include <Modbus.h>
+
+static uint16_t bytesToAscii_ref(uint8_t* bytesBuff, uint8_t* asciiBuff, uint16_t count)
+{
+    uint16_t i, j, qAscii = 0;
+    uint8_t tmp;
+
+    for (i = 0; i < count; i++)
+    {
+        for (j = 0; j < 2; j++)
+        {
+            tmp = (bytesBuff[i] >> ((1 - j) * 4)) & 0x0F;
+            asciiBuff[i * 2 + j] = ((tmp < 10) ? (0x30 | tmp) : (55 + tmp));
+            qAscii++;
+        }
+    }
+    return qAscii;
+}
+
+static uint16_t asciiToBytes_ref(uint8_t* asciiBuff, uint8_t* bytesBuff, uint16_t count)
+{
+    uint16_t i, j, qBytes = 0;
+    uint8_t tmp;
+    for (i = 0; i < count; i++)
+    {
+        j = i & 1;
+        if (!j)
+        {
+            bytesBuff[i / 2] = 0;
+            qBytes++;
+        }
+        tmp = asciiBuff[i];
+        if ((tmp >= '0') && (tmp <= '9'))
+            tmp &= 0x0F;
+        else if ((tmp >= 'A') && (tmp <= 'F'))
+            tmp -= 55;
+        else
+            return 0;
+        bytesBuff[i / 2] |= tmp << (4 * (1 - j));
+    }
+    return qBytes;
+}
+
+static QString bytesToString_ref(const QByteArray& bytes)
+{
+    QString str;
+    for (int i = 0; i < bytes.count(); ++i)
+    {
+        uint8_t num = *reinterpret_cast<const uint8_t*>(&bytes.constData()[i]);
+        QString  c = QString::number(num, 16).toUpper();
+        if (c.length() == 1)
+            c = "0" + c;
+        str += c + " ";
+    }
+    return str;
+}
+
+// returns count of calls per second
+template <class T>
+static double measure(T func, int duration)
+{
+    QElapsedTimer timer;
+    timer.start();
+    quint64 calls = 0;
+    while (timer.elapsed() < duration)
+    {
+        for (int i = 0; i < 100; i++)
+            func();
+        calls += 100;
+    }
+    return calls / (timer.elapsed() / 1000.0);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+    int duration = args.count() > 1 ? args.at(1).toInt() : 500;
+    QList<int> sizes;
+    for (int i = 2; i < args.count(); i++)
+        sizes.append(args.at(i).toInt());
+    if (sizes.isEmpty())
+        sizes << 8 << 16 << 64 << 128 << 256 << 521;
+
+    int mismatches = 0;
+    Q_FOREACH (int size, sizes)
+    {
+        if (size < 1)
+            continue;
+        uint16_t sz = static_cast<uint16_t>(size);
+        QByteArray bytes(size, Qt::Uninitialized);
+        for (int i = 0; i < size; i++)
+            bytes[i] = static_cast<char>(rand());
+        uint8_t *data = reinterpret_cast<uint8_t*>(bytes.data());
+        std::vector<uint8_t> ascii(static_cast<size_t>(size) * 2), asciiRef(static_cast<size_t>(size) * 2);
+        std::vector<uint8_t> out(static_cast<size_t>(size)), outRef(static_cast<size_t>(size));
+
+        if ((Modbus::bytesToAscii(data, ascii.data(), sz) != bytesToAscii_ref(data, asciiRef.data(), sz)) || (ascii != asciiRef))
+            mismatches++;
+        if ((Modbus::asciiToBytes(ascii.data(), out.data(), sz * 2) != asciiToBytes_ref(ascii.data(), outRef.data(), sz * 2)) || (out != outRef))
+            mismatches++;
+        if (Modbus::bytesToString(bytes) != bytesToString_ref(bytes))
+            mismatches++;
+
+        double encRef = measure([&]() { bytesToAscii_ref(data, asciiRef.data(), sz); }, duration);
+        double enc    = measure([&]() { Modbus::bytesToAscii(data, ascii.data(), sz); }, duration);
+        double decRef = measure([&]() { asciiToBytes_ref(ascii.data(), outRef.data(), sz * 2); }, duration);
+        double dec    = measure([&]() { Modbus::asciiToBytes(ascii.data(), out.data(), sz * 2); }, duration);
+        double strRef = measure([&]() { bytesToString_ref(bytes); }, duration);
+        double str    = measure([&]() { Modbus::bytesToString(bytes); }, duration);
+
+        printf("bench=hex func=bytesToAscii size=%d ref_calls_per_sec=%.0f calls_per_sec=%.0f\n" , size, encRef, enc);
+        printf("bench=hex func=asciiToBytes size=%d ref_calls_per_sec=%.0f calls_per_sec=%.0f\n" , size, decRef, dec);
+        printf("bench=hex func=bytesToString size=%d ref_calls_per_sec=%.0f calls_per_sec=%.0f\n", size, strRef, str);
+    }
+    printf("bench=hex mismatches=%d\n", mismatches);
+    return mismatches ? 1 : 0;
+}
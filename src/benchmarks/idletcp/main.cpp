@@ -0,0 +1,154 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+// CPU usage of TCP server port against the number of mostly idle connections.
+// In-process LoadServer (see src/loadgen) serves N client connections, every connection sends
+// one request per given period, so server port spends most of the time waiting. Mode 'polling'
+// is previous server loop (every connection is polled each cycle), 'event' is event-driven
+// ServerTCP (only connections with pending data are processed).
+// Every mode and number of connections prints one line with process CPU % (all threads,
+// both server and clients), so the cost of idle connection can be compared between modes.
+// Run fails if any request failed or configured CPU budget is exceeded.
+//
+// Usage: bench_idletcp [-mode polling|event|all] [-connections <n1,n2,...>] [-duration <seconds>]
+//                      [-period <ms>] [-port <tcp port>] [-max-cpu <percent>]
+
+#include <cstdio>
+#include <ctime>
+
+#include <QCoreApplication>
+
+#include <ModbusPortTCP.h>
+#include <ModbusServerTCP.h>
+
+#include "loadgen.h"
+
+static double cpuTime()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool bench(const char *mode, bool eventDriven, int connections, quint16 port, int period, LoadGenerator::Settings s, double maxCpu)
+{
+    const Modbus::ServerTCP::Strings &ss = Modbus::ServerTCP::Strings::instance();
+    const Modbus::PortTCP::Strings &sc = Modbus::PortTCP::Strings::instance();
+    Modbus::Settings server;
+    server[sc.type] = Modbus::enumKey(Modbus::TCP);
+    server[ss.port] = port;
+    server[ss.eventDriven] = eventDriven;
+    LoadServer srv(server);
+    srv.start();
+    while (!srv.isReady() && !srv.isFinished())
+        QThread::msleep(1);
+    if (!srv.isReady())
+    {
+        srv.wait();
+        printf("bench=idletcp mode=%s connections=%d error=server_open budget=fail\n", mode, connections);
+        return false;
+    }
+
+    s.port[sc.type] = Modbus::enumKey(Modbus::TCP);
+    s.port[sc.host] = QStringLiteral("127.0.0.1");
+    s.port[sc.port] = port;
+    s.port[sc.timeout] = s.timeout;
+    s.connections = connections;
+    s.concurrency = 1;
+    s.rate = 1000.0 * connections / period;
+    LoadGenerator gen(s);
+    double cpu = cpuTime();
+    LoadGenerator::Result r = gen.run();
+    cpu = cpuTime() - cpu;
+    srv.stop();
+    srv.wait();
+
+    double cpuPercent = r.seconds > 0 ? cpu * 100.0 / r.seconds : 0.0;
+    bool ok = r.good && !r.errors && (maxCpu <= 0 || cpuPercent <= maxCpu);
+    printf("bench=idletcp mode=%s connections=%d period_ms=%d seconds=%.3f frames=%llu errors=%llu "
+           "cpu_percent=%.2f cpu_percent_per_100=%.3f p99_us=%llu budget=%s\n",
+           mode, connections, period, r.seconds,
+           static_cast<unsigned long long>(r.good),
+           static_cast<unsigned long long>(r.errors),
+           cpuPercent, cpuPercent * 100.0 / connections,
+           static_cast<unsigned long long>(r.latency.percentile(99)),
+           ok ? "ok" : "fail");
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+    LoadGenerator::Settings s;
+    s.duration = 5000;
+    QString mode = QStringLiteral("all");
+    QList<int> connections = QList<int>() << 1 << 10 << 100 << 250;
+    quint16 port = 15021;
+    int period = 1000;
+    double maxCpu = 0;
+    bool ok = true;
+    for (int i = 1; ok && i + 1 < args.count(); i += 2)
+    {
+        const QString &a = args.at(i);
+        const QString &v = args.at(i+1);
+        if      (a == QStringLiteral("-mode"    )) mode = v;
+        else if (a == QStringLiteral("-duration")) s.duration = static_cast<int>(v.toDouble(&ok) * 1000);
+        else if (a == QStringLiteral("-period"  )) period = v.toInt(&ok);
+        else if (a == QStringLiteral("-port"    )) port = v.toUShort(&ok);
+        else if (a == QStringLiteral("-max-cpu" )) maxCpu = v.toDouble(&ok);
+        else if (a == QStringLiteral("-connections"))
+        {
+            connections.clear();
+            const QStringList ls = v.split(QLatin1Char(','));
+            for (int j = 0; ok && j < ls.count(); j++)
+            {
+                int n = ls.at(j).trimmed().toInt(&ok);
+                if (n < 1)
+                    ok = false;
+                connections.append(n);
+            }
+        }
+        else
+            ok = false;
+    }
+    const QStringList modes = QStringList() << QStringLiteral("polling") << QStringLiteral("event") << QStringLiteral("all");
+    if (!modes.contains(mode))
+        ok = false;
+    if (!ok || (args.count() % 2) == 0 || s.duration <= 0 || period <= 0 || connections.isEmpty())
+    {
+        fprintf(stderr, "Usage: bench_idletcp [-mode polling|event|all] [-connections <n1,n2,...>] [-duration <seconds>] "
+                        "[-period <ms>] [-port <tcp port>] [-max-cpu <percent>]\n");
+        return 2;
+    }
+
+    bool res = true;
+    for (int i = 0; i < connections.count(); i++)
+    {
+        // Note: every connection takes 2 descriptors in this process (client and server side)
+        if (mode == QStringLiteral("polling") || mode == QStringLiteral("all"))
+            res = bench("polling", false, connections.at(i), port, period, s, maxCpu) && res;
+        if (mode == QStringLiteral("event") || mode == QStringLiteral("all"))
+            res = bench("event", true, connections.at(i), port, period, s, maxCpu) && res;
+    }
+    return res ? 0 : 1;
+}
@@ -0,0 +1,25 @@
+TEMPLATE = app
+
+TARGET = bench_loopback
+
+CONFIG += console no_keywords
+CONFIG -= app_bundle
+
+DESTDIR  = ../../bin
+
+QT    = core network serialport
+
+unix:QMAKE_RPATHDIR += .
+
+INCLUDEPATH += . \
+    $$PWD/../../modbus \
+    $$PWD/../../loadgen
+
+HEADERS += \
+    $$PWD/../../loadgen/loadgen.h
+
+SOURCES += \
+    $$PWD/../../loadgen/loadgen.cpp \
+    main.cpp
+
+LIBS  += -L../../bin -lModbus
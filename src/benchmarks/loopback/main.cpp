@@ -0,0 +1,307 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+// End-to-end loopback throughput of Modbus::ClientPort against in-process Modbus server
+// (LoadServer with memory device, see src/loadgen): TCP over 127.0.0.1, RTU and ASCII
+// over pair of pseudo terminals connected by relay thread (Unix only).
+// Every mode prints one line with frames/s, CPU time per frame (all threads of the process)
+// and latency percentiles. Mode fails if any request failed or configured budget is exceeded,
+// so exit code can be used by regression checks.
+//
+// Mode 'rtu-precise' is RTU with t3.5 frame delimiting and early frame end by expected size.
+//
+// Usage: bench_loopback [-mode tcp|rtu|rtu-precise|asc|all] [-duration <seconds>] [-concurrency <n>]
+//                       [-count <registers>] [-port <tcp port>]
+//                       [-min-fps <frames/s>] [-max-p99 <us>] [-max-cpu <us per frame>]
+
+#include <atomic>
+#include <cstdio>
+#include <ctime>
+
+#include <QCoreApplication>
+
+#include <ModbusPortTCP.h>
+#include <ModbusPortRTU.h>
+#include <ModbusServerTCP.h>
+
+#include "loadgen.h"
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+// Two pseudo terminals, bytes written to the slave of one are passed to the slave of another
+class PtyRelay : public QThread
+{
+public:
+    PtyRelay() : m_ctrlRun(true)
+    {
+        for (int i = 0; i < 2; i++)
+        {
+            m_master[i] = -1;
+            m_slave[i] = -1;
+        }
+    }
+
+    ~PtyRelay()
+    {
+        for (int i = 0; i < 2; i++)
+        {
+            if (m_master[i] >= 0)
+                ::close(m_master[i]);
+            if (m_slave[i] >= 0)
+                ::close(m_slave[i]);
+        }
+    }
+
+public:
+    bool open()
+    {
+        for (int i = 0; i < 2; i++)
+        {
+            m_master[i] = posix_openpt(O_RDWR | O_NOCTTY);
+            if (m_master[i] < 0 || grantpt(m_master[i]) || unlockpt(m_master[i]))
+                return false;
+            m_name[i] = QString::fromLocal8Bit(ptsname(m_master[i]));
+            // keep slave opened so master doesn't get hang up while serial port is closed
+            m_slave[i] = ::open(ptsname(m_master[i]), O_RDWR | O_NOCTTY);
+            if (m_slave[i] < 0)
+                return false;
+            struct termios t;
+            if (tcgetattr(m_slave[i], &t))
+                return false;
+            cfmakeraw(&t);
+            tcsetattr(m_slave[i], TCSANOW, &t);
+        }
+        return true;
+    }
+
+    inline QString name(int i) const { return m_name[i]; }
+
+    void stop() { m_ctrlRun = false; }
+
+protected:
+    void run() override
+    {
+        char buff[1024];
+        struct pollfd fds[2];
+        for (int i = 0; i < 2; i++)
+        {
+            fds[i].fd = m_master[i];
+            fds[i].events = POLLIN;
+        }
+        while (m_ctrlRun)
+        {
+            if (poll(fds, 2, 100) <= 0)
+                continue;
+            for (int i = 0; i < 2; i++)
+            {
+                if (!(fds[i].revents & POLLIN))
+                    continue;
+                ssize_t c = ::read(m_master[i], buff, sizeof(buff));
+                for (ssize_t w = 0; c > 0 && w < c; )
+                {
+                    ssize_t r = ::write(m_master[1-i], buff + w, static_cast<size_t>(c - w));
+                    if (r <= 0)
+                        break;
+                    w += r;
+                }
+            }
+        }
+    }
+
+private:
+    std::atomic<bool> m_ctrlRun;
+    int m_master[2];
+    int m_slave[2];
+    QString m_name[2];
+};
+#endif // Q_OS_UNIX
+
+struct Budget
+{
+    double minFps;  // 0 - no limit
+    quint64 maxP99; // microseconds, 0 - no limit
+    double maxCpu;  // microseconds per frame, 0 - no limit
+};
+
+static double cpuTime()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool bench(const char *mode, const Modbus::Settings &server, const Modbus::Settings &client, LoadGenerator::Settings s, const Budget &budget)
+{
+    LoadServer srv(server);
+    srv.start();
+    while (!srv.isReady() && !srv.isFinished())
+        QThread::msleep(1);
+    if (!srv.isReady())
+    {
+        srv.wait();
+        printf("bench=loopback mode=%s error=server_open budget=fail\n", mode);
+        return false;
+    }
+
+    s.port = client;
+    LoadGenerator gen(s);
+    double cpu = cpuTime();
+    LoadGenerator::Result r = gen.run();
+    cpu = cpuTime() - cpu;
+    srv.stop();
+    srv.wait();
+
+    double fps = r.seconds > 0 ? r.good / r.seconds : 0.0;
+    double cpuPerFrame = r.good ? cpu * 1e6 / r.good : 0.0;
+    quint64 p99 = r.latency.percentile(99);
+    bool ok = r.good && !r.errors &&
+              (budget.minFps <= 0 || fps >= budget.minFps) &&
+              (!budget.maxP99 || p99 <= budget.maxP99) &&
+              (budget.maxCpu <= 0 || cpuPerFrame <= budget.maxCpu);
+    printf("bench=loopback mode=%s concurrency=%d count=%u seconds=%.3f frames=%llu errors=%llu fps=%.1f cpu_us_per_frame=%.2f "
+           "p50_us=%llu p99_us=%llu p999_us=%llu max_us=%llu budget=%s\n",
+           mode, s.concurrency, static_cast<unsigned>(s.count), r.seconds,
+           static_cast<unsigned long long>(r.good),
+           static_cast<unsigned long long>(r.errors),
+           fps, cpuPerFrame,
+           static_cast<unsigned long long>(r.latency.percentile(50)),
+           static_cast<unsigned long long>(p99),
+           static_cast<unsigned long long>(r.latency.percentile(99.9)),
+           static_cast<unsigned long long>(r.latency.max()),
+           ok ? "ok" : "fail");
+    return ok;
+}
+
+#ifdef Q_OS_UNIX
+static bool benchSerial(const char *mode, Modbus::Type type, bool precise, const LoadGenerator::Settings &s, const Budget &budget)
+{
+    PtyRelay relay;
+    if (!relay.open())
+    {
+        printf("bench=loopback mode=%s error=pty_open budget=fail\n", mode);
+        return false;
+    }
+    relay.start();
+    const Modbus::PortSerial::Strings &ss = Modbus::PortSerial::Strings::instance();
+    Modbus::Settings server;
+    server[ss.type] = Modbus::enumKey(type);
+    server[ss.baudRate] = 115200;
+    server[ss.timeoutFirstByte] = s.timeout;
+    server[ss.timeoutInterByte] = 1; // frame end is detected by inter-byte silence
+    if (precise)
+    {
+        const Modbus::PortRTU::Strings &sr = Modbus::PortRTU::Strings::instance();
+        server[sr.preciseFraming] = true;
+        server[sr.earlyFrameEnd] = true;
+    }
+    Modbus::Settings client = server;
+    server[ss.serialPortName] = relay.name(0);
+    client[ss.serialPortName] = relay.name(1);
+    bool ok = bench(mode, server, client, s, budget);
+    relay.stop();
+    relay.wait();
+    return ok;
+}
+#endif // Q_OS_UNIX
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+    LoadGenerator::Settings s;
+    s.duration = 3000;
+    s.count = 10;
+    Budget budget = { 0, 0, 0 };
+    QString mode = QStringLiteral("all");
+    quint16 port = 15020;
+    bool ok = true;
+    for (int i = 1; ok && i + 1 < args.count(); i += 2)
+    {
+        const QString &a = args.at(i);
+        const QString &v = args.at(i+1);
+        if      (a == QStringLiteral("-mode"       )) mode = v;
+        else if (a == QStringLiteral("-duration"   )) s.duration = static_cast<int>(v.toDouble(&ok) * 1000);
+        else if (a == QStringLiteral("-concurrency")) s.concurrency = v.toInt(&ok);
+        else if (a == QStringLiteral("-count"      )) s.count = v.toUShort(&ok);
+        else if (a == QStringLiteral("-port"       )) port = v.toUShort(&ok);
+        else if (a == QStringLiteral("-min-fps"    )) budget.minFps = v.toDouble(&ok);
+        else if (a == QStringLiteral("-max-p99"    )) budget.maxP99 = v.toULongLong(&ok);
+        else if (a == QStringLiteral("-max-cpu"    )) budget.maxCpu = v.toDouble(&ok);
+        else
+            ok = false;
+    }
+    const QStringList modes = QStringList() << QStringLiteral("tcp") << QStringLiteral("rtu") << QStringLiteral("rtu-precise")
+                                            << QStringLiteral("asc") << QStringLiteral("all");
+    if (!modes.contains(mode))
+        ok = false;
+    if (!ok || (args.count() % 2) == 0 || s.duration <= 0 || s.concurrency < 1)
+    {
+        fprintf(stderr, "Usage: bench_loopback [-mode tcp|rtu|rtu-precise|asc|all] [-duration <seconds>] [-concurrency <n>] [-count <registers>] "
+                        "[-port <tcp port>] [-min-fps <frames/s>] [-max-p99 <us>] [-max-cpu <us per frame>]\n");
+        return 2;
+    }
+    s.range = static_cast<uint16_t>(s.count * 10);
+
+    bool res = true;
+    if (mode == QStringLiteral("tcp") || mode == QStringLiteral("all"))
+    {
+        const Modbus::ServerTCP::Strings &ss = Modbus::ServerTCP::Strings::instance();
+        const Modbus::PortTCP::Strings &sc = Modbus::PortTCP::Strings::instance();
+        Modbus::Settings server;
+        server[sc.type] = Modbus::enumKey(Modbus::TCP);
+        server[ss.port] = port;
+        server[ss.eventDriven] = true;
+        Modbus::Settings client;
+        client[sc.type] = Modbus::enumKey(Modbus::TCP);
+        client[sc.host] = QStringLiteral("127.0.0.1");
+        client[sc.port] = port;
+        client[sc.timeout] = s.timeout;
+        res = bench("tcp", server, client, s, budget) && res;
+    }
+#ifdef Q_OS_UNIX
+    // Note: serial ports are not pipelined, so concurrency doesn't affect RTU and ASCII
+    if (mode == QStringLiteral("rtu") || mode == QStringLiteral("all"))
+        res = benchSerial("rtu", Modbus::RTU, false, s, budget) && res;
+    if (mode == QStringLiteral("rtu-precise") || mode == QStringLiteral("all"))
+        res = benchSerial("rtu-precise", Modbus::RTU, true, s, budget) && res;
+    if (mode == QStringLiteral("asc") || mode == QStringLiteral("all"))
+        res = benchSerial("asc", Modbus::ASC, false, s, budget) && res;
+#else
+    // Note: serial modes need pseudo-terminals, explicitly requested one fails, 'all' just skips them
+    const char *serialModes[] = { "rtu", "rtu-precise", "asc" };
+    for (const char *m : serialModes)
+    {
+        if (mode == QLatin1String(m) || mode == QStringLiteral("all"))
+        {
+            printf("bench=loopback mode=%s skipped: unsupported on this platform\n", m);
+            if (mode != QStringLiteral("all"))
+                res = false;
+        }
+    }
+#endif // Q_OS_UNIX
+    return res ? 0 : 1;
+}
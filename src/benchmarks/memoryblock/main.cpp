@@ -0,0 +1,105 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// Contention benchmark for mbServerDevice memory: N reader threads against 1 writer thread.
+// Writer fills whole register range with the same value, so every reader's snapshot must
+// contain equal registers, otherwise it's counted as torn read.
+//
+// Usage: bench_memoryblock [readers] [milliseconds] [registers]
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+
+#include <project/server_device.h>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+    int readers   = args.count() > 1 ? args.at(1).toInt() : 4;
+    int duration  = args.count() > 2 ? args.at(2).toInt() : 2000;
+    int registers = args.count() > 3 ? args.at(3).toInt() : MB_MAX_REGISTERS;
+    if (readers < 1)
+        readers = 1;
+    if ((registers < 1) || (registers > MB_MAX_REGISTERS))
+        registers = MB_MAX_REGISTERS;
+
+    mbServerDevice device;
+    std::atomic<bool> run(true);
+    std::atomic<quint64> reads(0);
+    std::atomic<quint64> torn(0);
+    quint64 writes = 0;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < readers; i++)
+    {
+        threads.emplace_back([&]()
+        {
+            quint16 values[MB_MAX_REGISTERS];
+            quint64 c = 0, t = 0;
+            while (run.load(std::memory_order_relaxed))
+            {
+                device.read_4x(0, registers, values);
+                for (int r = 1; r < registers; r++)
+                {
+                    if (values[r] != values[0])
+                    {
+                        t++;
+                        break;
+                    }
+                }
+                c++;
+            }
+            reads += c;
+            torn += t;
+        });
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    quint16 values[MB_MAX_REGISTERS];
+    while (timer.elapsed() < duration)
+    {
+        quint16 v = static_cast<quint16>(writes);
+        for (int r = 0; r < registers; r++)
+            values[r] = v;
+        device.write_4x(0, registers, values);
+        writes++;
+    }
+    run = false;
+    for (std::thread &t : threads)
+        t.join();
+    double sec = timer.elapsed() / 1000.0;
+
+    printf("bench=memoryblock readers=%d registers=%d seconds=%.3f reads_per_sec=%.0f writes_per_sec=%.0f torn=%llu\n",
+           readers, registers, sec,
+           reads.load() / sec,
+           writes / sec,
+           static_cast<unsigned long long>(torn.load()));
+    return torn.load() ? 1 : 0;
+}
@@ -0,0 +1,29 @@
+TEMPLATE = app
+
+TARGET = bench_memoryblock
+
+CONFIG += console no_keywords
+CONFIG -= app_bundle
+
+DESTDIR  = ../../bin
+
+QT    = core gui widgets serialport xml
+
+unix:QMAKE_RPATHDIR += .
+
+INCLUDEPATH += . \
+    $$PWD/../../modbus \
+    $$PWD/../../core/sdk \
+    $$PWD/../../core/core \
+    $$PWD/../../core \
+    $$PWD/../../server
+
+HEADERS += \
+    $$PWD/../../server/project/server_device.h
+
+SOURCES += \
+    $$PWD/../../server/project/server_device.cpp \
+    main.cpp
+
+LIBS  += -L../../bin -lcore
+LIBS  += -L../../bin -lModbus
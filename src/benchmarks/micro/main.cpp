@@ -0,0 +1,271 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+// Per-call cost of modbus library hot paths: checksums, hex conversions, bit macros,
+// server request parsing/response building for every function code, server device
+// memory reads and value conversions for every format.
+// Every case prints one line: bench=micro case=<name> ns_per_call=<ns> calls=<count>
+//
+// Usage: bench_micro [milliseconds per case] [case name filter]
+
+#include <cstdio>
+#include <cstring>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+
+#include <ModbusServerPort.h>
+
+#include <mbcore.h>
+#include <project/server_device.h>
+
+// Exposes protected request/response processing of the server port
+class BenchServerPort : public Modbus::ServerPort
+{
+public:
+    BenchServerPort() : Modbus::ServerPort(nullptr, nullptr) {}
+
+public:
+    inline Modbus::StatusCode input(uint8_t func, const uint8_t *buff, uint16_t sz) { m_func = func; return processInputData(buff, sz); }
+    inline Modbus::StatusCode output(uint8_t *buff, uint16_t &sz) { return processOutputData(buff, sz); }
+};
+
+static int s_duration = 200;
+static QString s_filter;
+static volatile unsigned s_sink = 0;
+
+template <class T>
+static void measure(const QString &name, T func)
+{
+    if (!s_filter.isEmpty() && !name.contains(s_filter))
+        return;
+    const int batch = 1000;
+    for (int i = 0; i < batch; i++) // warm up
+        func();
+    QElapsedTimer timer;
+    timer.start();
+    quint64 calls = 0;
+    while (timer.elapsed() < s_duration)
+    {
+        for (int i = 0; i < batch; i++)
+            func();
+        calls += batch;
+    }
+    qint64 ns = timer.nsecsElapsed();
+    printf("bench=micro case=%s ns_per_call=%.2f calls=%llu\n",
+           qPrintable(name),
+           static_cast<double>(ns) / calls,
+           static_cast<unsigned long long>(calls));
+}
+
+static void benchChecksum()
+{
+    uint8_t buff[MB_MAX_BYTES+8];
+    for (size_t i = 0; i < sizeof(buff); i++)
+        buff[i] = static_cast<uint8_t>(i * 7);
+    const int sizes[] = { 8, MB_MAX_BYTES };
+    for (int size : sizes)
+    {
+        measure(QString("crc16/%1").arg(size), [&]() { s_sink = s_sink + Modbus::crc16(buff, size); });
+        measure(QString("lrc/%1"  ).arg(size), [&]() { s_sink = s_sink + Modbus::lrc  (buff, size); });
+    }
+}
+
+static void benchHex()
+{
+    uint8_t bytes[MB_MAX_BYTES];
+    uint8_t ascii[MB_MAX_BYTES*2];
+    for (size_t i = 0; i < sizeof(bytes); i++)
+        bytes[i] = static_cast<uint8_t>(i * 13);
+    const int sizes[] = { 8, MB_MAX_BYTES };
+    for (int size : sizes)
+    {
+        uint16_t sz = static_cast<uint16_t>(size);
+        measure(QString("bytesToAscii/%1").arg(size), [&]() { s_sink = s_sink + Modbus::bytesToAscii(bytes, ascii, sz); });
+        Modbus::bytesToAscii(bytes, ascii, sz);
+        measure(QString("asciiToBytes/%1").arg(size), [&]() { s_sink = s_sink + Modbus::asciiToBytes(ascii, bytes, static_cast<uint16_t>(sz*2)); });
+    }
+}
+
+static void benchBits()
+{
+    uint8_t bits[MB_MAX_DISCRETS/8+1];
+    bool bools[MB_MAX_DISCRETS];
+    memset(bits, 0x5A, sizeof(bits));
+    const int counts[] = { 16, MB_MAX_DISCRETS };
+    for (int count : counts)
+    {
+        uint16_t c = static_cast<uint16_t>(count);
+        measure(QString("GET_BITS/%1").arg(count), [&]() { GET_BITS(bits, 3, c, bools); s_sink = s_sink + bools[c-1]; });
+        measure(QString("SET_BITS/%1").arg(count), [&]() { SET_BITS(bits, 3, c, bools); s_sink = s_sink + bits[0]; });
+    }
+}
+
+static void benchServerPort()
+{
+    struct Request
+    {
+        uint8_t func;
+        uint8_t buff[MB_MAX_BYTES+5];
+        uint16_t sz;
+    };
+
+    const uint16_t regs = MB_MAX_REGISTERS;
+    const uint16_t discs = MB_MAX_DISCRETS;
+    Request reqs[9];
+    memset(reqs, 0, sizeof(reqs));
+    const uint8_t funcs[] = { MBF_READ_COILS, MBF_READ_DISCRETE_INPUTS, MBF_READ_HOLDING_REGISTERS, MBF_READ_INPUT_REGISTERS,
+                              MBF_WRITE_SINGLE_COIL, MBF_WRITE_SINGLE_REGISTER, MBF_READ_EXCEPTION_STATUS,
+                              MBF_WRITE_MULTIPLE_COILS, MBF_WRITE_MULTIPLE_REGISTERS };
+    for (int i = 0; i < 9; i++)
+    {
+        Request &r = reqs[i];
+        r.func = funcs[i];
+        uint16_t count = 0;
+        switch (r.func)
+        {
+        case MBF_READ_COILS:
+        case MBF_READ_DISCRETE_INPUTS:
+        case MBF_WRITE_MULTIPLE_COILS:
+            count = discs;
+            break;
+        case MBF_READ_HOLDING_REGISTERS:
+        case MBF_READ_INPUT_REGISTERS:
+        case MBF_WRITE_MULTIPLE_REGISTERS:
+            count = regs;
+            break;
+        case MBF_WRITE_SINGLE_COIL:
+            count = 0xFF00; // value ON
+            break;
+        case MBF_WRITE_SINGLE_REGISTER:
+            count = 0x1234; // value
+            break;
+        }
+        r.buff[0] = 0;
+        r.buff[1] = 0;
+        r.buff[2] = static_cast<uint8_t>(count >> 8);
+        r.buff[3] = static_cast<uint8_t>(count);
+        r.sz = 4;
+        switch (r.func)
+        {
+        case MBF_READ_EXCEPTION_STATUS:
+            r.sz = 0;
+            break;
+        case MBF_WRITE_MULTIPLE_COILS:
+            r.buff[4] = static_cast<uint8_t>((count+7)/8);
+            r.sz = static_cast<uint16_t>(5 + r.buff[4]);
+            break;
+        case MBF_WRITE_MULTIPLE_REGISTERS:
+            r.buff[4] = static_cast<uint8_t>(count*2);
+            r.sz = static_cast<uint16_t>(5 + r.buff[4]);
+            break;
+        }
+    }
+
+    BenchServerPort port;
+    uint8_t out[MB_MAX_BYTES+5];
+    for (int i = 0; i < 9; i++)
+    {
+        const Request &r = reqs[i];
+        measure(QString("processInputData/%1").arg(r.func), [&]() { s_sink = s_sink + port.input(r.func, r.buff, r.sz); });
+        if (!Modbus::StatusIsGood(port.input(r.func, r.buff, r.sz)))
+            printf("bench=micro case=processInputData/%d error=not_correct_request\n", r.func);
+        uint16_t sz = 0;
+        measure(QString("processOutputData/%1").arg(r.func), [&]() { s_sink = s_sink + port.output(out, sz) + sz; });
+    }
+}
+
+static void benchServerDevice()
+{
+    mbServerDevice device;
+    quint16 values[MB_MAX_REGISTERS];
+    uint8_t bits[MB_MAX_DISCRETS/8+1];
+    const uint counts4x[] = { 1, 10, MB_MAX_REGISTERS };
+    for (uint count : counts4x)
+        measure(QString("read_4x/%1").arg(count), [&]() { s_sink = s_sink + device.read_4x(0, count, values) + values[0]; });
+    const uint counts0x[] = { 1, 16, MB_MAX_DISCRETS };
+    for (uint count : counts0x)
+        measure(QString("readBits/%1").arg(count), [&]() { s_sink = s_sink + device.read_0x(3, count, bits) + bits[0]; });
+}
+
+static void benchConvert()
+{
+    const QString separator = QStringLiteral(" ");
+    const int varLength = 16;
+    for (int f = mb::Bool; f <= mb::String; f++)
+    {
+        mb::Format format = static_cast<mb::Format>(f);
+        int sz;
+        switch (format)
+        {
+        case mb::Bool:
+        case mb::Bin16: case mb::Oct16: case mb::Dec16: case mb::UDec16: case mb::Hex16:
+            sz = 2;
+            break;
+        case mb::Bin32: case mb::Oct32: case mb::Dec32: case mb::UDec32: case mb::Hex32:
+        case mb::Float:
+            sz = 4;
+            break;
+        case mb::ByteArray:
+        case mb::String:
+            sz = varLength;
+            break;
+        default:
+            sz = 8;
+            break;
+        }
+        QByteArray data(sz, '\0');
+        for (int i = 0; i < sz; i++)
+            data[i] = static_cast<char>('A' + i);
+        QString key = mb::enumKey(format);
+        QVariant v;
+        measure(QString("toVariant/%1").arg(key), [&]()
+        {
+            v = mb::toVariant(data, format, Modbus::Memory_4x, mb::LessSignifiedFirst, mb::LessSignifiedFirst,
+                              mb::Hex, mb::Utf8, mb::ZerroEnded, separator, varLength);
+        });
+        measure(QString("toByteArray/%1").arg(key), [&]()
+        {
+            QByteArray b = mb::toByteArray(v, format, Modbus::Memory_4x, mb::LessSignifiedFirst, mb::LessSignifiedFirst,
+                                           mb::Hex, mb::Utf8, mb::ZerroEnded, separator, varLength);
+            s_sink = s_sink + static_cast<unsigned>(b.size());
+        });
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+    s_duration = args.count() > 1 ? args.at(1).toInt() : 200;
+    s_filter   = args.count() > 2 ? args.at(2) : QString();
+    if (s_duration < 1)
+        s_duration = 1;
+
+    benchChecksum();
+    benchHex();
+    benchBits();
+    benchServerPort();
+    benchServerDevice();
+    benchConvert();
+    return 0;
+}
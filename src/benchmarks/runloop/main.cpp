@@ -0,0 +1,207 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+// CPU usage of client runtime threads against the number of ports.
+// Every port is real mbClientRunThread (mbClientPortRunnable with its mbClientDeviceRunnable's)
+// connected over 127.0.0.1 to in-process LoadServer (event-driven ServerTCP), every device
+// is idle: few registers polled with given period. So the numbers include everything the
+// thread does while it's idle: sleeping until the next poll is on duty, waking up on socket
+// data and every 'mbClientDeviceRunnable::IoCheckPeriod' while request is in flight.
+// CPU is of the whole process (run threads, server thread and logger thread).
+//
+// Usage: bench_runloop [ports] [milliseconds] [period] [devices per port] [tcp port]
+
+#include <cstdio>
+#include <ctime>
+
+#include <QCoreApplication>
+#include <QThread>
+#include <QElapsedTimer>
+
+#include <ModbusPortTCP.h>
+#include <ModbusServerTCP.h>
+
+#include <client.h>
+#include <project/client_port.h>
+#include <project/client_device.h>
+#include <project/client_dataview.h>
+#include <runtime/client_runtime.h>
+#include <runtime/client_rundevice.h>
+#include <runtime/client_runitem.h>
+#include <runtime/client_runthread.h>
+#include <runtime/client_stats.h>
+
+#include "loadgen.h"
+
+// Client application core without UI: data view items check up the state of its runtime
+class RunLoopClient : public mbClient
+{
+public:
+    RunLoopClient() { m_runtime = new mbClientRuntime(this); }
+};
+
+static double cpuTime()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool bench(int ports, int devices, int duration, int period, quint16 tcpPort)
+{
+    const Modbus::ServerTCP::Strings &ss = Modbus::ServerTCP::Strings::instance();
+    const Modbus::PortTCP::Strings &sc = Modbus::PortTCP::Strings::instance();
+    Modbus::Settings server;
+    server[sc.type] = Modbus::enumKey(Modbus::TCP);
+    server[ss.port] = tcpPort;
+    server[ss.eventDriven] = true;
+    LoadServer srv(server);
+    srv.start();
+    while (!srv.isReady() && !srv.isFinished())
+        QThread::msleep(1);
+    if (!srv.isReady())
+    {
+        srv.wait();
+        printf("bench=runloop error=server_open\n");
+        return false;
+    }
+
+    // items are bound to the runtime the same way as 'mbClientRuntime::createComponents()' does
+    mbClientStats stats;
+    QList<mbClientDevice*> devs;
+    QList<mbClientDataViewItem*> items;
+    QList<mbClientRunItem*> runItems;
+    QList<mbClientRunDevice*> runDevices;
+    QList<mbClientRunThread*> threads;
+    for (int p = 0; p < ports; p++)
+    {
+        mbClientPort port;
+        port.setName(QString("Port%1").arg(p+1));
+        port.setType(Modbus::TCP);
+        port.setHost(QStringLiteral("127.0.0.1"));
+        port.setPort(tcpPort);
+        QList<mbClientRunDevice*> portDevices;
+        for (int d = 0; d < devices; d++)
+        {
+            mbClientDevice *dev = new mbClientDevice;
+            dev->setName(QString("Port%1.Device%2").arg(p+1).arg(d+1));
+            dev->setUnit(1);
+            devs.append(dev);
+            QList<mbClientRunItem*> deviceItems;
+            for (int i = 0; i < 4; i++)
+            {
+                mbClientDataViewItem *item = new mbClientDataViewItem;
+                item->setDevice(dev);
+                item->setPeriod(period);
+                item->setAddress(Modbus::Memory_4x, static_cast<quint16>(d * 10 + i));
+                item->update(mb::Status_MbInitializing, mb::currentTimestamp());
+                items.append(item);
+                deviceItems.append(new mbClientRunItem(item->handle(), item->addressType(), item->addressOffset(),
+                                                       item->count(), item->period(), item->sizeOf()));
+            }
+            runItems.append(deviceItems);
+            mbClientRunDevice *rd = new mbClientRunDevice(dev->settings());
+            rd->setStats(stats.createDevice(port.name(), dev->name()));
+            rd->pushItemsToRead(deviceItems);
+            portDevices.append(rd);
+        }
+        runDevices.append(portDevices);
+        mbClientRunThread *t = new mbClientRunThread(port.settings());
+        t->pushDevices(portDevices);
+        threads.append(t);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    double cpu = cpuTime();
+    Q_FOREACH (mbClientRunThread *t, threads)
+        t->start();
+    QThread::msleep(static_cast<unsigned long>(duration));
+    Q_FOREACH (mbClientRunThread *t, threads)
+        t->stop();
+    Q_FOREACH (mbClientRunThread *t, threads)
+        t->wait();
+    cpu = cpuTime() - cpu;
+    double sec = timer.elapsed() / 1000.0;
+    srv.stop();
+    srv.wait();
+
+    quint64 polls = 0, misses = 0, failures = 0;
+    quint64 latency[mbClientStats::Histogram::BucketCount] = {};
+    Q_FOREACH (mbClientRunDevice *rd, runDevices)
+    {
+        const mbClientStats::Device *d = rd->stats();
+        for (const mbClientStats::Poll *poll = d->firstPoll(); poll; poll = poll->next())
+        {
+            polls += poll->polls();
+            misses += poll->misses();
+            failures += poll->failures();
+        }
+        d->total().latency.addTo(latency);
+    }
+    quint64 responses = 0;
+    for (int i = 0; i < mbClientStats::Histogram::BucketCount; i++)
+        responses += latency[i];
+    qDeleteAll(threads);
+    qDeleteAll(runDevices);
+    qDeleteAll(runItems);
+    qDeleteAll(items);
+    qDeleteAll(devs);
+
+    printf("bench=runloop ports=%d devices=%d period_ms=%d seconds=%.3f cpu_percent=%.2f polls=%llu misses=%llu failures=%llu "
+           "latency_p50_us=%u latency_p99_us=%u\n",
+           ports, devices, period, sec,
+           cpu * 100.0 / sec,
+           static_cast<unsigned long long>(polls),
+           static_cast<unsigned long long>(misses),
+           static_cast<unsigned long long>(failures),
+           mbClientStats::Histogram::percentile(latency, responses, 50),
+           mbClientStats::Histogram::percentile(latency, responses, 99));
+    return !failures;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    RunLoopClient client;
+    client.setLogFlags(mb::Log_Error);
+    // log lines are formatted by the logger thread but not printed
+    QObject::disconnect(client.logger(), &mbCoreLogger::signalMessages, &client, nullptr);
+    QObject::connect(client.logger(), &mbCoreLogger::signalMessages, [&client](const QStringList &) { client.logger()->confirmBatch(); });
+    QStringList args = app.arguments();
+    int ports    = args.count() > 1 ? args.at(1).toInt() : 8;
+    int duration = args.count() > 2 ? args.at(2).toInt() : 2000;
+    int period   = args.count() > 3 ? args.at(3).toInt() : 1000;
+    int devices  = args.count() > 4 ? args.at(4).toInt() : 4;
+    quint16 port = args.count() > 5 ? args.at(5).toUShort() : 15022;
+    if (ports < 1)
+        ports = 1;
+    if (period < 1)
+        period = 1;
+    if (devices < 1)
+        devices = 1;
+
+    bool ok = bench(ports, devices, duration, period, port);
+    client.logger()->stop();
+    client.logger()->takeBatch();
+    return ok ? 0 : 1;
+}
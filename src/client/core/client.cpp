@@ -56,6 +56,7 @@ const mbClient::Strings &mbClient::Strings::instance()
 mbClient::mbClient() :
     mbCore (Strings::instance().settings_application)
 {
+    m_statsPeriod = 0;
 }
 
 mbClient::~mbClient()
@@ -67,14 +68,21 @@ void mbClient::sendMessage(mb::Client::DeviceHandle_t handle, const mbClientRunM
     runtime()->sendMessage(handle, message);
 }
 
-void mbClient::updateItem(mb::Client::ItemHandle_t handle, const QByteArray &data, Modbus::StatusCode status, mb::Timestamp_t timestamp)
+void mbClient::writeItemData(mb::Client::ItemHandle_t handle, const QByteArray &data)
 {
-    runtime()->updateItem(handle, data, status, timestamp);
+    runtime()->writeItemData(handle, data);
 }
 
-void mbClient::writeItemData(mb::Client::ItemHandle_t handle, const QByteArray &data)
+int mbClient::parseArg(int argc, char **argv, int &arg)
 {
-    runtime()->writeItemData(handle, data);
+    // '-stats <seconds>': dump runtime statistics to the log periodically (e.g. for console mode)
+    if (!qstrcmp(argv[arg], "-stats"))
+    {
+        if (++arg < argc)
+            m_statsPeriod = QString(argv[arg]).toInt();
+        return 0;
+    }
+    return mbCore::parseArg(argc, argv, arg);
 }
 
 QString mbClient::createGUID()
@@ -109,7 +117,9 @@ mbCoreBuilder *mbClient::createBuilder()
 
 mbCoreRuntime *mbClient::createRuntime()
 {
-    return new mbClientRuntime(this);
+    mbClientRuntime *runtime = new mbClientRuntime(this);
+    runtime->setStatsPeriod(m_statsPeriod);
+    return runtime;
 }
 
 
@@ -67,15 +67,20 @@ public:
 
 public:
     void sendMessage(mb::Client::DeviceHandle_t handle, const mbClientRunMessagePtr &message);
-    void updateItem(mb::Client::ItemHandle_t handle, const QByteArray &data, Modbus::StatusCode status, mb::Timestamp_t timestamp);
     void writeItemData(mb::Client::ItemHandle_t handle, const QByteArray &data);
 
+protected:
+    int parseArg(int argc, char **argv, int &arg) override;
+
 private:
     QString createGUID();
     mbCoreUi *createUi();
     mbCoreProject *createProject();
     mbCoreBuilder *createBuilder();
     mbCoreRuntime *createRuntime();
+
+private:
+    int m_statsPeriod; // seconds, 0 - statistics is not dumped periodically
 };
 
 
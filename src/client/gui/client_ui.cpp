@@ -168,6 +168,7 @@ void mbClientUi::initialize()
     // Menu Runtime
     connect(ui->actionRuntimeStartStop  , &QAction::triggered, this, &mbClientUi::menuSlotRuntimeStartStop  );
     connect(ui->actionRuntimeSendMessage, &QAction::triggered, this, &mbClientUi::menuSlotRuntimeSendMessage);
+    connect(ui->actionRuntimeStatistics , &QAction::triggered, this, &mbClientUi::menuSlotRuntimeStatistics );
 
     // Menu Window
     connect(ui->actionWindowShowAll     , &QAction::triggered, this, &mbClientUi::menuSlotWindowShowAll    );
@@ -499,6 +500,11 @@ void mbClientUi::menuSlotRuntimeSendMessage()
     dialogs()->sendMessage();
 }
 
+void mbClientUi::menuSlotRuntimeStatistics()
+{
+    dialogs()->statistics();
+}
+
 void mbClientUi::statusChange(int status)
 {
     switch (status)
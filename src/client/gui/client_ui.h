@@ -111,6 +111,7 @@ private Q_SLOTS:
     // -----------RUNTIME----------
     // ----------------------------
     void menuSlotRuntimeSendMessage();
+    void menuSlotRuntimeStatistics();
     //------------------------------
     void statusChange(int status);
 
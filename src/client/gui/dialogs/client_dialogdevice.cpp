@@ -211,6 +211,48 @@ mbClientDialogDevice::mbClientDialogDevice(QWidget *parent) :
     sp->setMaximum(MB_MAX_REGISTERS);
     sp->setValue(dDevice.maxWriteMultipleRegisters);
 
+    // Read Gap Registers
+    sp = ui->spReadGapRegisters;
+    sp->setMinimum(0);
+    sp->setMaximum(MB_MAX_REGISTERS);
+    sp->setValue(dDevice.readGapRegisters);
+
+    // Read Gap Bits
+    sp = ui->spReadGapBits;
+    sp->setMinimum(0);
+    sp->setMaximum(MB_MAX_DISCRETS);
+    sp->setValue(dDevice.readGapBits);
+
+    // Adaptive Timeout
+    ui->chbAdaptiveTimeout->setChecked(dDevice.adaptiveTimeout);
+
+    // Quarantine Errors
+    sp = ui->spQuarantineErrors;
+    sp->setMinimum(0);
+    sp->setMaximum(INT_MAX);
+    sp->setValue(static_cast<int>(dDevice.quarantineErrors));
+
+    // Quarantine Backoff Max
+    sp = ui->spQuarantineBackoffMax;
+    sp->setMinimum(0);
+    sp->setMaximum(INT_MAX);
+    sp->setValue(static_cast<int>(dDevice.quarantineBackoffMax));
+
+    // Poll Weight
+    sp = ui->spPollWeight;
+    sp->setMinimum(1);
+    sp->setMaximum(USHRT_MAX);
+    sp->setValue(static_cast<int>(dDevice.pollWeight));
+
+    // Poll Priority
+    sp = ui->spPollPriority;
+    sp->setMinimum(0);
+    sp->setMaximum(UCHAR_MAX);
+    sp->setValue(dDevice.pollPriority);
+
+    // EDF Scheduling
+    ui->chbEdfScheduling->setChecked(dDevice.edfScheduling);
+
     // Register Order
     cmb = ui->cmbRegisterOrder;
     e = mb::metaEnum<mb::DataOrder>();
@@ -291,6 +333,14 @@ void mbClientDialogDevice::fillForm(const MBSETTINGS &m)
         ui->spMaxReadInputRegisters->setValue(m.value(ms.maxReadInputRegisters).toInt());
         ui->spMaxWriteMultipleCoils->setValue(m.value(ms.maxWriteMultipleCoils).toInt());
         ui->spMaxWriteMultipleRegisters->setValue(m.value(ms.maxWriteMultipleRegisters).toInt());
+        ui->spReadGapRegisters->setValue(m.value(ms.readGapRegisters).toInt());
+        ui->spReadGapBits->setValue(m.value(ms.readGapBits).toInt());
+        ui->chbAdaptiveTimeout->setChecked(m.value(ms.adaptiveTimeout).toBool());
+        ui->spQuarantineErrors->setValue(m.value(ms.quarantineErrors).toInt());
+        ui->spQuarantineBackoffMax->setValue(m.value(ms.quarantineBackoffMax).toInt());
+        ui->spPollWeight->setValue(m.value(ms.pollWeight).toInt());
+        ui->spPollPriority->setValue(m.value(ms.pollPriority).toInt());
+        ui->chbEdfScheduling->setChecked(m.value(ms.edfScheduling).toBool());
         ui->cmbRegisterOrder->setCurrentText(m.value(ms.registerOrder).toString()); // TODO: Default order special processing
         ui->cmbByteArrayFormat->setCurrentText(m.value(ms.byteArrayFormat).toString());
         ui->lnByteArraySeparator->setText(m.value(ms.byteArraySeparator).toString());
@@ -316,6 +366,14 @@ void mbClientDialogDevice::fillData(MBSETTINGS &m)
     m[ms.maxReadInputRegisters] = ui->spMaxReadInputRegisters->value();
     m[ms.maxWriteMultipleCoils] = ui->spMaxWriteMultipleCoils->value();
     m[ms.maxWriteMultipleRegisters] = ui->spMaxWriteMultipleRegisters->value();
+    m[ms.readGapRegisters] = ui->spReadGapRegisters->value();
+    m[ms.readGapBits] = ui->spReadGapBits->value();
+    m[ms.adaptiveTimeout] = ui->chbAdaptiveTimeout->isChecked();
+    m[ms.quarantineErrors] = ui->spQuarantineErrors->value();
+    m[ms.quarantineBackoffMax] = ui->spQuarantineBackoffMax->value();
+    m[ms.pollWeight] = ui->spPollWeight->value();
+    m[ms.pollPriority] = ui->spPollPriority->value();
+    m[ms.edfScheduling] = ui->chbEdfScheduling->isChecked();
     m[ms.registerOrder] = ui->cmbRegisterOrder->currentText(); // TODO: Default order special processing
     m[ms.byteArrayFormat] = ui->cmbByteArrayFormat->currentText();
     m[ms.byteArraySeparator] = ui->lnByteArraySeparator->text();
@@ -141,6 +141,11 @@ mbClientDialogPort::mbClientDialogPort(QWidget *parent) :
     sp->setMinimum(0);
     sp->setMaximum(INT_MAX);
     sp->setValue(td.timeout);
+    // Pipeline window
+    sp = ui->spPipelineWindow;
+    sp->setMinimum(1);
+    sp->setMaximum(USHRT_MAX);
+    sp->setValue(d.pipelineWindow);
     connect(ui->buttonBox, SIGNAL(accepted()), this, SLOT(accept()));
     connect(ui->buttonBox, SIGNAL(rejected()), this, SLOT(reject()));
 }
@@ -189,6 +194,7 @@ void mbClientDialogPort::fillForm(const MBSETTINGS &settings)
     ui->lnHost   ->setText (settings.value(ts.host   ).toString());
     ui->spPort   ->setValue(settings.value(ts.port   ).toInt());
     ui->spTimeout->setValue(settings.value(ts.timeout).toInt());
+    ui->spPipelineWindow->setValue(settings.value(ms.pipelineWindow).toInt());
 }
 
 void mbClientDialogPort::fillData(MBSETTINGS &m)
@@ -212,6 +218,7 @@ void mbClientDialogPort::fillData(MBSETTINGS &m)
     m[ts.host   ] = ui->lnHost   ->text();
     m[ts.port   ] = ui->spPort   ->value();
     m[ts.timeout] = ui->spTimeout->value();
+    m[ms.pipelineWindow] = ui->spPipelineWindow->value();
 }
 
 void mbClientDialogPort::setType(int type)
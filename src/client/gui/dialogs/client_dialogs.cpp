@@ -29,6 +29,7 @@
 #include "client_dialogdevice.h"
 #include "client_dialogdataviewitem.h"
 #include "client_dialogsendmessage.h"
+#include "client_dialogstatistics.h"
 
 mbClientDialogs::mbClientDialogs(QWidget *parent) :
     mbCoreDialogs (parent)
@@ -37,9 +38,15 @@ mbClientDialogs::mbClientDialogs(QWidget *parent) :
     m_device = new mbClientDialogDevice(parent);
     m_dataViewItem = new mbClientDialogDataViewItem(parent);
     m_sendMessage = new mbClientDialogSendMessage(parent);
+    m_statistics = new mbClientDialogStatistics(parent);
 }
 
 void mbClientDialogs::sendMessage()
 {
     m_sendMessage->show();
 }
+
+void mbClientDialogs::statistics()
+{
+    m_statistics->show();
+}
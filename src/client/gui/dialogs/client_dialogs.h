@@ -26,6 +26,7 @@
 #include <gui/dialogs/core_dialogs.h>
 
 class mbClientDialogSendMessage;
+class mbClientDialogStatistics;
 
 class mbClientDialogs : public mbCoreDialogs
 {
@@ -34,9 +35,11 @@ public:
 
 public:
     void sendMessage();
+    void statistics();
 
 private:
     mbClientDialogSendMessage *m_sendMessage;
+    mbClientDialogStatistics *m_statistics;
 };
 
 #endif // CLIENT_DIALOGS_H
@@ -0,0 +1,198 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "client_dialogstatistics.h"
+#include "ui_client_dialogstatistics.h"
+
+#include <client.h>
+
+#include <runtime/client_runtime.h>
+
+mbClientDialogStatistics::mbClientDialogStatistics(QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::mbClientDialogStatistics)
+{
+    ui->setupUi(this);
+    m_timer = 0;
+
+    QStringList header;
+    header << QStringLiteral("Port")
+           << QStringLiteral("Device")
+           << QStringLiteral("Function")
+           << QStringLiteral("Requests")
+           << QStringLiteral("Req/s")
+           << QStringLiteral("Good")
+           << QStringLiteral("Exceptions")
+           << QStringLiteral("Timeouts")
+           << QStringLiteral("Errors")
+           << QStringLiteral("Repeats")
+           << QStringLiteral("p50, us")
+           << QStringLiteral("p90, us")
+           << QStringLiteral("p99, us")
+           << QStringLiteral("Max, us")
+           << QStringLiteral("Discarded, bytes")
+           << QStringLiteral("State")
+           << QStringLiteral("SRTT, us")
+           << QStringLiteral("Timeout, us")
+           << QStringLiteral("Quarantines")
+           << QStringLiteral("Probes");
+    ui->tableStatistics->setColumnCount(header.count());
+    ui->tableStatistics->setHorizontalHeaderLabels(header);
+
+    header.clear();
+    header << QStringLiteral("Port")
+           << QStringLiteral("Device")
+           << QStringLiteral("Message")
+           << QStringLiteral("Period, ms")
+           << QStringLiteral("Polls")
+           << QStringLiteral("Misses")
+           << QStringLiteral("Miss, %")
+           << QStringLiteral("Failures")
+           << QStringLiteral("Lateness p50, us")
+           << QStringLiteral("Lateness p99, us")
+           << QStringLiteral("Lateness max, us");
+    ui->tableDeadlines->setColumnCount(header.count());
+    ui->tableDeadlines->setHorizontalHeaderLabels(header);
+
+    connect(ui->btnDump , &QPushButton::clicked, this, &mbClientDialogStatistics::dump );
+    connect(ui->btnClose, &QPushButton::clicked, this, &QDialog::close);
+}
+
+mbClientDialogStatistics::~mbClientDialogStatistics()
+{
+    delete ui;
+}
+
+void mbClientDialogStatistics::refresh()
+{
+    mbClientRuntime *runtime = mbClient::global()->runtime();
+    if (!runtime)
+        return;
+    const mbClientStats::Rows_t rows = runtime->stats()->snapshot();
+    QTableWidget *table = ui->tableStatistics;
+    table->setRowCount(rows.count());
+    for (int r = 0; r < rows.count(); r++)
+    {
+        const mbClientStats::Row &row = rows.at(r);
+        QStringList values;
+        values << row.port
+               << row.device
+               << ((row.function >= 0) ? mb::ModbusFunctionString(static_cast<uint8_t>(row.function)) : QString())
+               << QString::number(row.requests)
+               << QString::number(row.requestsPerSec, 'f', 1)
+               << QString::number(row.good)
+               << QString::number(row.exceptions)
+               << QString::number(row.timeouts)
+               << QString::number(row.errors)
+               << QString::number(row.repeats)
+               << QString::number(row.p50)
+               << QString::number(row.p90)
+               << QString::number(row.p99)
+               << QString::number(row.max)
+               << (row.device.isEmpty() ? QString::number(row.discarded) : QString());
+        if (row.state >= 0)
+            values << mbClientStats::stateString(row.state)
+                   << QString::number(row.srtt)
+                   << QString::number(row.rto)
+                   << QString::number(row.quarantines)
+                   << QString::number(row.probes);
+        else
+            values << QString() << QString() << QString() << QString() << QString();
+        for (int c = 0; c < values.count(); c++)
+        {
+            QTableWidgetItem *item = table->item(r, c);
+            if (!item)
+            {
+                item = new QTableWidgetItem;
+                table->setItem(r, c, item);
+            }
+            item->setText(values.at(c));
+        }
+    }
+    refreshDeadlines();
+}
+
+void mbClientDialogStatistics::refreshDeadlines()
+{
+    mbClientRuntime *runtime = mbClient::global()->runtime();
+    if (!runtime)
+        return;
+    const mbClientStats::PollRows_t rows = runtime->stats()->pollSnapshot();
+    QTableWidget *table = ui->tableDeadlines;
+    table->setRowCount(rows.count());
+    for (int r = 0; r < rows.count(); r++)
+    {
+        const mbClientStats::PollRow &row = rows.at(r);
+        double miss = row.polls ? static_cast<double>(row.misses) * 100.0 / row.polls : 0;
+        QStringList values;
+        values << row.port
+               << row.device
+               << row.message
+               << QString::number(row.period)
+               << QString::number(row.polls)
+               << QString::number(row.misses)
+               << QString::number(miss, 'f', 1)
+               << QString::number(row.failures)
+               << QString::number(row.p50)
+               << QString::number(row.p99)
+               << QString::number(row.max);
+        for (int c = 0; c < values.count(); c++)
+        {
+            QTableWidgetItem *item = table->item(r, c);
+            if (!item)
+            {
+                item = new QTableWidgetItem;
+                table->setItem(r, c, item);
+            }
+            item->setText(values.at(c));
+        }
+    }
+}
+
+void mbClientDialogStatistics::dump()
+{
+    if (mbClientRuntime *runtime = mbClient::global()->runtime())
+        runtime->dumpStatistics();
+}
+
+void mbClientDialogStatistics::showEvent(QShowEvent *event)
+{
+    refresh();
+    if (!m_timer)
+        m_timer = startTimer(RefreshPeriod);
+    QDialog::showEvent(event);
+}
+
+void mbClientDialogStatistics::hideEvent(QHideEvent *event)
+{
+    if (m_timer)
+    {
+        killTimer(m_timer);
+        m_timer = 0;
+    }
+    QDialog::hideEvent(event);
+}
+
+void mbClientDialogStatistics::timerEvent(QTimerEvent * /*event*/)
+{
+    refresh();
+}
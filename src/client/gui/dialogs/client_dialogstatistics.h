@@ -0,0 +1,61 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef CLIENT_DIALOGSTATISTICS_H
+#define CLIENT_DIALOGSTATISTICS_H
+
+#include <QDialog>
+
+namespace Ui {
+class mbClientDialogStatistics;
+}
+
+class mbClientDialogStatistics : public QDialog
+{
+    Q_OBJECT
+
+public:
+    // period (milliseconds) to refresh statistics while dialog is visible
+    static const int RefreshPeriod = 1000;
+
+public:
+    explicit mbClientDialogStatistics(QWidget *parent = nullptr);
+    ~mbClientDialogStatistics();
+
+private Q_SLOTS:
+    void refresh();
+    void dump();
+
+private:
+    void refreshDeadlines();
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+    void timerEvent(QTimerEvent *event) override;
+
+private:
+    Ui::mbClientDialogStatistics *ui;
+
+private:
+    int m_timer;
+};
+
+#endif // CLIENT_DIALOGSTATISTICS_H
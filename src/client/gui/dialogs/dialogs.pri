@@ -2,6 +2,7 @@ HEADERS += \
     $$PWD/client_dialogdevice.h         \
     $$PWD/client_dialogport.h           \
     $$PWD/client_dialogsendmessage.h    \
+    $$PWD/client_dialogstatistics.h     \
     $$PWD/client_dialogs.h              \
      \
     $$PWD/client_dialogdataviewitem.h
@@ -9,6 +10,7 @@ SOURCES += \
     $$PWD/client_dialogdevice.cpp       \
     $$PWD/client_dialogport.cpp         \
     $$PWD/client_dialogsendmessage.cpp  \
+    $$PWD/client_dialogstatistics.cpp   \
     $$PWD/client_dialogs.cpp            \
     $$PWD/client_dialogdataviewitem.cpp
 
@@ -16,4 +18,5 @@ FORMS += \
     $$PWD/client_dialogdevice.ui        \
     $$PWD/client_dialogport.ui          \
     $$PWD/client_dialogsendmessage.ui   \
+    $$PWD/client_dialogstatistics.ui    \
     $$PWD/client_dialogdataviewitem.ui
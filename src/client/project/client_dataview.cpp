@@ -55,6 +55,7 @@ mbClientDataViewItem::mbClientDataViewItem(QObject *parent) :
     m_status = mb::Status_MbStopped;
     m_timestamp = mb::currentTimestamp();
     m_cache = toVariant(m_value);
+    m_cacheValid = true;
 }
 
 void mbClientDataViewItem::setFormat(mb::Format format)
@@ -65,6 +66,7 @@ void mbClientDataViewItem::setFormat(mb::Format format)
         this->blockSignals(true);
         mbCoreDataViewItem::setFormat(format);
         m_cache = toVariant(m_value);
+        m_cacheValid = true;
         this->blockSignals(false);
         Q_EMIT changed();
     }
@@ -163,7 +165,13 @@ bool mbClientDataViewItem::setSettings(const MBSETTINGS &settings)
 
 QVariant mbClientDataViewItem::value() const
 {
-    QReadLocker _(&m_lock);
+    // Note: value is converted by the reader (view), so polling thread neither converts nor allocates
+    QWriteLocker _(&m_lock);
+    if (!m_cacheValid)
+    {
+        m_cache = toVariant(m_value);
+        m_cacheValid = true;
+    }
     return m_cache;
 }
 
@@ -185,18 +193,19 @@ void mbClientDataViewItem::setValue(const QVariant &value)
 void mbClientDataViewItem::update(const QByteArray &value, mb::StatusCode status, mb::Timestamp_t timestamp)
 {
     QWriteLocker _(&m_lock);
-    if (value.count())
+    // Note: unchanged value is neither copied nor converted, changed one is copied into existing buffer
+    // (not shared with caller), so steady polling doesn't allocate memory
+    if (value.count() && (value != m_value))
     {
-        m_value = value;
-        QVariant newCacheValue = toVariant(m_value);
-        if (m_cache != newCacheValue)
-        {
-            m_cache = newCacheValue;
-            m_status = status;
-            m_timestamp = timestamp;
-            Q_EMIT valueChanged();
-            return;
-        }
+        if (m_value.size() == value.size())
+            memcpy(m_value.data(), value.constData(), static_cast<size_t>(value.size()));
+        else
+            m_value = QByteArray(value.constData(), value.size());
+        m_cacheValid = false;
+        m_status = status;
+        m_timestamp = timestamp;
+        Q_EMIT valueChanged();
+        return;
     }
     if (m_status != status)
     {
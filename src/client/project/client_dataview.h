@@ -88,7 +88,8 @@ private:
     mb::StatusCode m_status;
     mb::Timestamp_t m_timestamp;
     QByteArray m_value;
-    QVariant m_cache;
+    mutable QVariant m_cache; // converted 'm_value', it's made by 'value()' when it's not valid
+    mutable bool m_cacheValid;
 
 private:
     mutable QReadWriteLock m_lock;
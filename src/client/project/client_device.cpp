@@ -31,8 +31,16 @@
 
 mbClientDevice::Strings::Strings() :
     mbCoreDevice::Strings(),
-    unit    (QStringLiteral("unit")),
-    portName(QStringLiteral("portName"))
+    unit                (QStringLiteral("unit")),
+    portName            (QStringLiteral("portName")),
+    readGapRegisters    (QStringLiteral("readGapRegisters")),
+    readGapBits         (QStringLiteral("readGapBits")),
+    adaptiveTimeout     (QStringLiteral("adaptiveTimeout")),
+    quarantineErrors    (QStringLiteral("quarantineErrors")),
+    quarantineBackoffMax(QStringLiteral("quarantineBackoffMax")),
+    pollWeight          (QStringLiteral("pollWeight")),
+    pollPriority        (QStringLiteral("pollPriority")),
+    edfScheduling       (QStringLiteral("edfScheduling"))
 
 {
 }
@@ -46,7 +54,15 @@ const mbClientDevice::Strings &mbClientDevice::Strings::instance()
 mbClientDevice::Defaults::Defaults() :
     mbCoreDevice::Defaults(),
     unit(Modbus::Client::Defaults::instance().unit),
-    portName(mbClientPort::Defaults::instance().name)
+    portName(mbClientPort::Defaults::instance().name),
+    readGapRegisters(MB_MAX_REGISTERS),
+    readGapBits(MB_MAX_DISCRETS),
+    adaptiveTimeout(false),
+    quarantineErrors(0),
+    quarantineBackoffMax(60000),
+    pollWeight(1),
+    pollPriority(0),
+    edfScheduling(false)
 {
 }
 
@@ -64,6 +80,14 @@ mbClientDevice::mbClientDevice(QObject *parent) :
     m_port = nullptr;
 
     m_settings.unit = d.unit;
+    m_settings.readGapRegisters = d.readGapRegisters;
+    m_settings.readGapBits = d.readGapBits;
+    m_settings.adaptiveTimeout = d.adaptiveTimeout;
+    m_settings.quarantineErrors = d.quarantineErrors;
+    m_settings.quarantineBackoffMax = d.quarantineBackoffMax;
+    m_settings.pollWeight = d.pollWeight;
+    m_settings.pollPriority = d.pollPriority;
+    m_settings.edfScheduling = d.edfScheduling;
 }
 
 mbClientDevice::~mbClientDevice()
@@ -99,8 +123,16 @@ MBSETTINGS mbClientDevice::settings() const
 
     MBSETTINGS r = mbCoreDevice::settings();
 
-    r.insert(s.unit    , unit    ());
-    r.insert(s.portName, portName());
+    r.insert(s.unit                , unit                ());
+    r.insert(s.portName            , portName            ());
+    r.insert(s.readGapRegisters    , readGapRegisters    ());
+    r.insert(s.readGapBits         , readGapBits         ());
+    r.insert(s.adaptiveTimeout     , isAdaptiveTimeout   ());
+    r.insert(s.quarantineErrors    , quarantineErrors    ());
+    r.insert(s.quarantineBackoffMax, quarantineBackoffMax());
+    r.insert(s.pollWeight          , pollWeight          ());
+    r.insert(s.pollPriority        , pollPriority        ());
+    r.insert(s.edfScheduling       , isEdfScheduling     ());
 
     return r;
 }
@@ -129,6 +161,74 @@ bool mbClientDevice::setSettings(const MBSETTINGS &settings)
         setPortName(var.toString());
     }
 
+    it = settings.find(s.readGapRegisters);
+    if (it != end)
+    {
+        QVariant var = it.value();
+        uint16_t v = static_cast<uint16_t>(var.toUInt(&ok));
+        if (ok)
+            setReadGapRegisters(v);
+    }
+
+    it = settings.find(s.readGapBits);
+    if (it != end)
+    {
+        QVariant var = it.value();
+        uint16_t v = static_cast<uint16_t>(var.toUInt(&ok));
+        if (ok)
+            setReadGapBits(v);
+    }
+
+    it = settings.find(s.adaptiveTimeout);
+    if (it != end)
+    {
+        QVariant var = it.value();
+        setAdaptiveTimeout(var.toBool());
+    }
+
+    it = settings.find(s.quarantineErrors);
+    if (it != end)
+    {
+        QVariant var = it.value();
+        uint32_t v = var.toUInt(&ok);
+        if (ok)
+            setQuarantineErrors(v);
+    }
+
+    it = settings.find(s.quarantineBackoffMax);
+    if (it != end)
+    {
+        QVariant var = it.value();
+        uint32_t v = var.toUInt(&ok);
+        if (ok)
+            setQuarantineBackoffMax(v);
+    }
+
+    it = settings.find(s.pollWeight);
+    if (it != end)
+    {
+        QVariant var = it.value();
+        uint32_t v = var.toUInt(&ok);
+        if (ok && (v > 0))
+            setPollWeight(v);
+    }
+
+    it = settings.find(s.pollPriority);
+    if (it != end)
+    {
+        QVariant var = it.value();
+        uint8_t v = static_cast<uint8_t>(var.toUInt(&ok));
+        if (ok)
+            setPollPriority(v);
+    }
+
+    it = settings.find(s.edfScheduling);
+    if (it != end)
+    {
+        QVariant var = it.value();
+        setEdfScheduling(var.toBool());
+    }
+
     mbCoreDevice::setSettings(settings); // Q_EMIT changed() within
     return true;
 }
@@ -41,8 +41,16 @@ class mbClientDevice : public mbCoreDevice
 public:
     struct Strings : public mbCoreDevice::Strings
     {
-        const QString unit    ;
-        const QString portName;
+        const QString unit            ;
+        const QString portName        ;
+        const QString readGapRegisters    ;
+        const QString readGapBits         ;
+        const QString adaptiveTimeout     ;
+        const QString quarantineErrors    ;
+        const QString quarantineBackoffMax;
+        const QString pollWeight          ;
+        const QString pollPriority        ;
+        const QString edfScheduling       ;
 
         Strings();
         static const Strings &instance();
@@ -50,8 +58,16 @@ public:
 
     struct Defaults : public mbCoreDevice::Defaults
     {
-        const uint8_t unit    ;
-        const QString portName;
+        const uint8_t  unit            ;
+        const QString  portName        ;
+        const uint16_t readGapRegisters    ;
+        const uint16_t readGapBits         ;
+        const bool     adaptiveTimeout     ;
+        const uint32_t quarantineErrors    ;
+        const uint32_t quarantineBackoffMax;
+        const uint32_t pollWeight          ;
+        const uint8_t  pollPriority        ;
+        const bool     edfScheduling       ;
 
         Defaults();
         static const Defaults &instance();
@@ -75,6 +91,29 @@ public: // settings
     inline void setUnit(uint8_t unit) { m_settings.unit = unit; }
     QString portName() const;
     void setPortName(const QString &portName);
+    // max count of unused registers/bits between items that are read by single request
+    inline uint16_t readGapRegisters() const { return m_settings.readGapRegisters; }
+    inline void setReadGapRegisters(uint16_t gap) { m_settings.readGapRegisters = gap; }
+    inline uint16_t readGapBits() const { return m_settings.readGapBits; }
+    inline void setReadGapBits(uint16_t gap) { m_settings.readGapBits = gap; }
+    // response timeout is derived from measured response time of the device
+    inline bool isAdaptiveTimeout() const { return m_settings.adaptiveTimeout; }
+    inline void setAdaptiveTimeout(bool enable) { m_settings.adaptiveTimeout = enable; }
+    // count of consecutive failed requests to put device into quarantine (0 - disabled)
+    inline uint32_t quarantineErrors() const { return m_settings.quarantineErrors; }
+    inline void setQuarantineErrors(uint32_t count) { m_settings.quarantineErrors = count; }
+    // max period (milliseconds) between probes of the quarantined device
+    inline uint32_t quarantineBackoffMax() const { return m_settings.quarantineBackoffMax; }
+    inline void setQuarantineBackoffMax(uint32_t msec) { m_settings.quarantineBackoffMax = msec; }
+    // share of the port given to read requests of the device relative to other devices of the same priority
+    inline uint32_t pollWeight() const { return m_settings.pollWeight; }
+    inline void setPollWeight(uint32_t weight) { m_settings.pollWeight = weight; }
+    // read requests of the device with higher priority are sent first
+    inline uint8_t pollPriority() const { return m_settings.pollPriority; }
+    inline void setPollPriority(uint8_t priority) { m_settings.pollPriority = priority; }
+    // read messages of the device are sent by earliest deadline (release time plus period) first
+    inline bool isEdfScheduling() const { return m_settings.edfScheduling; }
+    inline void setEdfScheduling(bool enable) { m_settings.edfScheduling = enable; }
 
     MBSETTINGS settings() const override;
     bool setSettings(const MBSETTINGS &settings) override;
@@ -85,8 +124,16 @@ private:
 private: // settings
     struct
     {
-        uint8_t unit    ;
-        QString portName;
+        uint8_t  unit            ;
+        QString  portName        ;
+        uint16_t readGapRegisters    ;
+        uint16_t readGapBits         ;
+        bool     adaptiveTimeout     ;
+        uint32_t quarantineErrors    ;
+        uint32_t quarantineBackoffMax;
+        uint32_t pollWeight          ;
+        uint8_t  pollPriority        ;
+        bool     edfScheduling       ;
     } m_settings;
 };
 
@@ -26,19 +26,74 @@
 
 #include <ModbusPortTCP.h>
 #include <ModbusPortSerial.h>
+#include <ModbusClientPort.h>
 #include <client.h>
 
 #include "client_device.h"
 
+mbClientPort::Strings::Strings() :
+    mbCorePort::Strings(),
+    pipelineWindow(Modbus::ClientPort::Strings::instance().pipelineWindow)
+{
+}
+
+const mbClientPort::Strings &mbClientPort::Strings::instance()
+{
+    static const Strings s;
+    return s;
+}
+
+mbClientPort::Defaults::Defaults() :
+    mbCorePort::Defaults(),
+    pipelineWindow(Modbus::ClientPort::Defaults::instance().pipelineWindow)
+{
+}
+
+const mbClientPort::Defaults &mbClientPort::Defaults::instance()
+{
+    static const Defaults d;
+    return d;
+}
+
 mbClientPort::mbClientPort(QObject *parent) :
     mbCorePort(parent)
 {
+    m_settingsClient.pipelineWindow = Defaults::instance().pipelineWindow;
 }
 
 mbClientPort::~mbClientPort()
 {
 }
 
+MBSETTINGS mbClientPort::settings() const
+{
+    const Strings &s = Strings::instance();
+
+    MBSETTINGS r = mbCorePort::settings();
+    r.insert(s.pipelineWindow, pipelineWindow());
+    return r;
+}
+
+bool mbClientPort::setSettings(const MBSETTINGS &settings)
+{
+    const Strings &s = Strings::instance();
+
+    MBSETTINGS::const_iterator it;
+    MBSETTINGS::const_iterator end = settings.end();
+    bool ok;
+
+    it = settings.find(s.pipelineWindow);
+    if (it != end)
+    {
+        QVariant var = it.value();
+        uint32_t v = static_cast<uint32_t>(var.toUInt(&ok));
+        if (ok)
+            setPipelineWindow(v);
+    }
+
+    return mbCorePort::setSettings(settings);
+}
+
 mbClientDevice *mbClientPort::device(const QString &name) const
 {
     Q_FOREACH(mbClientDevice *d, m_devices)
@@ -37,6 +37,23 @@ class mbClientPort : public mbCorePort
 {
     Q_OBJECT
 
+public:
+    struct Strings : public mbCorePort::Strings
+    {
+        const QString pipelineWindow;
+
+        Strings();
+        static const Strings &instance();
+    };
+
+    struct Defaults : public mbCorePort::Defaults
+    {
+        const uint32_t pipelineWindow;
+
+        Defaults();
+        static const Defaults &instance();
+    };
+
 public:
     explicit mbClientPort(QObject* parent = nullptr);
     virtual ~mbClientPort();
@@ -45,6 +62,14 @@ public:
     inline mbClientProject* project() const { return reinterpret_cast<mbClientProject*>(mbCorePort::projectCore()); }
     inline void setProject(mbClientProject* project) { mbCorePort::setProjectCore(reinterpret_cast<mbCoreProject*>(project)); }
 
+public: // tcp settings
+    inline uint32_t pipelineWindow() const { return m_settingsClient.pipelineWindow; }
+    inline void setPipelineWindow(uint32_t pipelineWindow) { if (pipelineWindow > 0) m_settingsClient.pipelineWindow = pipelineWindow; }
+
+public: // settings
+    MBSETTINGS settings() const override;
+    bool setSettings(const MBSETTINGS &settings) override;
+
 public: // devices
     inline bool hasDevice(const QString& name) const { return device(name); }
     inline bool hasDevice(mbClientDevice* device) const { return m_devices.contains(device); }
@@ -66,6 +91,12 @@ Q_SIGNALS:
     void deviceRemoving(mbClientDevice*);
     void deviceRemoved(mbClientDevice*);
 
+private:
+    struct
+    {
+        uint32_t pipelineWindow;
+    } m_settingsClient;
+
 private:
     typedef QList<mbClientDevice*> Devices_t;
     Devices_t m_devices;
@@ -0,0 +1,109 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "client_devicehealth.h"
+
+mbClientDeviceHealth::mbClientDeviceHealth()
+{
+    m_adaptiveTimeout = false;
+    m_quarantineErrors = 0;
+    m_backoffMax = 60000;
+    m_state = Online;
+    m_estimated = false;
+    m_srtt = 0;
+    m_rttvar = 0;
+    m_rto = 0;
+    m_failures = 0;
+    m_backoff = 0;
+    m_probing = false;
+    m_probeDue = 0;
+    m_quarantines = 0;
+    m_probes = 0;
+}
+
+uint32_t mbClientDeviceHealth::timeout() const
+{
+    // Note: probe of the quarantined device waits full timeout of the port
+    if (!m_adaptiveTimeout || (m_state == Quarantine))
+        return 0;
+    return m_rto;
+}
+
+bool mbClientDeviceHealth::isPollAllowed(qint64 now) const
+{
+    if (m_state == Online)
+        return true;
+    return !m_probing && (now >= m_probeDue);
+}
+
+void mbClientDeviceHealth::beginProbe()
+{
+    m_probing = true;
+    m_probes++;
+}
+
+void mbClientDeviceHealth::record(Modbus::StatusCode status, uint32_t latency, uint32_t repeats, qint64 now)
+{
+    m_probing = false;
+    if (Modbus::StatusIsGood(status) || Modbus::StatusIsStandardError(status)) // device has responded
+    {
+        // Note: latency of the repeated request is ambiguous, so it's not sampled (Karn's algorithm)
+        if (m_adaptiveTimeout && (repeats == 0))
+            sample(latency);
+        m_failures = 0;
+        m_state = Online;
+        m_backoff = 0;
+        return;
+    }
+    m_failures++;
+    if (m_rto) // timeout is backed off until the next valid sample
+        m_rto = (m_rto < TimeoutMax / 2) ? m_rto * 2 : TimeoutMax;
+    if (m_state == Quarantine)
+        m_backoff = (m_backoff < m_backoffMax / 2) ? m_backoff * 2 : m_backoffMax;
+    else if (m_quarantineErrors && (m_failures >= m_quarantineErrors))
+    {
+        m_state = Quarantine;
+        m_quarantines++;
+        m_backoff = (m_backoffMax < BackoffMin) ? m_backoffMax : BackoffMin;
+    }
+    else
+        return;
+    m_probeDue = now + m_backoff * 1000000LL;
+}
+
+void mbClientDeviceHealth::sample(uint32_t latency)
+{
+    if (!m_estimated)
+    {
+        m_srtt = latency;
+        m_rttvar = latency / 2;
+        m_estimated = true;
+    }
+    else
+    {
+        uint32_t delta = (m_srtt > latency) ? m_srtt - latency : latency - m_srtt;
+        m_rttvar = static_cast<uint32_t>((3ull * m_rttvar + delta) / 4);
+        m_srtt = static_cast<uint32_t>((7ull * m_srtt + latency) / 8);
+    }
+    quint64 rto = static_cast<quint64>(m_srtt) + 4ull * m_rttvar;
+    m_rto = static_cast<uint32_t>(qBound(static_cast<quint64>(TimeoutMin), rto, static_cast<quint64>(TimeoutMax)));
+}
@@ -0,0 +1,106 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef CLIENT_DEVICEHEALTH_H
+#define CLIENT_DEVICEHEALTH_H
+
+#include <Modbus.h>
+#include <client_global.h>
+
+// Health of the device polled by the client: response time estimation (SRTT/RTTVAR as for TCP, RFC 6298)
+// gives adaptive response timeout, device which keeps failing is put into quarantine where it's probed
+// by single request with exponential backoff, so it doesn't stall other devices of the port.
+// Note: it's used by the port thread only
+class mbClientDeviceHealth
+{
+public:
+    enum State
+    {
+        Online,
+        Quarantine
+    };
+
+public:
+    // lower bound (microseconds) of the adaptive timeout
+    static const uint32_t TimeoutMin = 10000;
+    // upper bound (microseconds) of the adaptive timeout, anyway it can't exceed the timeout of the port
+    static const uint32_t TimeoutMax = 60000000;
+    // first period (milliseconds) between quarantine probes
+    static const uint32_t BackoffMin = 500;
+
+public:
+    mbClientDeviceHealth();
+
+public: // settings
+    inline bool isAdaptiveTimeout() const { return m_adaptiveTimeout; }
+    inline void setAdaptiveTimeout(bool enable) { m_adaptiveTimeout = enable; }
+    // count of consecutive failed requests to put device into quarantine, 0 - quarantine is disabled
+    inline uint32_t quarantineErrors() const { return m_quarantineErrors; }
+    inline void setQuarantineErrors(uint32_t count) { m_quarantineErrors = count; }
+    // max period (milliseconds) between quarantine probes
+    inline uint32_t backoffMax() const { return m_backoffMax; }
+    inline void setBackoffMax(uint32_t msec) { m_backoffMax = msec; }
+
+public:
+    inline State state() const { return m_state; }
+    inline bool isQuarantined() const { return m_state == Quarantine; }
+    // estimated values (microseconds), 0 if there is no sample yet
+    inline uint32_t srtt() const { return m_srtt; }
+    inline uint32_t rttvar() const { return m_rttvar; }
+    inline uint32_t rto() const { return m_rto; }
+    inline uint32_t failures() const { return m_failures; }
+    inline quint64 quarantineCount() const { return m_quarantines; }
+    inline quint64 probeCount() const { return m_probes; }
+    // monotonic time (nanoseconds) of the next probe in quarantine
+    inline qint64 nextProbe() const { return m_probeDue; }
+
+public:
+    // response timeout (microseconds) for the next request, 0 - timeout of the port
+    uint32_t timeout() const;
+    // read request can be sent at 'now': always when online, in quarantine single probe when its time has come
+    bool isPollAllowed(qint64 now) const;
+    // read request is sent as a probe of the quarantined device
+    void beginProbe();
+    // result of the completed request, 'latency' is in microseconds
+    void record(Modbus::StatusCode status, uint32_t latency, uint32_t repeats, qint64 now);
+
+private:
+    void sample(uint32_t latency);
+
+private:
+    bool m_adaptiveTimeout;
+    uint32_t m_quarantineErrors;
+    uint32_t m_backoffMax;
+    State m_state;
+    bool m_estimated;
+    uint32_t m_srtt;
+    uint32_t m_rttvar;
+    uint32_t m_rto;
+    uint32_t m_failures;
+    uint32_t m_backoff;
+    bool m_probing;
+    qint64 m_probeDue;
+    quint64 m_quarantines;
+    quint64 m_probes;
+};
+
+#endif // CLIENT_DEVICEHEALTH_H
@@ -22,6 +22,8 @@
 */
 #include "client_devicerunnable.h"
 
+#include <algorithm>
+
 #include <ModbusClient.h>
 
 #include <client.h>
@@ -29,14 +31,31 @@
 #include "client_rundevice.h"
 #include "client_runmessage.h"
 #include "client_runitem.h"
+#include "client_readplanner.h"
 
 mbClientDeviceRunnable::mbClientDeviceRunnable(mbClientRunDevice *device, Modbus::ClientPort *port)
 {
-    m_state = STATE_PAUSE;
     m_device = device;
     m_port = port;
-    m_modbusClient = new Modbus::Client(m_device->unit(), m_port);
+    m_scheduleOrder = 0;
+    m_edf = m_device->isEdfScheduling();
+    m_completed = false;
+    m_traceSource = mbClient::TraceSource(m_device->name());
+    m_health.setAdaptiveTimeout(m_device->isAdaptiveTimeout());
+    m_health.setQuarantineErrors(m_device->quarantineErrors());
+    m_health.setBackoffMax(m_device->quarantineBackoffMax());
     createReadMessages();
+    // Note: there is no sense to have more channels than messages can be processed simultaneously
+    // (one extra channel is reserved for write and external messages)
+    int count = 1;
+    if (m_port->isPipelined())
+        count = qMin(static_cast<int>(m_port->pipelineWindow()), m_readMessages.count() + 1);
+    m_channels.resize(count);
+    for (Channels_t::iterator it = m_channels.begin(); it != m_channels.end(); ++it)
+    {
+        it->state = STATE_PAUSE;
+        it->modbusClient = new Modbus::Client(m_device->unit(), m_port);
+    }
 }
 
 mbClientDeviceRunnable::~mbClientDeviceRunnable()
@@ -44,7 +63,8 @@ mbClientDeviceRunnable::~mbClientDeviceRunnable()
     //qDeleteAll(m_writeMessages);
     //delete m_currentMessage;
     //qDeleteAll(m_readMessages);
-    delete m_modbusClient;
+    for (Channels_t::iterator it = m_channels.begin(); it != m_channels.end(); ++it)
+        delete it->modbusClient;
 }
 
 QString mbClientDeviceRunnable::name() const
@@ -52,6 +72,16 @@ QString mbClientDeviceRunnable::name() const
     return m_device->name();
 }
 
+mbClientRunMessagePtr mbClientDeviceRunnable::externalMessage(const Modbus::Client *client) const
+{
+    for (Channels_t::const_iterator it = m_channels.begin(); it != m_channels.end(); ++it)
+    {
+        if ((it->modbusClient == client) && (it->state == STATE_EXEC_EXTERNAL))
+            return it->currentMessage;
+    }
+    return nullptr;
+}
+
 uint16_t mbClientDeviceRunnable::maxReadCount(Modbus::MemoryType mem)
 {
     switch (mem)
@@ -82,61 +112,190 @@ uint16_t mbClientDeviceRunnable::maxWriteCount(Modbus::MemoryType mem)
     }
 }
 
+void mbClientDeviceRunnable::countReadMessages(QHash<uint32_t, int> &counts) const
+{
+    Q_FOREACH (const mbClientRunMessagePtr &m, m_readMessages)
+        counts[m->period()]++;
+}
+
+void mbClientDeviceRunnable::staggerReadMessages(const QHash<uint32_t, int> &counts, QHash<uint32_t, int> &indexes)
+{
+    // Note: it's called before the first 'run()', so all read messages are in the schedule
+    for (Schedule_t::iterator it = m_schedule.begin(); it != m_schedule.end(); ++it)
+    {
+        uint32_t period = it->message->period();
+        int count = counts.value(period, 1);
+        int &index = indexes[period];
+        it->phase = static_cast<qint64>(period) * 1000000LL * index / count;
+        index++;
+    }
+}
+
 void mbClientDeviceRunnable::run()
 {
+    m_completed = false;
     createWriteMessage();
+    for (Channels_t::iterator it = m_channels.begin(); it != m_channels.end(); ++it)
+    {
+        if (it->state != STATE_PAUSE)
+            runChannel(*it);
+    }
+}
+
+mbClientDeviceRunnable::Pending mbClientDeviceRunnable::pending() const
+{
+    if (activeCount() == m_channels.count())
+        return PendingNone;
+    if (m_device->hasExternalMessage() || hasWriteMessage())
+        return PendingUrgent;
+    qint64 now = Modbus::monotonicTime();
+    bool due = m_ready.count() || (m_schedule.count() && (m_schedule.first().due <= now));
+    if (due && m_health.isPollAllowed(now))
+        return PendingRead;
+    return PendingNone;
+}
+
+uint32_t mbClientDeviceRunnable::pendingCost() const
+{
+    const Schedule_t &s = m_ready.count() ? m_ready : m_schedule;
+    if (s.isEmpty())
+        return 0;
+    const mbClientRunMessagePtr &m = s.first().message;
+    uint32_t data;
+    switch (m->function())
+    {
+    case MBF_READ_COILS:
+    case MBF_READ_DISCRETE_INPUTS:
+        data = (m->count() + 7) / 8;
+        break;
+    case MBF_READ_INPUT_REGISTERS:
+    case MBF_READ_HOLDING_REGISTERS:
+        data = m->count() * 2;
+        break;
+    default:
+        data = 1;
+        break;
+    }
+    // request: function, offset, count; response: function, byte count, data
+    return 5 + 2 + data;
+}
+
+bool mbClientDeviceRunnable::start()
+{
+    for (Channels_t::iterator it = m_channels.begin(); it != m_channels.end(); ++it)
+    {
+        if (it->state == STATE_PAUSE)
+        {
+            runChannel(*it);
+            return true;
+        }
+    }
+    return false;
+}
+
+int mbClientDeviceRunnable::activeCount() const
+{
+    int c = 0;
+    for (Channels_t::const_iterator it = m_channels.begin(); it != m_channels.end(); ++it)
+    {
+        if (it->state != STATE_PAUSE)
+            c++;
+    }
+    return c;
+}
+
+int mbClientDeviceRunnable::idleTimeout() const
+{
+    // Note: completed message can free the port for another device or channel
+    if (m_completed || hasWriteMessage() || m_device->hasExternalMessage())
+        return 0;
+    for (Channels_t::const_iterator it = m_channels.begin(); it != m_channels.end(); ++it)
+    {
+        if (it->state != STATE_PAUSE)
+            return IoCheckPeriod;
+    }
+    if (m_schedule.isEmpty() && m_ready.isEmpty())
+        return -1;
+    qint64 due = m_ready.count() ? 0 : m_schedule.first().due;
+    if (m_health.isQuarantined() && (m_health.nextProbe() > due))
+        due = m_health.nextProbe();
+    qint64 t = due - Modbus::monotonicTime();
+    if (t > 0)
+        return static_cast<int>((t + 999999) / 1000000); // nanoseconds to milliseconds rounded up
+    return 0;
+}
+
+bool mbClientDeviceRunnable::hasExternalMessage() const
+{
+    for (Channels_t::const_iterator it = m_channels.begin(); it != m_channels.end(); ++it)
+    {
+        if (it->state == STATE_EXEC_EXTERNAL)
+            return true;
+    }
+    return m_device->hasExternalMessage();
+}
+
+void mbClientDeviceRunnable::runChannel(Channel &channel)
+{
     Modbus::StatusCode r;
     bool fRepeat;
     do
     {
         fRepeat = false;
-        switch (m_state)
+        switch (channel.state)
         {
         case STATE_PAUSE:
             if (m_device->hasExternalMessage())
             {
-                m_device->popExternalMessage(&m_currentMessage);
-                m_currentMessage->prepareToSend();
-                m_state = STATE_EXEC_EXTERNAL;
+                m_device->popExternalMessage(&channel.currentMessage);
+                channel.currentMessage->prepareToSend();
+                channel.modbusClient->setTimeout(m_health.timeout());
+                channel.state = STATE_EXEC_EXTERNAL;
                 fRepeat = true;
                 break;
             }
             if (hasWriteMessage())
             {
-                popWriteMessage(&m_currentMessage);
-                m_currentMessage->prepareToSend();
-                m_state = STATE_EXEC_WRITE;
+                popWriteMessage(&channel.currentMessage);
+                channel.currentMessage->prepareToSend();
+                channel.modbusClient->setTimeout(m_health.timeout());
+                channel.state = STATE_EXEC_WRITE;
                 fRepeat = true;
                 break;
             }
-            if (hasReadMessageOnDuty())
+            if (hasReadMessageOnDuty(channel))
             {
-                m_state = STATE_EXEC_READ;
-                m_currentMessage->prepareToSend();
+                channel.state = STATE_EXEC_READ;
+                channel.currentMessage->prepareToSend();
+                channel.modbusClient->setTimeout(m_health.timeout());
                 fRepeat = true;
                 break;
             }
             break;
         case STATE_EXEC_EXTERNAL:
-            r = execExternalMessage();
+            r = execExternalMessage(channel);
             if (Modbus::StatusIsProcessing(r))
                 return;
-            m_currentMessage = nullptr;
-            m_state = STATE_PAUSE;
+            channel.currentMessage = nullptr;
+            channel.state = STATE_PAUSE;
+            m_completed = true;
             break;
         case STATE_EXEC_WRITE:
-            r = execWriteMessage();
+            r = execWriteMessage(channel);
             if (Modbus::StatusIsProcessing(r))
                 return;
-            m_currentMessage = nullptr;
-            m_state = STATE_PAUSE;
+            channel.currentMessage = nullptr;
+            channel.state = STATE_PAUSE;
+            m_completed = true;
             break;
         case STATE_EXEC_READ:
-            r = execReadMessage();
+            r = execReadMessage(channel);
             if (Modbus::StatusIsProcessing(r))
                 return;
-            m_currentMessage = nullptr;
-            m_state = STATE_PAUSE;
+            completeReadMessage(channel, r);
+            channel.currentMessage = nullptr;
+            channel.state = STATE_PAUSE;
+            m_completed = true;
             break;
         }
     }
@@ -146,50 +305,70 @@ void mbClientDeviceRunnable::run()
 void mbClientDeviceRunnable::createReadMessages()
 {
     QList<mbClientRunItem*> items;
-    m_device->popItemsToRead(items);
-    Q_FOREACH (mbClientRunItem *item, items)
+    if (!m_device->popItemsToRead(items))
+        return;
+
+    mbClientReadPlanner planner;
+    planner.setMaxCount(Modbus::Memory_0x, maxReadCount(Modbus::Memory_0x));
+    planner.setMaxCount(Modbus::Memory_1x, maxReadCount(Modbus::Memory_1x));
+    planner.setMaxCount(Modbus::Memory_3x, maxReadCount(Modbus::Memory_3x));
+    planner.setMaxCount(Modbus::Memory_4x, maxReadCount(Modbus::Memory_4x));
+    planner.setMaxGap(Modbus::Memory_0x, m_device->readGapBits());
+    planner.setMaxGap(Modbus::Memory_1x, m_device->readGapBits());
+    planner.setMaxGap(Modbus::Memory_3x, m_device->readGapRegisters());
+    planner.setMaxGap(Modbus::Memory_4x, m_device->readGapRegisters());
+
+    const mbClientReadPlanner::Requests_t requests = planner.plan(items);
+    Q_FOREACH (const mbClientReadPlanner::Request &r, requests)
     {
         mbClientRunMessagePtr m = nullptr;
-        Q_FOREACH (const mbClientRunMessagePtr &message, m_readMessages)
-        {
-            if (message->addItem(item))
-            {
-                m = message;
-                break;
-            }
-        }
-        if (m == nullptr)
+        uint16_t maxCount = maxReadCount(r.memoryType);
+        mbClientRunItem *item = r.items.first();
+        switch (r.memoryType)
         {
-            switch (item->memoryType())
-            {
-            case Modbus::Memory_0x:
-                m = new mbClientRunMessageReadCoils(item, maxWriteCount(item->memoryType()));
-                pushReadMessage(m);
-                break;
-            case Modbus::Memory_1x:
-                m = new mbClientRunMessageReadDiscreteInputs(item, maxWriteCount(item->memoryType()));
-                pushReadMessage(m);
-                break;
-            case Modbus::Memory_3x:
-                m = new mbClientRunMessageReadInputRegisters(item, maxWriteCount(item->memoryType()));
-                pushReadMessage(m);
-                break;
-            case Modbus::Memory_4x:
-                m = new mbClientRunMessageReadHoldingRegisters(item, maxWriteCount(item->memoryType()));
-                pushReadMessage(m);
-                break;
-            default:
-                delete item;
-                break;
-            }
+        case Modbus::Memory_0x:
+            m = new mbClientRunMessageReadCoils(item, maxCount);
+            break;
+        case Modbus::Memory_1x:
+            m = new mbClientRunMessageReadDiscreteInputs(item, maxCount);
+            break;
+        case Modbus::Memory_3x:
+            m = new mbClientRunMessageReadInputRegisters(item, maxCount);
+            break;
+        case Modbus::Memory_4x:
+            m = new mbClientRunMessageReadHoldingRegisters(item, maxCount);
+            break;
+        default:
+            qDeleteAll(r.items);
+            continue;
         }
+        // Note: items are sorted by offset and request range fits into 'maxCount' so every item is accepted
+        for (int i = 1; i < r.items.count(); i++)
+            m->addItem(r.items.at(i));
+        pushReadMessage(m);
     }
+    mbClient::LogInfo(name(), QStringLiteral("Read plan: %1 items, %2 requests per cycle (%3 without planning)")
+                                    .arg(items.count())
+                                    .arg(m_readMessages.count())
+                                    .arg(planner.firstFitCount(items)));
 }
 
 void mbClientDeviceRunnable::pushReadMessage(const mbClientRunMessagePtr &message)
 {
     message->setDeleteItems(false);
     m_readMessages.append(message);
+    Duty d;
+    d.message = message;
+    d.phase = -1;
+    d.poll = nullptr;
+    if (mbClientStats::Device *stats = m_device->stats())
+    {
+        mb::Address adr;
+        adr.type = message->memoryType();
+        adr.offset = message->offset();
+        d.poll = stats->createPoll(QString("%1[%2]").arg(mb::toString(adr)).arg(message->count()), message->period());
+    }
+    scheduleReadMessage(d, Modbus::monotonicTime());
 }
 
 bool mbClientDeviceRunnable::createWriteMessage()
@@ -248,135 +427,218 @@ bool mbClientDeviceRunnable::popWriteMessage(mbClientRunMessagePtr *message)
     return false;
 }
 
-bool mbClientDeviceRunnable::hasReadMessageOnDuty()
+bool mbClientDeviceRunnable::hasReadMessageOnDuty(Channel &channel)
 {
-    if (m_currentMessage)
+    if (channel.currentMessage)
            return true;
-    mb::Timestamp_t tm = QDateTime::currentMSecsSinceEpoch();
-    for (Messages_t::Iterator it = m_readMessages.begin(); it != m_readMessages.end(); ++it)
+    qint64 now = Modbus::monotonicTime();
+    releaseReadMessages(now);
+    if (m_ready.isEmpty())
+        return false;
+    // Note: quarantined device is polled by single probe request while its due messages are waiting
+    if (!m_health.isPollAllowed(now))
+        return false;
+    if (m_health.isQuarantined())
+        m_health.beginProbe();
+    std::pop_heap(m_ready.begin(), m_ready.end(), m_edf ? isLaterDeadline : isLater);
+    channel.duty = m_ready.last();
+    channel.currentMessage = channel.duty.message;
+    channel.start = now;
+    m_ready.removeLast();
+    return true;
+}
+
+void mbClientDeviceRunnable::scheduleReadMessage(const Duty &duty, qint64 due)
+{
+    Duty d = duty;
+    d.due = due;
+    d.deadline = due + d.message->period() * 1000000LL;
+    d.order = m_scheduleOrder++;
+    m_schedule.append(d);
+    std::push_heap(m_schedule.begin(), m_schedule.end(), isLater);
+}
+
+void mbClientDeviceRunnable::releaseReadMessages(qint64 now)
+{
+    while (m_schedule.count() && (m_schedule.first().due <= now))
     {
-        mbClientRunMessagePtr m = *it;
-        if ((tm - m->timestamp()) >= m->period())
-        {
-            m_readMessages.erase(it);  // remove it from queue ...
-            m_readMessages.enqueue(m); // and push it to back of queue
-            m_currentMessage = m;
-            return true;
-        }
+        std::pop_heap(m_schedule.begin(), m_schedule.end(), isLater);
+        m_ready.append(m_schedule.last());
+        m_schedule.removeLast();
+        std::push_heap(m_ready.begin(), m_ready.end(), m_edf ? isLaterDeadline : isLater);
     }
-    return false;
 }
 
-Modbus::StatusCode mbClientDeviceRunnable::execExternalMessage()
+void mbClientDeviceRunnable::completeReadMessage(Channel &channel, Modbus::StatusCode status)
+{
+    qint64 now = Modbus::monotonicTime();
+    if (channel.duty.poll)
+        channel.duty.poll->record((now - channel.duty.deadline) / 1000, Modbus::StatusIsGood(status)); // nanoseconds to microseconds
+    // Note: EDF keeps the rate of the message (next release is period after the last start),
+    // otherwise the message waits the whole period after its completion
+    qint64 base = m_edf ? channel.start : now;
+    // Note: the first polls are released together, the next ones are shifted by the phase of the message
+    // so polls of the same period don't make burst every period
+    if (channel.duty.phase >= 0)
+    {
+        base = channel.duty.due + channel.duty.phase;
+        channel.duty.phase = -1;
+    }
+    scheduleReadMessage(channel.duty, base + channel.duty.message->period() * 1000000LL);
+    channel.duty.message = nullptr;
+}
+
+void mbClientDeviceRunnable::record(const mbClientRunMessagePtr &message, Modbus::StatusCode status)
+{
+    bool quarantined = m_health.isQuarantined();
+    m_health.record(status, m_port->lastLatency(), m_port->lastRepeatCount(), Modbus::monotonicTime());
+    if (m_health.isQuarantined() != quarantined)
+    {
+        if (quarantined)
+            mbClient::LogInfo(name(), QStringLiteral("Device is online"));
+        else
+            mbClient::LogWarning(name(), QStringLiteral("Device is quarantined after %1 failed requests").arg(m_health.failures()));
+    }
+    if (mbClientStats::Device *stats = m_device->stats())
+    {
+        stats->record(static_cast<uint8_t>(message->function()), status, m_port->lastLatency(), m_port->lastRepeatCount());
+        stats->setHealth(m_health);
+    }
+}
+
+bool mbClientDeviceRunnable::isLater(const Duty &a, const Duty &b)
+{
+    if (a.due != b.due)
+        return a.due > b.due;
+    return a.order > b.order;
+}
+
+bool mbClientDeviceRunnable::isLaterDeadline(const Duty &a, const Duty &b)
+{
+    if (a.deadline != b.deadline)
+        return a.deadline > b.deadline;
+    return a.order > b.order;
+}
+
+Modbus::StatusCode mbClientDeviceRunnable::execExternalMessage(Channel &channel)
 {
+    Modbus::Client *client = channel.modbusClient;
+    const mbClientRunMessagePtr &message = channel.currentMessage;
     Modbus::StatusCode res;
-    int func = m_currentMessage->function();
+    int func = message->function();
     switch (func)
     {
     case MBF_READ_COILS:
-        res = m_modbusClient->readCoils(m_currentMessage->offset(), m_currentMessage->count(), m_currentMessage->innerBuffer());
+        res = client->readCoils(message->offset(), message->count(), message->innerBuffer());
         break;
     case MBF_READ_DISCRETE_INPUTS:
-        res = m_modbusClient->readDiscreteInputs(m_currentMessage->offset(), m_currentMessage->count(), m_currentMessage->innerBuffer());
+        res = client->readDiscreteInputs(message->offset(), message->count(), message->innerBuffer());
         break;
     case MBF_READ_INPUT_REGISTERS:
-        res = m_modbusClient->readInputRegisters(m_currentMessage->offset(), m_currentMessage->count(), reinterpret_cast<uint16_t*>(m_currentMessage->innerBuffer()));
+        res = client->readInputRegisters(message->offset(), message->count(), reinterpret_cast<uint16_t*>(message->innerBuffer()));
         break;
     case MBF_READ_HOLDING_REGISTERS:
-        res = m_modbusClient->readHoldingRegisters(m_currentMessage->offset(), m_currentMessage->count(), reinterpret_cast<uint16_t*>(m_currentMessage->innerBuffer()));
+        res = client->readHoldingRegisters(message->offset(), message->count(), reinterpret_cast<uint16_t*>(message->innerBuffer()));
         break;
     case MBF_READ_EXCEPTION_STATUS:
-        res = m_modbusClient->readExceptionStatus(reinterpret_cast<uint8_t*>(m_currentMessage->innerBuffer()));
+        res = client->readExceptionStatus(reinterpret_cast<uint8_t*>(message->innerBuffer()));
         break;
     case MBF_WRITE_SINGLE_COIL:
-        res = m_modbusClient->writeSingleCoil(m_currentMessage->offset(), *reinterpret_cast<const bool*>(m_currentMessage->innerBuffer()));
+        res = client->writeSingleCoil(message->offset(), *reinterpret_cast<const bool*>(message->innerBuffer()));
         break;
     case MBF_WRITE_SINGLE_REGISTER:
-        res = m_modbusClient->writeSingleRegister(m_currentMessage->offset(), *reinterpret_cast<const uint16_t*>(m_currentMessage->innerBuffer()));
+        res = client->writeSingleRegister(message->offset(), *reinterpret_cast<const uint16_t*>(message->innerBuffer()));
         break;
     case MBF_WRITE_MULTIPLE_COILS:
-        res = m_modbusClient->writeMultipleCoils(m_currentMessage->offset(), m_currentMessage->count(), m_currentMessage->innerBuffer());
+        res = client->writeMultipleCoils(message->offset(), message->count(), message->innerBuffer());
         break;
     case MBF_WRITE_MULTIPLE_REGISTERS:
-        res = m_modbusClient->writeMultipleRegisters(m_currentMessage->offset(), m_currentMessage->count(), reinterpret_cast<const uint16_t*>(m_currentMessage->innerBuffer()));
+        res = client->writeMultipleRegisters(message->offset(), message->count(), reinterpret_cast<const uint16_t*>(message->innerBuffer()));
         break;
     default:
         return Modbus::Status_Bad;
     }
     if (Modbus::StatusIsProcessing(res))
         return res;
+    record(message, res);
     if (Modbus::StatusIsBad(res))
     {
         QString text = m_port->lastErrorText();
         mbClient::LogError(m_device->name(), text);
     }
-    m_currentMessage->setComplete(res, QDateTime::currentMSecsSinceEpoch());
+    message->setComplete(res, QDateTime::currentMSecsSinceEpoch());
     return res;
 }
 
-Modbus::StatusCode mbClientDeviceRunnable::execWriteMessage()
+Modbus::StatusCode mbClientDeviceRunnable::execWriteMessage(Channel &channel)
 {
+    Modbus::Client *client = channel.modbusClient;
+    const mbClientRunMessagePtr &message = channel.currentMessage;
     Modbus::StatusCode res;
-    int func = m_currentMessage->function();
+    int func = message->function();
     switch (func)
     {
     case MBF_WRITE_SINGLE_COIL:
-        res = m_modbusClient->writeSingleCoil(m_currentMessage->offset(), *reinterpret_cast<const bool*>(m_currentMessage->innerBuffer()));
+        res = client->writeSingleCoil(message->offset(), *reinterpret_cast<const bool*>(message->innerBuffer()));
         break;
     case MBF_WRITE_SINGLE_REGISTER:
-        res = m_modbusClient->writeSingleRegister(m_currentMessage->offset(), *reinterpret_cast<const uint16_t*>(m_currentMessage->innerBuffer()));
+        res = client->writeSingleRegister(message->offset(), *reinterpret_cast<const uint16_t*>(message->innerBuffer()));
         break;
     case MBF_WRITE_MULTIPLE_COILS:
-        res = m_modbusClient->writeMultipleCoils(m_currentMessage->offset(), m_currentMessage->count(), m_currentMessage->innerBuffer());
+        res = client->writeMultipleCoils(message->offset(), message->count(), message->innerBuffer());
         break;
     case MBF_WRITE_MULTIPLE_REGISTERS:
-        res = m_modbusClient->writeMultipleRegisters(m_currentMessage->offset(), m_currentMessage->count(), reinterpret_cast<const uint16_t*>(m_currentMessage->innerBuffer()));
+        res = client->writeMultipleRegisters(message->offset(), message->count(), reinterpret_cast<const uint16_t*>(message->innerBuffer()));
         break;
     default:
         return Modbus::Status_Bad;
     }
     if (Modbus::StatusIsProcessing(res))
         return res;
+    record(message, res);
     if (Modbus::StatusIsBad(res))
     {
         QString text = m_port->lastErrorText();
         mbClient::LogError(m_device->name(), text);
     }
-    m_currentMessage->setComplete(res, QDateTime::currentMSecsSinceEpoch());
+    message->setComplete(res, QDateTime::currentMSecsSinceEpoch());
     return res;
 }
 
-Modbus::StatusCode mbClientDeviceRunnable::execReadMessage()
+Modbus::StatusCode mbClientDeviceRunnable::execReadMessage(Channel &channel)
 {
+    Modbus::Client *client = channel.modbusClient;
+    const mbClientRunMessagePtr &message = channel.currentMessage;
     Modbus::StatusCode res;
-    int func = m_currentMessage->function();
+    int func = message->function();
     switch (func)
     {
     case MBF_READ_COILS:
-        res = m_modbusClient->readCoils(m_currentMessage->offset(), m_currentMessage->count(), m_currentMessage->innerBuffer());
+        res = client->readCoils(message->offset(), message->count(), message->innerBuffer());
         break;
     case MBF_READ_DISCRETE_INPUTS:
-        res = m_modbusClient->readDiscreteInputs(m_currentMessage->offset(), m_currentMessage->count(), m_currentMessage->innerBuffer());
+        res = client->readDiscreteInputs(message->offset(), message->count(), message->innerBuffer());
         break;
     case MBF_READ_INPUT_REGISTERS:
-        res = m_modbusClient->readInputRegisters(m_currentMessage->offset(), m_currentMessage->count(), reinterpret_cast<uint16_t*>(m_currentMessage->innerBuffer()));
+        res = client->readInputRegisters(message->offset(), message->count(), reinterpret_cast<uint16_t*>(message->innerBuffer()));
         break;
     case MBF_READ_HOLDING_REGISTERS:
-        res = m_modbusClient->readHoldingRegisters(m_currentMessage->offset(), m_currentMessage->count(), reinterpret_cast<uint16_t*>(m_currentMessage->innerBuffer()));
+        res = client->readHoldingRegisters(message->offset(), message->count(), reinterpret_cast<uint16_t*>(message->innerBuffer()));
         break;
     case MBF_READ_EXCEPTION_STATUS:
-        res = m_modbusClient->readExceptionStatus(reinterpret_cast<uint8_t*>(m_currentMessage->innerBuffer()));
+        res = client->readExceptionStatus(reinterpret_cast<uint8_t*>(message->innerBuffer()));
         break;
     default:
         return Modbus::Status_Bad;
     }
     if (Modbus::StatusIsProcessing(res))
         return res;
+    record(message, res);
     if (Modbus::StatusIsBad(res))
     {
         QString text = m_port->lastErrorText();
         mbClient::LogError(m_device->name(), text);
     }
-    m_currentMessage->setComplete(res, QDateTime::currentMSecsSinceEpoch());
+    message->setComplete(res, QDateTime::currentMSecsSinceEpoch());
     return res;
 }
@@ -23,12 +23,17 @@
 #ifndef CLIENT_DEVICERUNNABLE_H
 #define CLIENT_DEVICERUNNABLE_H
 
+#include <QHash>
 #include <QQueue>
+#include <QVector>
 #include <QRunnable>
 
 #include <Modbus.h>
 #include <client_global.h>
 
+#include "client_devicehealth.h"
+#include "client_stats.h"
+
 namespace Modbus {
 
 class ClientPort;
@@ -49,22 +54,88 @@ public:
         STATE_EXEC_READ
     };
 
+    // kind of the message the device can start now
+    enum Pending
+    {
+        PendingNone  , // there is no free channel or message to start
+        PendingRead  , // read message is on duty
+        PendingUrgent  // external or write message is waiting
+    };
+
 public:
     mbClientDeviceRunnable(mbClientRunDevice *device, Modbus::ClientPort *port);
     virtual ~mbClientDeviceRunnable();
 
 public:
     QString name() const;
+    inline int traceSource() const { return m_traceSource; }
     inline mbClientRunDevice *device() const { return m_device; }
-    inline Modbus::Client *modbusClient() const { return m_modbusClient; }
-    inline mbClientRunMessagePtr currentMessage() const { return m_currentMessage; }
+    inline const mbClientDeviceHealth &health() const { return m_health; }
+    inline int channelCount() const { return m_channels.count(); }
+    inline Modbus::Client *modbusClient(int i = 0) const { return m_channels.at(i).modbusClient; }
+    // message being processed by the client as external one (only external message needs its Tx/Rx bytes)
+    mbClientRunMessagePtr externalMessage(const Modbus::Client *client) const;
 
 public:
     uint16_t maxReadCount(Modbus::MemoryType mem);
     uint16_t maxWriteCount(Modbus::MemoryType mem);
 
 public:
+    // adds count of read messages of every period (milliseconds) to 'counts'
+    void countReadMessages(QHash<uint32_t, int> &counts) const;
+    // spreads polls of read messages of the same period over the period: after the first poll
+    // message is released with phase 'index * period / count', 'indexes' keeps the next index of every period
+    void staggerReadMessages(const QHash<uint32_t, int> &counts, QHash<uint32_t, int> &indexes);
+
+public:
+    // processes messages being executed, new message is started by 'start()' only
     void run() override;
+    Pending pending() const;
+    // approximate size (bytes) of the request and response of the next read message
+    uint32_t pendingCost() const;
+    // starts the next message (external, write, then read) on a free channel
+    bool start();
+    // count of channels executing a message
+    int activeCount() const;
+    // at least one message was completed by last 'run()' or 'start()' call
+    inline bool isCompleted() const { return m_completed; }
+    // time (milliseconds) caller can wait before next 'run()' call:
+    // 0 - call 'run()' immediately, -1 - there is no scheduled message
+    int idleTimeout() const;
+    // external message is waiting or being processed (its Tx/Rx bytes must be delivered to the message)
+    bool hasExternalMessage() const;
+
+public:
+    // period (milliseconds) to check timeouts of requests waiting for response,
+    // incoming data wakes the caller earlier
+    static const int IoCheckPeriod = 1;
+
+private:
+    // Note: read messages being processed are not in the schedule,
+    // they are pushed back with the new release time when completed
+    struct Duty
+    {
+        qint64 due; // release time, monotonic, nanoseconds
+        qint64 deadline; // release time plus period, monotonic, nanoseconds
+        qint64 phase; // offset (nanoseconds) of the second release, -1 if it's not used
+        quint64 order; // keeps FIFO order for messages with the same due time
+        mbClientRunMessagePtr message;
+        mbClientStats::Poll *poll; // deadline accounting, nullptr if there is no statistics
+    };
+
+    // Note: every channel has its own Modbus::Client so several requests
+    // of the device can be processed simultaneously by pipelined port
+    struct Channel
+    {
+        State state;
+        Modbus::Client *modbusClient;
+        mbClientRunMessagePtr currentMessage;
+        Duty duty; // read message being processed
+        qint64 start; // monotonic time the read message was started at, nanoseconds
+    };
+
+private:
+    void runChannel(Channel &channel);
 
 private:
     void createReadMessages();
@@ -77,27 +148,43 @@ private:
     bool popWriteMessage(mbClientRunMessagePtr *message);
 
 private:
-    bool hasReadMessageOnDuty();
+    bool hasReadMessageOnDuty(Channel &channel);
+    void scheduleReadMessage(const Duty &duty, qint64 due);
+    void releaseReadMessages(qint64 now);
+    // 'status' is the result of the poll, failed poll is counted as deadline miss
+    void completeReadMessage(Channel &channel, Modbus::StatusCode status);
 
 private:
-    Modbus::StatusCode execExternalMessage();
-    Modbus::StatusCode execWriteMessage();
-    Modbus::StatusCode execReadMessage();
+    void record(const mbClientRunMessagePtr &message, Modbus::StatusCode status);
 
 private:
-    State m_state;
+    Modbus::StatusCode execExternalMessage(Channel &channel);
+    Modbus::StatusCode execWriteMessage(Channel &channel);
+    Modbus::StatusCode execReadMessage(Channel &channel);
 
 private:
     mbClientRunDevice *m_device;
     Modbus::ClientPort *m_port;
-    Modbus::Client *m_modbusClient;
+    int m_traceSource;
+    typedef QVector<Channel> Channels_t;
+    Channels_t m_channels;
+    bool m_completed; // at least one message was completed by last 'run()' call
+    mbClientDeviceHealth m_health;
 
 private:
     typedef QQueue<mbClientRunMessagePtr> Messages_t;
     Messages_t m_writeMessages;
     Messages_t m_readMessages;
 
-    mbClientRunMessagePtr m_currentMessage;
+private:
+    static bool isLater(const Duty &a, const Duty &b);
+    static bool isLaterDeadline(const Duty &a, const Duty &b);
+    typedef QVector<Duty> Schedule_t;
+    Schedule_t m_schedule; // binary min-heap by release time
+    // released messages: binary min-heap by deadline (EDF) or by release time
+    Schedule_t m_ready;
+    bool m_edf;
+    quint64 m_scheduleOrder;
 };
 
 #endif // CLIENT_DEVICERUNNABLE_H
@@ -0,0 +1,98 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "client_portarbiter.h"
+
+#include "client_devicerunnable.h"
+
+mbClientPortArbiter::mbClientPortArbiter()
+{
+    m_urgent = 0;
+    m_current = 0;
+    m_turn = false;
+}
+
+void mbClientPortArbiter::addDevice(mbClientDeviceRunnable *device, uint32_t weight, uint8_t priority)
+{
+    Entry e;
+    e.device = device;
+    e.quantum = (weight > 0 ? weight : 1) * Quantum;
+    e.priority = priority;
+    e.deficit = 0;
+    m_entries.append(e);
+}
+
+mbClientDeviceRunnable *mbClientPortArbiter::select(bool urgent, bool read)
+{
+    const int n = m_entries.count();
+    if (urgent)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            int k = (m_urgent + i) % n;
+            if (m_entries.at(k).device->pending() == mbClientDeviceRunnable::PendingUrgent)
+            {
+                m_urgent = (k + 1) % n;
+                return m_entries.at(k).device;
+            }
+        }
+    }
+    if (!read)
+        return nullptr;
+
+    bool found = false;
+    uint8_t priority = 0;
+    for (Entries_t::const_iterator it = m_entries.constBegin(); it != m_entries.constEnd(); ++it)
+    {
+        if ((it->device->pending() == mbClientDeviceRunnable::PendingRead) && (!found || (it->priority > priority)))
+        {
+            priority = it->priority;
+            found = true;
+        }
+    }
+    if (!found)
+        return nullptr;
+
+    // Note: loop is finite because every turn of the device with due message adds quantum to its deficit
+    for (;;)
+    {
+        Entry &e = m_entries[m_current];
+        if ((e.priority == priority) && (e.device->pending() == mbClientDeviceRunnable::PendingRead))
+        {
+            if (!m_turn)
+            {
+                e.deficit += e.quantum;
+                m_turn = true;
+            }
+            uint32_t cost = e.device->pendingCost();
+            if (cost <= e.deficit)
+            {
+                e.deficit -= cost;
+                return e.device;
+            }
+        }
+        else
+            e.deficit = 0; // device without due message doesn't save its credit
+        m_current = (m_current + 1) % n;
+        m_turn = false;
+    }
+}
@@ -0,0 +1,68 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef CLIENT_PORTARBITER_H
+#define CLIENT_PORTARBITER_H
+
+#include <QVector>
+
+#include <client_global.h>
+
+class mbClientDeviceRunnable;
+
+// Decides which device of the port starts the next request when the port has free slot:
+// external and write messages take the next free slot (devices are served by turns),
+// read messages are shared between devices of the highest priority that have due messages
+// by deficit round robin, so every device gets the share of the port proportional to its weight
+class mbClientPortArbiter
+{
+public:
+    // credit (bytes) of the device with weight 1 per round, it covers the cost of the largest read request
+    static const uint32_t Quantum = 260;
+
+public:
+    mbClientPortArbiter();
+
+public:
+    void addDevice(mbClientDeviceRunnable *device, uint32_t weight, uint8_t priority);
+    // returns device to start the next message or nullptr if there is no message that can be started:
+    // 'urgent' - the port has free slot for external/write message, 'read' - for read message
+    mbClientDeviceRunnable *select(bool urgent, bool read);
+
+private:
+    struct Entry
+    {
+        mbClientDeviceRunnable *device;
+        uint32_t quantum;
+        uint8_t priority;
+        uint32_t deficit;
+    };
+    typedef QVector<Entry> Entries_t;
+
+private:
+    Entries_t m_entries;
+    int m_urgent; // device to check first for external/write message
+    int m_current; // device which has the turn to read
+    bool m_turn; // quantum is already added for the current turn
+};
+
+#endif // CLIENT_PORTARBITER_H
@@ -40,6 +40,7 @@ mbClientPortRunnable::mbClientPortRunnable(const Modbus::Settings &settings, con
     m_devices = devices;
     m_port = Modbus::createClientPort(settings);
     // Note: m_port can NOT be nullptr
+    m_port->setTraceEnabled(false);
     if (m_port->type() == Modbus::ASC)
     {
         connect(m_port->port(), &Modbus::Port::signalTx, this, &mbClientPortRunnable::slotAsciiTx);
@@ -50,14 +51,26 @@ mbClientPortRunnable::mbClientPortRunnable(const Modbus::Settings &settings, con
         connect(m_port->port(), &Modbus::Port::signalTx, this, &mbClientPortRunnable::slotBytesTx);
         connect(m_port->port(), &Modbus::Port::signalRx, this, &mbClientPortRunnable::slotBytesRx);
     }
+    connect(m_port->port(), &Modbus::Port::signalMessage, this, &mbClientPortRunnable::slotMessage);
+    m_discarded = 0;
 
     Q_FOREACH (mbClientRunDevice *device, m_devices)
     {
         mbClientDeviceRunnable *d = new mbClientDeviceRunnable(device, m_port);
         m_runnables.append(d);
-        m_hashRunnables.insert(d->modbusClient(), d);
+        m_arbiter.addDevice(d, device->pollWeight(), device->pollPriority());
+        for (int i = 0; i < d->channelCount(); i++)
+            m_hashRunnables.insert(d->modbusClient(i), d);
     }
+    // Note: polls of the same period are spread over the period across all devices of the port
+    QHash<uint32_t, int> counts;
+    QHash<uint32_t, int> indexes;
+    Q_FOREACH (mbClientDeviceRunnable *d, m_runnables)
+        d->countReadMessages(counts);
+    Q_FOREACH (mbClientDeviceRunnable *d, m_runnables)
+        d->staggerReadMessages(counts, indexes);
     setName(settings.value(mbClientPort::Strings::instance().name).toString());
+    m_traceSource = mbClient::TraceSource(name());
 }
 
 mbClientPortRunnable::~mbClientPortRunnable()
@@ -70,8 +83,27 @@ mbClientPortRunnable::~mbClientPortRunnable()
 
 void mbClientPortRunnable::run()
 {
+    // Note: Port doesn't copy Tx/Rx bytes when nobody needs them
+    m_port->setTraceEnabled(isTraceNeeded());
     Q_FOREACH (mbClientDeviceRunnable *d, m_runnables)
         d->run();
+    // Note: free slots of the port are given by the arbiter, so device with many due messages
+    // can't starve other devices and external/write message waits for active requests only
+    while (mbClientDeviceRunnable *d = m_arbiter.select(freeSlots(true) > 0, freeSlots(false) > 0))
+    {
+        if (!d->start())
+            break;
+    }
+    quint64 discarded = m_port->port()->discardedBytes();
+    if (discarded != m_discarded)
+    {
+        m_discarded = discarded;
+        Q_FOREACH (mbClientRunDevice *device, m_devices)
+        {
+            if (mbClientStats::Device *stats = device->stats())
+                stats->setDiscarded(discarded);
+        }
+    }
 }
 
 void mbClientPortRunnable::close()
@@ -79,17 +111,69 @@ void mbClientPortRunnable::close()
     m_port->close();
 }
 
+int mbClientPortRunnable::idleTimeout() const
+{
+    int timeout = -1;
+    Q_FOREACH (mbClientDeviceRunnable *d, m_runnables)
+    {
+        int t = d->idleTimeout();
+        // Note: message that can't be started until the port has free slot waits for active requests
+        if ((t == 0) && !d->isCompleted())
+        {
+            mbClientDeviceRunnable::Pending p = d->pending();
+            if ((p == mbClientDeviceRunnable::PendingNone) || (freeSlots(p == mbClientDeviceRunnable::PendingUrgent) <= 0))
+                t = mbClientDeviceRunnable::IoCheckPeriod;
+        }
+        if (t == 0)
+            return 0;
+        if ((t > 0) && ((timeout < 0) || (t < timeout)))
+            timeout = t;
+    }
+    return timeout;
+}
+
+int mbClientPortRunnable::freeSlots(bool urgent) const
+{
+    int window = m_port->isPipelined() ? static_cast<int>(m_port->pipelineWindow()) : 1;
+    if (!urgent && (window > 1))
+        window--;
+    Q_FOREACH (mbClientDeviceRunnable *d, m_runnables)
+        window -= d->activeCount();
+    return window;
+}
+
+bool mbClientPortRunnable::isTraceNeeded() const
+{
+    if (mbClient::IsTraceTxRx())
+        return true;
+    Q_FOREACH (mbClientDeviceRunnable *d, m_runnables)
+    {
+        if (d->hasExternalMessage())
+            return true;
+    }
+    return false;
+}
+
+void mbClientPortRunnable::trace(const Modbus::Client *c, mbCoreTraceRing::Direction direction, mbCoreTraceRing::Format format, const QByteArray &bytes)
+{
+    if (!mbClient::IsTraceTxRx())
+        return;
+    mbClientDeviceRunnable *r = deviceRunnable(c);
+    mbClient::TraceTxRx(r ? r->traceSource() : m_traceSource, direction, format, bytes);
+}
+
 void mbClientPortRunnable::slotBytesTx(const QByteArray &bytes)
 {
     const Modbus::Client *c = reinterpret_cast<const Modbus::Client*>(m_port->currentClient());
     mbClientDeviceRunnable *r = deviceRunnable(c);
     if (r)
     {
-        r->currentMessage()->setBytesTx(bytes);
-        mbClient::LogTxRx(r->name(), "Tx: " + Modbus::bytesToString(bytes));
+        // Note: read/write messages don't keep Tx/Rx bytes, so trace buffer of the port is not detached
+        mbClientRunMessagePtr m = r->externalMessage(c);
+        if (m)
+            m->setBytesTx(bytes);
     }
-    else
-        mbClient::LogTxRx(name(), "Tx: " + Modbus::bytesToString(bytes));
+    trace(c, mbCoreTraceRing::Tx, mbCoreTraceRing::Bytes, bytes);
 }
 
 void mbClientPortRunnable::slotBytesRx(const QByteArray &bytes)
@@ -98,11 +182,12 @@ void mbClientPortRunnable::slotBytesRx(const QByteArray &bytes)
     mbClientDeviceRunnable *r = deviceRunnable(c);
     if (r)
     {
-        r->currentMessage()->setBytesRx(bytes);
-        mbClient::LogTxRx(r->name(), "Rx: " + Modbus::bytesToString(bytes));
+        // Note: read/write messages don't keep Tx/Rx bytes, so trace buffer of the port is not detached
+        mbClientRunMessagePtr m = r->externalMessage(c);
+        if (m)
+            m->setBytesRx(bytes);
     }
-    else
-        mbClient::LogTxRx(name(), "Rx: " + Modbus::bytesToString(bytes));
+    trace(c, mbCoreTraceRing::Rx, mbCoreTraceRing::Bytes, bytes);
 }
 
 void mbClientPortRunnable::slotAsciiTx(const QByteArray &bytes)
@@ -111,11 +196,12 @@ void mbClientPortRunnable::slotAsciiTx(const QByteArray &bytes)
     mbClientDeviceRunnable *r = deviceRunnable(c);
     if (r)
     {
-        r->currentMessage()->setAsciiTx(bytes);
-        mbClient::LogTxRx(r->name(), "Tx: " + Modbus::asciiToString(bytes));
+        // Note: read/write messages don't keep Tx/Rx bytes, so trace buffer of the port is not detached
+        mbClientRunMessagePtr m = r->externalMessage(c);
+        if (m)
+            m->setAsciiTx(bytes);
     }
-    else
-        mbClient::LogTxRx(name(), "Tx: " + Modbus::asciiToString(bytes));
+    trace(c, mbCoreTraceRing::Tx, mbCoreTraceRing::Ascii, bytes);
 }
 
 void mbClientPortRunnable::slotAsciiRx(const QByteArray &bytes)
@@ -124,9 +210,15 @@ void mbClientPortRunnable::slotAsciiRx(const QByteArray &bytes)
     mbClientDeviceRunnable *r = deviceRunnable(c);
     if (r)
     {
-        r->currentMessage()->setAsciiRx(bytes);
-        mbClient::LogTxRx(r->name(), "Rx: " + Modbus::asciiToString(bytes));
+        // Note: read/write messages don't keep Tx/Rx bytes, so trace buffer of the port is not detached
+        mbClientRunMessagePtr m = r->externalMessage(c);
+        if (m)
+            m->setAsciiRx(bytes);
     }
-    else
-        mbClient::LogTxRx(name(), "Rx: " + Modbus::asciiToString(bytes));
+    trace(c, mbCoreTraceRing::Rx, mbCoreTraceRing::Ascii, bytes);
+}
+
+void mbClientPortRunnable::slotMessage(const QString &message)
+{
+    mbClient::LogInfo(name(), message);
 }
@@ -27,6 +27,10 @@
 
 #include <client_global.h>
 
+#include <runtime/core_tracering.h>
+
+#include "client_portarbiter.h"
+
 namespace Modbus {
 
 class Client;
@@ -51,18 +55,28 @@ public:
 public:
     void run();
     void close();
+    // time (milliseconds) caller can wait before next 'run()' call, -1 - there is no scheduled message
+    int idleTimeout() const;
 
 private:
     inline mbClientDeviceRunnable *deviceRunnable(const Modbus::Client *c) const { return m_hashRunnables.value(c); }
+    // count of messages that can be started now: read messages leave one slot
+    // of the pipeline window for external and write messages
+    int freeSlots(bool urgent) const;
+    bool isTraceNeeded() const;
+    void trace(const Modbus::Client *c, mbCoreTraceRing::Direction direction, mbCoreTraceRing::Format format, const QByteArray &bytes);
 
 private Q_SLOTS:
     void slotBytesTx(const QByteArray &bytes);
     void slotBytesRx(const QByteArray &bytes);
     void slotAsciiTx(const QByteArray &bytes);
     void slotAsciiRx(const QByteArray &bytes);
+    void slotMessage(const QString &message);
 
 private:
     Modbus::ClientPort *m_port;
+    int m_traceSource;
+    quint64 m_discarded;
 
 private:
     QList<mbClientRunDevice*> m_devices;
@@ -73,6 +87,7 @@ private:
     
     Runnables_t m_runnables;
     HashRunnables_t m_hashRunnables;
+    mbClientPortArbiter m_arbiter;
 };
 
 #endif // CLIENT_PORTRUNNABLE_H
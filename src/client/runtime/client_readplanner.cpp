@@ -0,0 +1,162 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "client_readplanner.h"
+
+#include <algorithm>
+
+#include "client_runitem.h"
+
+mbClientReadPlanner::mbClientReadPlanner()
+{
+    for (int i = 0; i < MemoryTypeCount; i++)
+    {
+        m_maxCount[i] = 1;
+        m_maxGap[i] = 0;
+    }
+}
+
+uint16_t mbClientReadPlanner::maxCount(Modbus::MemoryType mem) const
+{
+    if (isValid(mem))
+        return m_maxCount[mem];
+    return 0;
+}
+
+void mbClientReadPlanner::setMaxCount(Modbus::MemoryType mem, uint16_t maxCount)
+{
+    if (isValid(mem) && maxCount > 0)
+        m_maxCount[mem] = maxCount;
+}
+
+uint16_t mbClientReadPlanner::maxGap(Modbus::MemoryType mem) const
+{
+    if (isValid(mem))
+        return m_maxGap[mem];
+    return 0;
+}
+
+void mbClientReadPlanner::setMaxGap(Modbus::MemoryType mem, uint16_t maxGap)
+{
+    if (isValid(mem))
+        m_maxGap[mem] = maxGap;
+}
+
+mbClientReadPlanner::Requests_t mbClientReadPlanner::plan(const QList<mbClientRunItem*> &items) const
+{
+    QList<mbClientRunItem*> sorted = items;
+    std::sort(sorted.begin(), sorted.end(), isLess);
+
+    // Note: requests are contiguous runs of sorted items, so greedy extension of the current request
+    // gives minimal request count (any run shortened from the beginning stays valid)
+    Requests_t requests;
+    Q_FOREACH (mbClientRunItem *item, sorted)
+    {
+        Modbus::MemoryType mem = item->memoryType();
+        int itemBegin = item->offset();
+        int itemEnd = itemBegin + item->count();
+        if (requests.count() && isValid(mem))
+        {
+            Request &r = requests.last();
+            int end = r.offset + r.count;
+            int newEnd = qMax(end, itemEnd);
+            if ((r.memoryType == mem) &&
+                (r.period == item->period()) &&
+                (itemBegin - end <= m_maxGap[mem]) &&
+                (newEnd - r.offset <= m_maxCount[mem]))
+            {
+                r.count = static_cast<uint16_t>(newEnd - r.offset);
+                r.items.append(item);
+                continue;
+            }
+        }
+        Request r;
+        r.memoryType = mem;
+        r.period = item->period();
+        r.offset = item->offset();
+        r.count = item->count();
+        r.items.append(item);
+        requests.append(r);
+    }
+    return requests;
+}
+
+int mbClientReadPlanner::firstFitCount(const QList<mbClientRunItem*> &items) const
+{
+    struct Range
+    {
+        Modbus::MemoryType memoryType;
+        uint32_t period;
+        int offset;
+        int count;
+        int maxCount;
+    };
+    QVector<Range> ranges;
+    Q_FOREACH (const mbClientRunItem *item, items)
+    {
+        int itemOffset = item->offset();
+        int nextItemOffset = itemOffset + item->count();
+        bool added = false;
+        for (QVector<Range>::iterator it = ranges.begin(); it != ranges.end(); ++it)
+        {
+            Range &r = *it;
+            if ((r.memoryType != item->memoryType()) || (r.period != item->period()))
+                continue;
+            if ((itemOffset >= r.offset) && (nextItemOffset <= (r.offset + r.maxCount)))
+            {
+                if (nextItemOffset >= (r.offset + r.count))
+                    r.count = nextItemOffset - r.offset;
+                added = true;
+                break;
+            }
+            if ((itemOffset < r.offset) && ((itemOffset + r.maxCount) >= (r.offset + r.count)))
+            {
+                r.count += (r.offset - itemOffset);
+                r.offset = itemOffset;
+                added = true;
+                break;
+            }
+        }
+        if (!added)
+        {
+            Range r;
+            r.memoryType = item->memoryType();
+            r.period = item->period();
+            r.offset = itemOffset;
+            r.count = item->count();
+            r.maxCount = maxCount(item->memoryType());
+            ranges.append(r);
+        }
+    }
+    return ranges.count();
+}
+
+bool mbClientReadPlanner::isLess(const mbClientRunItem *a, const mbClientRunItem *b)
+{
+    if (a->memoryType() != b->memoryType())
+        return a->memoryType() < b->memoryType();
+    if (a->period() != b->period())
+        return a->period() < b->period();
+    if (a->offset() != b->offset())
+        return a->offset() < b->offset();
+    return a->count() > b->count();
+}
@@ -0,0 +1,72 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef CLIENT_READPLANNER_H
+#define CLIENT_READPLANNER_H
+
+#include <QVector>
+
+#include <client_global.h>
+
+class mbClientRunItem;
+
+// Splits items to read into minimal number of requests: items are sorted by memory type,
+// period and offset and every request is extended while it fits into max request size
+// and the gap between its end and the next item doesn't exceed max gap
+class mbClientReadPlanner
+{
+public:
+    struct Request
+    {
+        Modbus::MemoryType memoryType;
+        uint32_t period;
+        uint16_t offset;
+        uint16_t count;
+        QList<mbClientRunItem*> items;
+    };
+    typedef QVector<Request> Requests_t;
+
+public:
+    mbClientReadPlanner();
+
+public:
+    uint16_t maxCount(Modbus::MemoryType mem) const;
+    void setMaxCount(Modbus::MemoryType mem, uint16_t maxCount);
+    uint16_t maxGap(Modbus::MemoryType mem) const;
+    void setMaxGap(Modbus::MemoryType mem, uint16_t maxGap);
+
+public:
+    Requests_t plan(const QList<mbClientRunItem*> &items) const;
+    // count of requests made by merging items in given order (previous algorithm), used to report the gain
+    int firstFitCount(const QList<mbClientRunItem*> &items) const;
+
+private:
+    static bool isLess(const mbClientRunItem *a, const mbClientRunItem *b);
+    static inline bool isValid(Modbus::MemoryType mem) { return (mem >= 0) && (mem < MemoryTypeCount); }
+
+private:
+    enum { MemoryTypeCount = Modbus::Memory_4x + 1 };
+    uint16_t m_maxCount[MemoryTypeCount];
+    uint16_t m_maxGap[MemoryTypeCount];
+};
+
+#endif // CLIENT_READPLANNER_H
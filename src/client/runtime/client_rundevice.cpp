@@ -22,6 +22,9 @@
 */
 #include "client_rundevice.h"
 
+#include <QThread>
+#include <QAbstractEventDispatcher>
+
 #include <project/client_device.h>
 #include "client_runitem.h"
 #include "client_runmessage.h"
@@ -29,6 +32,16 @@
 mbClientRunDevice::mbClientRunDevice(const Modbus::Settings &settings)
 {
     // TODO: make default settings values
+    m_runThread = nullptr;
+    m_stats = nullptr;
+    m_settings.readGapRegisters = mbClientDevice::Defaults::instance().readGapRegisters;
+    m_settings.readGapBits      = mbClientDevice::Defaults::instance().readGapBits;
+    m_settings.adaptiveTimeout      = mbClientDevice::Defaults::instance().adaptiveTimeout;
+    m_settings.quarantineErrors     = mbClientDevice::Defaults::instance().quarantineErrors;
+    m_settings.quarantineBackoffMax = mbClientDevice::Defaults::instance().quarantineBackoffMax;
+    m_settings.pollWeight           = mbClientDevice::Defaults::instance().pollWeight;
+    m_settings.pollPriority         = mbClientDevice::Defaults::instance().pollPriority;
+    m_settings.edfScheduling        = mbClientDevice::Defaults::instance().edfScheduling;
     setSettings(settings);
 }
 
@@ -57,14 +70,18 @@ bool mbClientRunDevice::popItemsToRead(QList<mbClientRunItem*> &items)
 
 void mbClientRunDevice::pushItemsToWrite(const QList<mbClientRunItem *> &items)
 {
-    QWriteLocker _(&m_lock);
+    m_lock.lockForWrite();
     m_itemsToWrite.append(items);
+    m_lock.unlock();
+    wakeUpRunThread();
 }
 
 void mbClientRunDevice::pushItemToWrite(mbClientRunItem *item)
 {
-    QWriteLocker _(&m_lock);
+    m_lock.lockForWrite();
     m_itemsToWrite.append(item);
+    m_lock.unlock();
+    wakeUpRunThread();
 }
 
 bool mbClientRunDevice::popItemsToWrite(QList<mbClientRunItem *> &items)
@@ -87,8 +104,10 @@ bool mbClientRunDevice::hasExternalMessage() const
 
 void mbClientRunDevice::pushExternalMessage(const mbClientRunMessagePtr &message)
 {
-    QWriteLocker _(&m_lock);
+    m_lock.lockForWrite();
     m_externalMessages.enqueue(message);
+    m_lock.unlock();
+    wakeUpRunThread();
 }
 
 bool mbClientRunDevice::popExternalMessage(mbClientRunMessagePtr *message)
@@ -102,6 +121,16 @@ bool mbClientRunDevice::popExternalMessage(mbClientRunMessagePtr *message)
     return false;
 }
 
+void mbClientRunDevice::wakeUpRunThread()
+{
+    if (m_runThread)
+    {
+        QAbstractEventDispatcher *dispatcher = m_runThread->eventDispatcher();
+        if (dispatcher)
+            dispatcher->wakeUp();
+    }
+}
+
 void mbClientRunDevice::setSettings(const Modbus::Settings &settings)
 {
     QWriteLocker _(&m_lock);
@@ -165,4 +194,60 @@ void mbClientRunDevice::setSettings(const Modbus::Settings &settings)
         QVariant var = it.value();
         m_settings.maxWriteMultipleRegisters = static_cast<uint16_t>(var.toUInt());
     }
+
+    it = settings.find(s.readGapRegisters);
+    if (it != end)
+    {
+        QVariant var = it.value();
+        m_settings.readGapRegisters = static_cast<uint16_t>(var.toUInt());
+    }
+
+    it = settings.find(s.readGapBits);
+    if (it != end)
+    {
+        QVariant var = it.value();
+        m_settings.readGapBits = static_cast<uint16_t>(var.toUInt());
+    }
+
+    it = settings.find(s.adaptiveTimeout);
+    if (it != end)
+    {
+        QVariant var = it.value();
+        m_settings.adaptiveTimeout = var.toBool();
+    }
+
+    it = settings.find(s.quarantineErrors);
+    if (it != end)
+    {
+        QVariant var = it.value();
+        m_settings.quarantineErrors = var.toUInt();
+    }
+
+    it = settings.find(s.quarantineBackoffMax);
+    if (it != end)
+    {
+        QVariant var = it.value();
+        m_settings.quarantineBackoffMax = var.toUInt();
+    }
+
+    it = settings.find(s.pollWeight);
+    if (it != end)
+    {
+        QVariant var = it.value();
+        m_settings.pollWeight = var.toUInt();
+    }
+
+    it = settings.find(s.pollPriority);
+    if (it != end)
+    {
+        QVariant var = it.value();
+        m_settings.pollPriority = static_cast<uint8_t>(var.toUInt());
+    }
+
+    it = settings.find(s.edfScheduling);
+    if (it != end)
+    {
+        QVariant var = it.value();
+        m_settings.edfScheduling = var.toBool();
+    }
 }
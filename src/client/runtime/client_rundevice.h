@@ -28,8 +28,11 @@
 
 #include <client_global.h>
 
+class QThread;
 class mbClientRunItem;
 
+#include "client_stats.h"
+
 class mbClientRunDevice
 {
 public:
@@ -45,6 +48,21 @@ public: // settings
     inline uint16_t maxReadHoldingRegisters    () const { QReadLocker _(&m_lock); return m_settings.maxReadHoldingRegisters  ; }
     inline uint16_t maxWriteMultipleCoils      () const { QReadLocker _(&m_lock); return m_settings.maxWriteMultipleCoils    ; }
     inline uint16_t maxWriteMultipleRegisters  () const { QReadLocker _(&m_lock); return m_settings.maxWriteMultipleRegisters; }
+    inline uint16_t readGapRegisters           () const { QReadLocker _(&m_lock); return m_settings.readGapRegisters         ; }
+    inline uint16_t readGapBits                () const { QReadLocker _(&m_lock); return m_settings.readGapBits              ; }
+    inline bool     isAdaptiveTimeout          () const { QReadLocker _(&m_lock); return m_settings.adaptiveTimeout          ; }
+    inline uint32_t quarantineErrors           () const { QReadLocker _(&m_lock); return m_settings.quarantineErrors         ; }
+    inline uint32_t quarantineBackoffMax       () const { QReadLocker _(&m_lock); return m_settings.quarantineBackoffMax     ; }
+    inline uint32_t pollWeight                 () const { QReadLocker _(&m_lock); return m_settings.pollWeight               ; }
+    inline uint8_t  pollPriority               () const { QReadLocker _(&m_lock); return m_settings.pollPriority             ; }
+    inline bool     isEdfScheduling            () const { QReadLocker _(&m_lock); return m_settings.edfScheduling            ; }
+
+public:
+    // thread that processes the device, it's woken up when new write or external message is pushed
+    inline void setRunThread(QThread *thread) { m_runThread = thread; }
+    // statistics of the device, it's written by the thread that processes the device
+    inline mbClientStats::Device *stats() const { return m_stats; }
+    inline void setStats(mbClientStats::Device *stats) { m_stats = stats; }
 
 public:
     void pushItemsToRead(const QList<mbClientRunItem*> &itemsToRead);
@@ -62,6 +80,7 @@ public:
 
 private:
     void setSettings(const Modbus::Settings &settings);
+    void wakeUpRunThread();
 
 private:
     mutable QReadWriteLock m_lock;
@@ -77,9 +96,19 @@ private:
         uint16_t maxReadHoldingRegisters  ;
         uint16_t maxWriteMultipleCoils    ;
         uint16_t maxWriteMultipleRegisters;
+        uint16_t readGapRegisters         ;
+        uint16_t readGapBits              ;
+        bool     adaptiveTimeout          ;
+        uint32_t quarantineErrors         ;
+        uint32_t quarantineBackoffMax     ;
+        uint32_t pollWeight               ;
+        uint8_t  pollPriority             ;
+        bool     edfScheduling            ;
     } m_settings;
 
 private:
+    QThread *m_runThread;
+    mbClientStats::Device *m_stats;
     QList<mbClientRunItem*> m_itemsToRead;
     QQueue<mbClientRunItem*> m_itemsToWrite;
     QQueue<mbClientRunMessagePtr> m_externalMessages;
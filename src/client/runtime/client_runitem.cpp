@@ -22,7 +22,7 @@
 */
 #include "client_runitem.h"
 
-#include <client.h>
+#include <project/client_dataview.h>
 #include "client_runmessage.h"
 
 void mbClientRunItem::init(mb::Client::ItemHandle_t handle, Modbus::MemoryType memoryType, uint16_t offset, uint16_t count)
@@ -82,12 +82,14 @@ void mbClientRunItem::writeDataToMessage()
     m_message->setData(innerOffset, count(), m_data.data());
 }
 
+// Note: handle is the data view item itself, it lives until the runtime is stopped,
+// so read value is delivered directly without global lookups
 void mbClientRunItem::update(const QByteArray &data, Modbus::StatusCode status, mb::Timestamp_t timestamp)
 {
-    mbClient::global()->updateItem(m_handle, data, status, timestamp);
+    m_handle->update(data, static_cast<mb::StatusCode>(status), timestamp);
 }
 
 void mbClientRunItem::update(Modbus::StatusCode status, mb::Timestamp_t timestamp)
 {
-    mbClient::global()->updateItem(m_handle, QByteArray(), status, timestamp);
+    m_handle->update(static_cast<mb::StatusCode>(status), timestamp);
 }
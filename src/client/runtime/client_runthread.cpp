@@ -23,6 +23,8 @@
 #include "client_runthread.h"
 
 #include <QEventLoop>
+#include <QTimer>
+#include <QAbstractEventDispatcher>
 
 #include <ModbusClientPort.h>
 
@@ -45,22 +47,47 @@ mbClientRunThread::~mbClientRunThread()
 {
 }
 
+void mbClientRunThread::stop()
+{
+    m_ctrlRun = false;
+    QAbstractEventDispatcher *dispatcher = eventDispatcher();
+    if (dispatcher)
+        dispatcher->wakeUp();
+}
+
 void mbClientRunThread::pushDevices(const QList<mbClientRunDevice *> &devices)
 {
+    Q_FOREACH (mbClientRunDevice *d, devices)
+        d->setRunThread(this);
     m_devices.append(devices);
 }
 
 void mbClientRunThread::run()
 {
     QEventLoop loop;
+    // Note: timer only wakes up the thread when next message is on duty,
+    // socket/serial data and pushed write/external messages wake it up themselves
+    QTimer timer;
+    timer.setSingleShot(true);
+    timer.setTimerType(Qt::PreciseTimer);
     mbClientPortRunnable port(m_settings, m_devices, this);
     m_ctrlRun = true;
     mbClient::LogInfo(port.name(), QStringLiteral("Start polling"));
     while (m_ctrlRun)
     {
+        // Note: internal timing of the iteration uses the same monotonic time
+        Modbus::updateMonotonicTime();
         loop.processEvents();
         port.run();
-        QThread::usleep(1);
+        int timeout = port.idleTimeout();
+        if (timeout == 0)
+            continue;
+        if (timeout > 0)
+            timer.start(timeout);
+        else
+            timer.stop();
+        if (m_ctrlRun)
+            loop.processEvents(QEventLoop::WaitForMoreEvents);
     }
     port.close();
     mbClient::LogInfo(port.name(), QStringLiteral("Finish polling"));
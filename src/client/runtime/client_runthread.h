@@ -41,7 +41,7 @@ public:
     ~mbClientRunThread();
 
 public:
-    inline void stop() { m_ctrlRun = false; }
+    void stop();
 
 public:
     void pushDevices(const QList<mbClientRunDevice*> &devices);
@@ -39,6 +39,8 @@
 mbClientRuntime::mbClientRuntime(QObject *parent)
     : mbCoreRuntime{parent}
 {
+    m_statsPeriod = 0;
+    m_statsTimer = 0;
 }
 
 void mbClientRuntime::createComponents()
@@ -46,6 +48,7 @@ void mbClientRuntime::createComponents()
     const mb::StatusCode status = mb::Status_MbInitializing;
     const mb::Timestamp_t timestamp = mb::currentTimestamp();
 
+    m_stats.clear();
     QHash<mbClientDevice*, QList<mbClientDataViewItem*> > hashDevices;
     Q_FOREACH (mbClientDataView *wl, project()->dataViews())
     {
@@ -69,7 +72,7 @@ void mbClientRuntime::createComponents()
                 mbClientRunItem *ri = createRunItem(item);
                 runItems.append(ri);
             }
-            mbClientRunDevice *rd = createRunDevice(device);
+            mbClientRunDevice *rd = createRunDevice(port, device);
             rd->pushItemsToRead(runItems);
             runDevices.append(rd);
         }
@@ -83,6 +86,8 @@ void mbClientRuntime::startComponents()
     mbCoreRuntime::startComponents();
     Q_FOREACH (mbClientRunThread *t, m_threads)
         t->start();
+    if (m_statsPeriod > 0)
+        m_statsTimer = startTimer(m_statsPeriod * 1000);
 }
 
 void mbClientRuntime::beginStopComponents()
@@ -90,6 +95,12 @@ void mbClientRuntime::beginStopComponents()
     mbCoreRuntime::beginStopComponents();
     Q_FOREACH (mbClientRunThread *t, m_threads)
         t->stop();
+    if (m_statsTimer)
+    {
+        killTimer(m_statsTimer);
+        m_statsTimer = 0;
+        dumpStatistics();
+    }
 }
 
 bool mbClientRuntime::tryStopComponents()
@@ -137,14 +148,6 @@ void mbClientRuntime::sendMessage(mb::Client::DeviceHandle_t handle, const mbCli
     }
 }
 
-void mbClientRuntime::updateItem(mb::Client::ItemHandle_t handle, const QByteArray &data, mb::StatusCode status, mb::Timestamp_t timestamp)
-{
-    if (!m_items.contains(handle))
-        return;
-    mbClientDataViewItem *item = handle;
-    item->update(data, status, timestamp);
-}
-
 void mbClientRuntime::writeItemData(mb::Client::ItemHandle_t handle, const QByteArray &data)
 {
     if (!m_items.contains(handle))
@@ -159,6 +162,18 @@ void mbClientRuntime::writeItemData(mb::Client::ItemHandle_t handle, const QByte
     }
 }
 
+void mbClientRuntime::timerEvent(QTimerEvent * /*event*/)
+{
+    dumpStatistics();
+}
+
+void mbClientRuntime::dumpStatistics()
+{
+    const QStringList lines = m_stats.dump();
+    Q_FOREACH (const QString &line, lines)
+        mbClient::LogInfo(QStringLiteral("Statistics"), line);
+}
+
 mbClientRunItem *mbClientRuntime::createRunItem(mbClientDataViewItem *item)
 {
     mbClientRunItem *t = new mbClientRunItem(item->handle(),
@@ -181,9 +196,10 @@ mbClientRunItem *mbClientRuntime::createRunItem(mbClientDataViewItem *item, cons
     return t;
 }
 
-mbClientRunDevice *mbClientRuntime::createRunDevice(mbClientDevice *device)
+mbClientRunDevice *mbClientRuntime::createRunDevice(mbClientPort *port, mbClientDevice *device)
 {
     mbClientRunDevice *t = new mbClientRunDevice(device->settings());
+    t->setStats(m_stats.createDevice(port->name(), device->name()));
     m_devices.insert(device, t);
     return t;
 }
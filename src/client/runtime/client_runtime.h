@@ -27,6 +27,8 @@
 #include <project/client_project.h>
 #include <runtime/core_runtime.h>
 
+#include "client_stats.h"
+
 class mbClientPort;
 class mbClientDevice;
 class mbClientDataViewItem;
@@ -45,21 +47,28 @@ public:
 
 public:
     void sendMessage(mb::Client::DeviceHandle_t handle, const mbClientRunMessagePtr &message);
-    void updateItem(mb::Client::ItemHandle_t handle, const QByteArray &data, mb::StatusCode status, mb::Timestamp_t timestamp);
-    inline void updateItem(mb::Client::ItemHandle_t handle, const QByteArray &data, Modbus::StatusCode status, mb::Timestamp_t timestamp) { updateItem(handle, data, static_cast<mb::StatusCode>(status), timestamp); }
     void writeItemData(mb::Client::ItemHandle_t handle, const QByteArray &data);
 
+public:
+    // Note: statistics of the last run is kept until the next start
+    inline mbClientStats *stats() { return &m_stats; }
+    void dumpStatistics();
+    // period (seconds) to dump statistics to the log while runtime is running, 0 - disabled
+    inline int statsPeriod() const { return m_statsPeriod; }
+    inline void setStatsPeriod(int seconds) { m_statsPeriod = seconds; }
+
 private:
     void createComponents() override;
     void startComponents() override;
     void beginStopComponents() override;
     bool tryStopComponents() override;
     void clearComponents() override;
+    void timerEvent(QTimerEvent *event) override;
 
 private:
     mbClientRunItem *createRunItem(mbClientDataViewItem *item);
     mbClientRunItem *createRunItem(mbClientDataViewItem *item, const QByteArray &data);
-    mbClientRunDevice *createRunDevice(mbClientDevice *device);
+    mbClientRunDevice *createRunDevice(mbClientPort *port, mbClientDevice *device);
     mbClientRunThread *createRunThread(mbClientPort *port);
 
 private: // items
@@ -73,6 +82,11 @@ private: // devices
 private: // threads
     typedef QHash<mbClientPort*, mbClientRunThread*> Threads_t;
     Threads_t m_threads;
+
+private:
+    mbClientStats m_stats;
+    int m_statsPeriod;
+    int m_statsTimer;
 };
 
 #endif // CLIENT_RUNTIME_H
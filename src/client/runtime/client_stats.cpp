@@ -0,0 +1,433 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "client_stats.h"
+
+#include <cstring>
+
+#include "client_devicehealth.h"
+
+// Note: every counter has single writer, so read-modify-write can be done without atomic operation
+template <typename T>
+static inline void increment(std::atomic<T> &c, T v = 1)
+{
+    c.store(c.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+}
+
+mbClientStats::Histogram::Histogram()
+{
+    for (int i = 0; i < BucketCount; i++)
+        m_counts[i].store(0, std::memory_order_relaxed);
+}
+
+void mbClientStats::Histogram::record(uint32_t value)
+{
+    increment(m_counts[bucket(value)]);
+}
+
+void mbClientStats::Histogram::addTo(quint64 *counts) const
+{
+    for (int i = 0; i < BucketCount; i++)
+        counts[i] += m_counts[i].load(std::memory_order_relaxed);
+}
+
+int mbClientStats::Histogram::bucket(uint32_t value)
+{
+    return Modbus::histogramBucket(value);
+}
+
+uint32_t mbClientStats::Histogram::bucketUpperBound(int bucket)
+{
+    quint64 upper = Modbus::histogramBucketUpperBound(bucket);
+    return (upper > UINT32_MAX) ? UINT32_MAX : static_cast<uint32_t>(upper);
+}
+
+uint32_t mbClientStats::Histogram::percentile(const quint64 *counts, quint64 total, double percentile)
+{
+    quint64 v = Modbus::histogramPercentile(counts, BucketCount, total, percentile);
+    return (v > UINT32_MAX) ? UINT32_MAX : static_cast<uint32_t>(v);
+}
+
+mbClientStats::Counters::Counters() :
+    requests  (0),
+    good      (0),
+    exceptions(0),
+    timeouts  (0),
+    errors    (0),
+    repeats   (0)
+{
+}
+
+void mbClientStats::Counters::record(Modbus::StatusCode status, uint32_t latency, uint32_t repeats)
+{
+    increment(this->requests);
+    increment(this->repeats, static_cast<quint64>(repeats));
+    if (Modbus::StatusIsGood(status))
+    {
+        increment(this->good);
+        this->latency.record(latency);
+    }
+    else if (Modbus::StatusIsStandardError(status))
+    {
+        increment(this->exceptions);
+        this->latency.record(latency);
+    }
+    // Note: ports report elapsed response timeout as read error
+    else if (status == Modbus::Status_BadSerialRead || status == Modbus::Status_BadTcpRead)
+        increment(this->timeouts);
+    else
+        increment(this->errors);
+}
+
+mbClientStats::Health::Health() :
+    state      (mbClientDeviceHealth::Online),
+    srtt       (0),
+    rto        (0),
+    quarantines(0),
+    probes     (0)
+{
+}
+
+mbClientStats::Poll::Poll(const QString &name, uint32_t period) :
+    m_name(name),
+    m_period(period),
+    m_polls(0),
+    m_misses(0),
+    m_failures(0),
+    m_next(nullptr)
+{
+}
+
+void mbClientStats::Poll::record(qint64 lateness, bool good)
+{
+    increment(m_polls);
+    if (!good)
+    {
+        increment(m_failures);
+        increment(m_misses);
+        return;
+    }
+    if (lateness > 0)
+    {
+        increment(m_misses);
+        m_lateness.record(lateness < UINT32_MAX ? static_cast<uint32_t>(lateness) : UINT32_MAX);
+    }
+    else
+        m_lateness.record(0);
+}
+
+mbClientStats::Device::Device(const QString &port, const QString &name) :
+    m_port(port),
+    m_name(name),
+    m_discarded(0),
+    m_polls(nullptr),
+    m_lastPoll(nullptr)
+{
+    for (int i = 0; i < FunctionCount; i++)
+        m_functions[i].store(nullptr, std::memory_order_relaxed);
+}
+
+mbClientStats::Device::~Device()
+{
+    for (int i = 0; i < FunctionCount; i++)
+        delete m_functions[i].load(std::memory_order_relaxed);
+    Poll *p = m_polls.load(std::memory_order_relaxed);
+    while (p)
+    {
+        Poll *next = p->m_next.load(std::memory_order_relaxed);
+        delete p;
+        p = next;
+    }
+}
+
+void mbClientStats::Device::record(uint8_t func, Modbus::StatusCode status, uint32_t latency, uint32_t repeats)
+{
+    m_total.record(status, latency, repeats);
+    if (func >= FunctionCount)
+        return;
+    Counters *c = m_functions[func].load(std::memory_order_relaxed);
+    if (!c)
+    {
+        c = new Counters;
+        m_functions[func].store(c, std::memory_order_release);
+    }
+    c->record(status, latency, repeats);
+}
+
+mbClientStats::Poll *mbClientStats::Device::createPoll(const QString &name, uint32_t period)
+{
+    // Note: poll is appended to the end of the list, so reader sees it completely constructed
+    Poll *p = new Poll(name, period);
+    if (m_lastPoll)
+        m_lastPoll->m_next.store(p, std::memory_order_release);
+    else
+        m_polls.store(p, std::memory_order_release);
+    m_lastPoll = p;
+    return p;
+}
+
+void mbClientStats::Device::setHealth(const mbClientDeviceHealth &health)
+{
+    m_health.state      .store(health.state()          , std::memory_order_relaxed);
+    m_health.srtt       .store(health.srtt()           , std::memory_order_relaxed);
+    m_health.rto        .store(health.timeout()        , std::memory_order_relaxed);
+    m_health.quarantines.store(health.quarantineCount(), std::memory_order_relaxed);
+    m_health.probes     .store(health.probeCount()     , std::memory_order_relaxed);
+}
+
+struct mbClientStats::Aggregate
+{
+    Aggregate() : requests(0), good(0), exceptions(0), timeouts(0), errors(0), repeats(0) { memset(latency, 0, sizeof(latency)); }
+
+    void add(const Counters &c)
+    {
+        requests   += c.requests  .load(std::memory_order_relaxed);
+        good       += c.good      .load(std::memory_order_relaxed);
+        exceptions += c.exceptions.load(std::memory_order_relaxed);
+        timeouts   += c.timeouts  .load(std::memory_order_relaxed);
+        errors     += c.errors    .load(std::memory_order_relaxed);
+        repeats    += c.repeats   .load(std::memory_order_relaxed);
+        c.latency.addTo(latency);
+    }
+
+    quint64 requests;
+    quint64 good;
+    quint64 exceptions;
+    quint64 timeouts;
+    quint64 errors;
+    quint64 repeats;
+    quint64 latency[Histogram::BucketCount];
+};
+
+QString mbClientStats::stateString(int state)
+{
+    switch (state)
+    {
+    case mbClientDeviceHealth::Online:
+        return QStringLiteral("Online");
+    case mbClientDeviceHealth::Quarantine:
+        return QStringLiteral("Quarantine");
+    default:
+        return QString();
+    }
+}
+
+mbClientStats::mbClientStats()
+{
+    m_timer.start();
+    m_lastTime = 0;
+}
+
+mbClientStats::~mbClientStats()
+{
+    clear();
+}
+
+mbClientStats::Device *mbClientStats::createDevice(const QString &port, const QString &name)
+{
+    Device *d = new Device(port, name);
+    m_devices.append(d);
+    return d;
+}
+
+void mbClientStats::clear()
+{
+    qDeleteAll(m_devices);
+    m_devices.clear();
+    m_lastRequests.clear();
+}
+
+mbClientStats::Rows_t mbClientStats::snapshot()
+{
+    qint64 time = m_timer.elapsed();
+    double elapsed = static_cast<double>(time - m_lastTime) / 1000.0;
+    m_lastTime = time;
+
+    // group devices by port keeping its order
+    QStringList ports;
+    QHash<QString, QList<Device*> > portDevices;
+    Q_FOREACH (Device *d, m_devices)
+    {
+        if (!portDevices.contains(d->port()))
+            ports.append(d->port());
+        portDevices[d->port()].append(d);
+    }
+
+    Rows_t rows;
+    Q_FOREACH (const QString &port, ports)
+    {
+        const QList<Device*> &devices = portDevices[port];
+        Row row;
+        row.port = port;
+        row.function = -1;
+        int iPort = rows.count();
+        rows.append(row); // port total is filled after devices
+
+        Aggregate portTotal;
+        quint64 discarded = 0;
+        Q_FOREACH (Device *d, devices)
+        {
+            // Note: all devices of the port have the same value of the port counter
+            discarded = qMax(discarded, d->discarded());
+            row.device = d->name();
+            row.function = -1;
+            Aggregate total;
+            total.add(d->total());
+            portTotal.add(d->total());
+            makeRow(row, total);
+            const Health &h = d->health();
+            row.state       = h.state      .load(std::memory_order_relaxed);
+            row.srtt        = h.srtt       .load(std::memory_order_relaxed);
+            row.rto         = h.rto        .load(std::memory_order_relaxed);
+            row.quarantines = h.quarantines.load(std::memory_order_relaxed);
+            row.probes      = h.probes     .load(std::memory_order_relaxed);
+            rows.append(row);
+            for (int func = 0; func < Device::FunctionCount; func++)
+            {
+                const Counters *c = d->function(static_cast<uint8_t>(func));
+                if (!c)
+                    continue;
+                Aggregate a;
+                a.add(*c);
+                row.function = func;
+                makeRow(row, a);
+                rows.append(row);
+            }
+        }
+        makeRow(rows[iPort], portTotal);
+        rows[iPort].discarded = discarded;
+    }
+
+    // requests rate
+    for (Rows_t::iterator it = rows.begin(); it != rows.end(); ++it)
+    {
+        QString key = QString("%1/%2/%3").arg(it->port, it->device).arg(it->function);
+        quint64 last = m_lastRequests.value(key, 0);
+        it->requestsPerSec = (elapsed > 0) ? static_cast<double>(it->requests - last) / elapsed : 0;
+        m_lastRequests[key] = it->requests;
+    }
+    return rows;
+}
+
+mbClientStats::PollRows_t mbClientStats::pollSnapshot() const
+{
+    PollRows_t rows;
+    Q_FOREACH (const Device *d, m_devices)
+    {
+        for (const Poll *p = d->firstPoll(); p; p = p->next())
+        {
+            PollRow row;
+            row.port = d->port();
+            row.device = d->name();
+            row.message = p->name();
+            row.period = p->period();
+            row.polls = p->polls();
+            row.misses = p->misses();
+            row.failures = p->failures();
+            quint64 latency[Histogram::BucketCount];
+            memset(latency, 0, sizeof(latency));
+            p->lateness().addTo(latency);
+            quint64 good = (row.polls > row.failures) ? row.polls - row.failures : 0;
+            row.p50 = Histogram::percentile(latency, good, 50);
+            row.p99 = Histogram::percentile(latency, good, 99);
+            row.max = Histogram::percentile(latency, good, 100);
+            rows.append(row);
+        }
+    }
+    return rows;
+}
+
+QStringList mbClientStats::dump()
+{
+    const Rows_t rows = snapshot();
+    QStringList r;
+    r.append(QStringLiteral("Port/Device/Function: requests, req/s, good, exceptions, timeouts, errors, repeats, latency p50/p90/p99/max (us)[, discarded bytes][, state, srtt/timeout (us), quarantines, probes]"));
+    Q_FOREACH (const Row &row, rows)
+    {
+        QString name = row.port;
+        if (row.device.count())
+            name += QStringLiteral("/") + row.device;
+        if (row.function >= 0)
+            name += QStringLiteral("/") + mb::ModbusFunctionString(static_cast<uint8_t>(row.function));
+        QString s = QString("%1: %2, %3, %4, %5, %6, %7, %8, %9/%10/%11/%12")
+                        .arg(name)
+                        .arg(row.requests)
+                        .arg(row.requestsPerSec, 0, 'f', 1)
+                        .arg(row.good)
+                        .arg(row.exceptions)
+                        .arg(row.timeouts)
+                        .arg(row.errors)
+                        .arg(row.repeats)
+                        .arg(row.p50)
+                        .arg(row.p90)
+                        .arg(row.p99)
+                        .arg(row.max);
+        if (row.device.isEmpty())
+            s += QString(", %1").arg(row.discarded);
+        if (row.state >= 0)
+            s += QString(", %1, %2/%3, %4, %5")
+                     .arg(stateString(row.state))
+                     .arg(row.srtt)
+                     .arg(row.rto)
+                     .arg(row.quarantines)
+                     .arg(row.probes);
+        r.append(s);
+    }
+    const PollRows_t polls = pollSnapshot();
+    if (polls.count())
+        r.append(QStringLiteral("Port/Device/Message: period (ms), polls, deadline misses (including failures), failures, lateness p50/p99/max (us)"));
+    Q_FOREACH (const PollRow &row, polls)
+    {
+        r.append(QString("%1/%2/%3: %4, %5, %6, %7, %8/%9/%10")
+                     .arg(row.port, row.device, row.message)
+                     .arg(row.period)
+                     .arg(row.polls)
+                     .arg(row.misses)
+                     .arg(row.failures)
+                     .arg(row.p50)
+                     .arg(row.p99)
+                     .arg(row.max));
+    }
+    return r;
+}
+
+void mbClientStats::makeRow(Row &row, const Aggregate &a)
+{
+    row.requests   = a.requests  ;
+    row.good       = a.good      ;
+    row.exceptions = a.exceptions;
+    row.timeouts   = a.timeouts  ;
+    row.errors     = a.errors    ;
+    row.repeats    = a.repeats   ;
+    quint64 total = a.good + a.exceptions;
+    row.p50 = Histogram::percentile(a.latency, total, 50);
+    row.p90 = Histogram::percentile(a.latency, total, 90);
+    row.p99 = Histogram::percentile(a.latency, total, 99);
+    row.max = Histogram::percentile(a.latency, total, 100);
+    row.requestsPerSec = 0;
+    row.state = -1;
+    row.srtt = 0;
+    row.rto = 0;
+    row.quarantines = 0;
+    row.probes = 0;
+    row.discarded = 0;
+}
@@ -0,0 +1,245 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef CLIENT_STATS_H
+#define CLIENT_STATS_H
+
+#include <atomic>
+
+#include <QHash>
+#include <QVector>
+#include <QElapsedTimer>
+
+#include <client_global.h>
+
+class mbClientDeviceHealth;
+
+// Runtime statistics of devices: latency histograms, result counters and request rates
+// per port, device and function. Every device has its own counters which are written
+// by the port thread only (without locks), counters are aggregated when they are read.
+class mbClientStats
+{
+public:
+    // Log-linear (HDR style) histogram of latency in microseconds with buckets of 'Modbus::histogramBucket()',
+    // only the buckets of 32-bit values are kept
+    class Histogram
+    {
+    public:
+        static const int SubBucketBits = Modbus::HistogramSubBucketBits;
+        static const int SubBucketCount = Modbus::HistogramSubBucketCount;
+        static const int BucketCount = (33 - SubBucketBits) * SubBucketCount;
+
+    public:
+        Histogram();
+
+    public:
+        void record(uint32_t value);
+        void addTo(quint64 *counts) const;
+
+    public:
+        static int bucket(uint32_t value);
+        static uint32_t bucketUpperBound(int bucket);
+        // returns value at 'percentile' (0..100) of 'counts' array of 'BucketCount' size
+        static uint32_t percentile(const quint64 *counts, quint64 total, double percentile);
+
+    private:
+        std::atomic<uint32_t> m_counts[BucketCount];
+    };
+
+    struct Counters
+    {
+        Counters();
+        // Note: latency is recorded for requests that have got the response (good or exception) only,
+        // latency of timed out requests is the timeout itself
+        void record(Modbus::StatusCode status, uint32_t latency, uint32_t repeats);
+
+        std::atomic<quint64> requests;
+        std::atomic<quint64> good;
+        std::atomic<quint64> exceptions;
+        std::atomic<quint64> timeouts;
+        std::atomic<quint64> errors;
+        std::atomic<quint64> repeats;
+        Histogram latency;
+    };
+
+    // last published health of the device (see 'mbClientDeviceHealth')
+    struct Health
+    {
+        Health();
+
+        std::atomic<int> state;
+        std::atomic<uint32_t> srtt;
+        std::atomic<uint32_t> rto;
+        std::atomic<quint64> quarantines;
+        std::atomic<quint64> probes;
+    };
+
+    class Device;
+
+    // deadline accounting of the periodic read message: deadline of every poll is its release time
+    // plus period, lateness is the time the poll was completed after its deadline (0 - in time).
+    // Failed poll (timeout, error or exception) didn't deliver data, so it's counted as a miss
+    // and its lateness is not recorded
+    class Poll
+    {
+    public:
+        Poll(const QString &name, uint32_t period);
+
+    public:
+        inline QString name() const { return m_name; }
+        inline uint32_t period() const { return m_period; }
+        inline quint64 polls() const { return m_polls.load(std::memory_order_relaxed); }
+        inline quint64 misses() const { return m_misses.load(std::memory_order_relaxed); }
+        inline quint64 failures() const { return m_failures.load(std::memory_order_relaxed); }
+        inline const Histogram &lateness() const { return m_lateness; }
+        inline const Poll *next() const { return m_next.load(std::memory_order_acquire); }
+
+    public:
+        // must be called by the port thread only, 'lateness' is in microseconds
+        void record(qint64 lateness, bool good);
+
+    private:
+        friend class Device;
+        const QString m_name;
+        const uint32_t m_period;
+        std::atomic<quint64> m_polls;
+        std::atomic<quint64> m_misses;
+        std::atomic<quint64> m_failures;
+        Histogram m_lateness;
+        std::atomic<Poll*> m_next;
+    };
+
+    class Device
+    {
+    public:
+        Device(const QString &port, const QString &name);
+        ~Device();
+
+    public:
+        inline QString port() const { return m_port; }
+        inline QString name() const { return m_name; }
+        inline const Counters &total() const { return m_total; }
+        // returns nullptr if function was never requested
+        inline const Counters *function(uint8_t func) const { return (func < FunctionCount) ? m_functions[func].load(std::memory_order_acquire) : nullptr; }
+        inline const Health &health() const { return m_health; }
+        inline quint64 discarded() const { return m_discarded.load(std::memory_order_relaxed); }
+        // list of the read messages of the device, nullptr if there is no one
+        inline const Poll *firstPoll() const { return m_polls.load(std::memory_order_acquire); }
+
+    public:
+        // must be called by the port thread only
+        void record(uint8_t func, Modbus::StatusCode status, uint32_t latency, uint32_t repeats);
+        void setHealth(const mbClientDeviceHealth &health);
+        // bytes discarded by frame resynchronization of the port of the device
+        inline void setDiscarded(quint64 bytes) { m_discarded.store(bytes, std::memory_order_relaxed); }
+        // read message is created, 'period' is in milliseconds
+        Poll *createPoll(const QString &name, uint32_t period);
+
+    public:
+        static const int FunctionCount = 128;
+
+    private:
+        const QString m_port;
+        const QString m_name;
+        Counters m_total;
+        std::atomic<Counters*> m_functions[FunctionCount];
+        Health m_health;
+        std::atomic<quint64> m_discarded;
+        std::atomic<Poll*> m_polls;
+        Poll *m_lastPoll;
+    };
+
+    // aggregated values of the counters
+    struct Row
+    {
+        QString port;
+        QString device;    // empty for total of the port
+        int function;      // -1 for total of the port or device
+        quint64 requests;
+        quint64 good;
+        quint64 exceptions;
+        quint64 timeouts;
+        quint64 errors;
+        quint64 repeats;
+        double requestsPerSec; // since previous 'snapshot()' call
+        uint32_t p50;
+        uint32_t p90;
+        uint32_t p99;
+        uint32_t max;
+        // health is filled for total of the device only
+        int state;         // mbClientDeviceHealth::State, -1 for other rows
+        uint32_t srtt;     // microseconds
+        uint32_t rto;      // microseconds, 0 - timeout of the port
+        quint64 quarantines;
+        quint64 probes;
+        quint64 discarded; // bytes discarded by frame resynchronization, filled for total of the port only
+    };
+    typedef QVector<Row> Rows_t;
+
+    // aggregated values of the read message
+    struct PollRow
+    {
+        QString port;
+        QString device;
+        QString message;
+        uint32_t period;
+        quint64 polls;
+        quint64 misses;   // including failures
+        quint64 failures;
+        uint32_t p50; // lateness of good polls, microseconds
+        uint32_t p99;
+        uint32_t max;
+    };
+    typedef QVector<PollRow> PollRows_t;
+
+public:
+    static QString stateString(int state);
+
+public:
+    mbClientStats();
+    ~mbClientStats();
+
+public:
+    // Note: devices are created and deleted by GUI thread while runtime is stopped
+    Device *createDevice(const QString &port, const QString &name);
+    void clear();
+
+public:
+    // rows are grouped by port: port total, then total and functions of every device
+    Rows_t snapshot();
+    // deadline accounting of the read messages grouped by port and device
+    PollRows_t pollSnapshot() const;
+    // text table of 'snapshot()'
+    QStringList dump();
+
+private:
+    struct Aggregate;
+    void makeRow(Row &row, const Aggregate &a);
+
+private:
+    QList<Device*> m_devices;
+    QElapsedTimer m_timer;
+    QHash<QString, quint64> m_lastRequests;
+    qint64 m_lastTime;
+};
+
+#endif // CLIENT_STATS_H
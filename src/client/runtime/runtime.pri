@@ -1,17 +1,25 @@
 HEADERS += \
+    $$PWD/client_devicehealth.h \
     $$PWD/client_devicerunnable.h \
+    $$PWD/client_portarbiter.h \
     $$PWD/client_portrunnable.h \
+    $$PWD/client_readplanner.h \
     $$PWD/client_rundevice.h \
     $$PWD/client_runitem.h \
     $$PWD/client_runmessage.h \
+    $$PWD/client_stats.h \
     $$PWD/client_runthread.h \
     $$PWD/client_runtime.h
 
 SOURCES += \
+    $$PWD/client_devicehealth.cpp \
     $$PWD/client_devicerunnable.cpp \
+    $$PWD/client_portarbiter.cpp \
     $$PWD/client_portrunnable.cpp \
+    $$PWD/client_readplanner.cpp \
     $$PWD/client_rundevice.cpp \
     $$PWD/client_runitem.cpp \
     $$PWD/client_runmessage.cpp \
+    $$PWD/client_stats.cpp \
     $$PWD/client_runthread.cpp \
     $$PWD/client_runtime.cpp
@@ -76,7 +76,13 @@ mbCore::Strings::Strings() :
     settings_organization  (QStringLiteral("March"                  )),
     settings_logFlags      (QStringLiteral("Core.Log.Flags"         )),
     settings_useTimestamp  (QStringLiteral("Core.Log.UseTimestamp"  )),
-    settings_formatDateTime(QStringLiteral("Core.Log.FormatDateTime"))
+    settings_formatDateTime(QStringLiteral("Core.Log.FormatDateTime")),
+    settings_logFile             (QStringLiteral("Core.Log.File"            )),
+    settings_logFileMaxSize      (QStringLiteral("Core.Log.FileMaxSize"     )),
+    settings_logFileRotatePeriod (QStringLiteral("Core.Log.FileRotatePeriod")),
+    settings_logFileCount        (QStringLiteral("Core.Log.FileCount"       )),
+    settings_logQueueSize        (QStringLiteral("Core.Log.QueueSize"       )),
+    settings_logDropPolicy       (QStringLiteral("Core.Log.DropPolicy"      ))
 {
 }
 
@@ -90,6 +96,12 @@ mbCore::Defaults::Defaults() :
     settings_logFlags       (mb::Log_Error|mb::Log_Warning|mb::Log_Info|mb::Log_TxRx),
     settings_useTimestamp   (true),
     settings_formatDateTime (QStringLiteral("dd.MM.yyyy hh:mm:ss.zzz")),
+    settings_logFile             (QString()),
+    settings_logFileMaxSize      (10*1024*1024),
+    settings_logFileRotatePeriod (0),
+    settings_logFileCount        (5),
+    settings_logQueueSize        (10000),
+    settings_logDropPolicy       (mbCoreLogger::DropNewest),
     tray                    (false)
 {
 }
@@ -112,16 +124,29 @@ mbCore::mbCore(const QString &application, QObject *parent) : mbCoreBase(parent)
     m_ui = nullptr;
     m_project = nullptr;
 
-    connect(this, &mbCore::signalLog, this, &mbCore::logMessageThreadUnsafe);
-
     m_settings.logFlags       = d.settings_logFlags      ;
     m_settings.useTimestamp   = d.settings_useTimestamp  ;
     m_settings.formatDateTime = d.settings_formatDateTime;
     m_config = new QSettings(s.settings_organization, application, this);
+
+    m_logger = new mbCoreLogger(&m_traceRing, this);
+    m_logger->setUseTimestamp    (d.settings_useTimestamp       );
+    m_logger->setFormatDateTime  (d.settings_formatDateTime     );
+    m_logger->setFileName        (d.settings_logFile            );
+    m_logger->setFileMaxSize     (d.settings_logFileMaxSize     );
+    m_logger->setFileRotatePeriod(d.settings_logFileRotatePeriod);
+    m_logger->setFileCount       (d.settings_logFileCount       );
+    m_logger->setQueueSize       (d.settings_logQueueSize       );
+    m_logger->setDropPolicy      (d.settings_logDropPolicy      );
+    connect(m_logger, &mbCoreLogger::signalMessages, this, &mbCore::showMessages);
+    m_logger->start();
 }
 
 mbCore::~mbCore()
 {
+    // flush the rest of the log while output is still available
+    m_logger->stop();
+    showMessages(m_logger->takeBatch());
     delete m_ui;
     delete m_project;
     delete m_app;
@@ -287,7 +312,7 @@ int mbCore::runConsole()
     }
     else
     {
-        logMessageThreadUnsafe(mb::Log_Error, applicationName(), QStringLiteral("No project defined"));
+        logError(applicationName(), QStringLiteral("No project defined"));
     }
     saveConfig();
     return r;
@@ -327,6 +352,12 @@ MBSETTINGS mbCore::settings() const
     r[s.settings_logFlags      ] = static_cast<uint>(logFlags());
     r[s.settings_useTimestamp  ] = useTimestamp  ();
     r[s.settings_formatDateTime] = formatDateTime();
+    r[s.settings_logFile             ] = logFile();
+    r[s.settings_logFileMaxSize      ] = logFileMaxSize();
+    r[s.settings_logFileRotatePeriod ] = logFileRotatePeriod();
+    r[s.settings_logFileCount        ] = logFileCount();
+    r[s.settings_logQueueSize        ] = logQueueSize();
+    r[s.settings_logDropPolicy       ] = mb::enumKey(logDropPolicy());
     return r;
 }
 
@@ -360,28 +391,72 @@ void mbCore::setSettings(const MBSETTINGS &settings)
         setFormatDateTime(v);
     }
 
+    it = settings.find(s.settings_logFile);
+    if (it != end)
+    {
+        QString v = it.value().toString();
+        setLogFile(v);
+    }
+
+    it = settings.find(s.settings_logFileMaxSize);
+    if (it != end)
+    {
+        qint64 v = it.value().toLongLong(&ok);
+        if (ok)
+            setLogFileMaxSize(v);
+    }
+
+    it = settings.find(s.settings_logFileRotatePeriod);
+    if (it != end)
+    {
+        int v = it.value().toInt(&ok);
+        if (ok)
+            setLogFileRotatePeriod(v);
+    }
+
+    it = settings.find(s.settings_logFileCount);
+    if (it != end)
+    {
+        int v = it.value().toInt(&ok);
+        if (ok)
+            setLogFileCount(v);
+    }
+
+    it = settings.find(s.settings_logQueueSize);
+    if (it != end)
+    {
+        int v = it.value().toInt(&ok);
+        if (ok)
+            setLogQueueSize(v);
+    }
+
+    it = settings.find(s.settings_logDropPolicy);
+    if (it != end)
+    {
+        mbCoreLogger::DropPolicy v = mb::enumValue<mbCoreLogger::DropPolicy>(it.value(), &ok);
+        if (ok)
+            setLogDropPolicy(v);
+    }
+
     if (m_ui)
         m_ui->setSettings(settings);
 }
 
 
-void mbCore::logMessageThreadSafe(mb::LogFlag flag, const QString &source, const QString &text)
+void mbCore::showMessages(const QStringList &messages)
 {
-    if (thread() == QThread::currentThread())
-        logMessageThreadUnsafe(flag, source, text);
-    else
-        Q_EMIT signalLog(flag, source, text);
-}
-
-void mbCore::logMessageThreadUnsafe(mb::LogFlag /*flag*/, const QString &source, const QString &text)
-{
-    QString msg = QString("'%1': %2").arg(source, text);
-    if (m_settings.useTimestamp)
-        msg = QString("%1 %2").arg(QDateTime::currentDateTime().toString(m_settings.formatDateTime), msg);
-    if (m_ui)
-        m_ui->showMessage(msg);
-    else
-        std::cout << msg.toStdString();
+    if (messages.count())
+    {
+        if (m_ui)
+            m_ui->showMessages(messages);
+        else
+        {
+            Q_FOREACH (const QString &msg, messages)
+                std::cout << msg.toStdString() << '\n';
+            std::cout.flush();
+        }
+    }
+    m_logger->confirmBatch();
 }
 
 void mbCore::loadConfig()
@@ -28,7 +28,9 @@
 #include <QSharedMemory>
 
 #include <mbcore_base.h>
+#include <runtime/core_tracering.h>
 #include "core_global.h"
+#include "core_logger.h"
 
 class mbCoreTask;
 class mbCoreTaskInfo;
@@ -52,6 +54,12 @@ public:
         const QString settings_logFlags      ;
         const QString settings_useTimestamp  ;
         const QString settings_formatDateTime;
+        const QString settings_logFile;
+        const QString settings_logFileMaxSize;
+        const QString settings_logFileRotatePeriod;
+        const QString settings_logFileCount;
+        const QString settings_logQueueSize;
+        const QString settings_logDropPolicy;
         Strings();
         static const Strings &instance();
     };
@@ -61,6 +69,12 @@ public:
         const mb::LogFlags  settings_logFlags      ;
         const bool          settings_useTimestamp  ;
         const QString       settings_formatDateTime;
+        const QString       settings_logFile;
+        const qint64        settings_logFileMaxSize;
+        const int           settings_logFileRotatePeriod;
+        const int           settings_logFileCount;
+        const int           settings_logQueueSize;
+        const mbCoreLogger::DropPolicy settings_logDropPolicy;
         const bool          tray;
         Defaults();
         static const Defaults &instance();
@@ -91,6 +105,9 @@ public:
     static inline void LogWarning(const QString &source, const QString &text) { s_globalCore->logWarning(source, text); }
     static inline void LogInfo   (const QString &source, const QString &text) { s_globalCore->logInfo   (source, text); }
     static inline void LogTxRx   (const QString &source, const QString &text) { s_globalCore->logTxRx   (source, text); }
+    static inline bool IsTraceTxRx() { return s_globalCore->isTraceTxRx(); }
+    static inline int  TraceSource(const QString &name) { return s_globalCore->traceSource(name); }
+    static inline void TraceTxRx  (int source, mbCoreTraceRing::Direction direction, mbCoreTraceRing::Format format, const QByteArray &bytes, const QString &connection = QString()) { s_globalCore->traceTxRx(source, direction, format, bytes, connection); }
 
 public:
     explicit mbCore(const QString& application, QObject *parent = nullptr);
@@ -118,9 +135,22 @@ public:
     inline mb::LogFlags logFlags() const { return m_settings.logFlags; }
     inline void setLogFlags(mb::LogFlags logFlags) { m_settings.logFlags = logFlags; }
     inline bool useTimestamp() const { return m_settings.useTimestamp; }
-    inline void setUseTimestamp(bool useTimestamp) { m_settings.useTimestamp = useTimestamp; }
+    inline void setUseTimestamp(bool useTimestamp) { m_settings.useTimestamp = useTimestamp; m_logger->setUseTimestamp(useTimestamp); }
     inline QString formatDateTime() const { return m_settings.formatDateTime; }
-    inline void setFormatDateTime(const QString& formatDateTime) { m_settings.formatDateTime = formatDateTime; }
+    inline void setFormatDateTime(const QString& formatDateTime) { m_settings.formatDateTime = formatDateTime; m_logger->setFormatDateTime(formatDateTime); }
+    inline QString logFile() const { return m_logger->fileName(); }
+    inline void setLogFile(const QString &logFile) { m_logger->setFileName(logFile); }
+    inline qint64 logFileMaxSize() const { return m_logger->fileMaxSize(); }
+    inline void setLogFileMaxSize(qint64 logFileMaxSize) { m_logger->setFileMaxSize(logFileMaxSize); }
+    inline int logFileRotatePeriod() const { return m_logger->fileRotatePeriod(); }
+    inline void setLogFileRotatePeriod(int seconds) { m_logger->setFileRotatePeriod(seconds); }
+    inline int logFileCount() const { return m_logger->fileCount(); }
+    inline void setLogFileCount(int logFileCount) { m_logger->setFileCount(logFileCount); }
+    inline int logQueueSize() const { return m_logger->queueSize(); }
+    inline void setLogQueueSize(int logQueueSize) { m_logger->setQueueSize(logQueueSize); }
+    inline mbCoreLogger::DropPolicy logDropPolicy() const { return m_logger->dropPolicy(); }
+    inline void setLogDropPolicy(mbCoreLogger::DropPolicy logDropPolicy) { m_logger->setDropPolicy(logDropPolicy); }
+    inline mbCoreLogger *logger() const { return m_logger; }
 
     virtual MBSETTINGS settings() const;
     virtual void setSettings(const MBSETTINGS &settings);
@@ -129,12 +159,17 @@ public: // core base interface
     virtual QWidget* topLevel() const;
 
 public: // log interface
-    inline void logMessage(mb::LogFlag flag, const QString &source, const QString &text) { if (m_settings.logFlags & flag) logMessageThreadSafe(flag, source, text); }
+    inline void logMessage(mb::LogFlag flag, const QString &source, const QString &text) { if (m_settings.logFlags & flag) m_logger->push(source, text, mb::currentTimestamp()); }
     inline void logError  (const QString &source, const QString &text) { logMessage(mb::Log_Error  , source, text); }
     inline void logWarning(const QString &source, const QString &text) { logMessage(mb::Log_Warning, source, text); }
     inline void logInfo   (const QString &source, const QString &text) { logMessage(mb::Log_Info   , source, text); }
     inline void logTxRx   (const QString &source, const QString &text) { logMessage(mb::Log_TxRx   , source, text); }
 
+public: // Tx/Rx trace interface: raw frames are pushed to the ring and formatted within the logger thread
+    inline bool isTraceTxRx() const { return m_settings.logFlags & mb::Log_TxRx; }
+    inline int traceSource(const QString &name) { return m_traceRing.source(name); }
+    inline void traceTxRx(int source, mbCoreTraceRing::Direction direction, mbCoreTraceRing::Format format, const QByteArray &bytes, const QString &connection = QString()) { m_traceRing.push(source, direction, format, bytes, connection); }
+
 public:
     inline mbCorePluginManager* pluginManager() const { return m_pluginManager; }
 
@@ -152,9 +187,6 @@ Q_SIGNALS:
     void statusChanged(int status);
     void projectChanged(mbCoreProject* project);
 
-Q_SIGNALS:
-    void signalLog(mb::LogFlag flag, const QString &source, const QString &text);
-
 public:
     virtual QString createGUID() = 0;
     virtual mbCoreProject* createProject() = 0;
@@ -172,11 +204,8 @@ protected:
     virtual int runGui();
     virtual int runConsole();
 
-private:
-    void logMessageThreadSafe(mb::LogFlag flag, const QString &source, const QString &text);
-
 private Q_SLOTS:
-    void logMessageThreadUnsafe(mb::LogFlag flag, const QString &source, const QString &text);
+    void showMessages(const QStringList &messages);
 
 private:
     void loadConfig();
@@ -205,6 +234,10 @@ protected:
         QString      formatDateTime;
     } m_settings;
 
+private:
+    mbCoreTraceRing m_traceRing;
+    mbCoreLogger *m_logger;
+
 private:
     typedef QVector<mbCoreTaskFactoryInfo*> TaskFactories_t;
     typedef QHash<QString,mbCoreTaskFactoryInfo*> HashTaskFactories_t;
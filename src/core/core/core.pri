@@ -1,7 +1,9 @@
 HEADERS += \
     $$PWD/core.h \
-    $$PWD/core_global.h
+    $$PWD/core_global.h \
+    $$PWD/core_logger.h
 
 SOURCES += \
     $$PWD/core.cpp \
-    $$PWD/core_global.cpp
+    $$PWD/core_global.cpp \
+    $$PWD/core_logger.cpp
@@ -0,0 +1,433 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "core_logger.h"
+
+#include <QDateTime>
+
+#include <Modbus.h>
+
+mbCoreLogger::mbCoreLogger(mbCoreTraceRing *traceRing, QObject *parent) : QThread(parent)
+{
+    m_traceRing = traceRing;
+
+    m_stub.next.store(nullptr, std::memory_order_relaxed);
+    m_tail.store(&m_stub, std::memory_order_relaxed);
+    m_head = &m_stub;
+    m_count.store(0, std::memory_order_relaxed);
+    m_queueSize.store(10000, std::memory_order_relaxed);
+    m_dropPolicy.store(DropNewest, std::memory_order_relaxed);
+    m_dropped.store(0, std::memory_order_relaxed);
+    m_droppedBatch.store(0, std::memory_order_relaxed);
+    m_batchBusy.store(false, std::memory_order_relaxed);
+    m_stop.store(false, std::memory_order_relaxed);
+    m_droppedReported = 0;
+    m_droppedBatchReported = 0;
+
+    m_settings.useTimestamp     = true;
+    m_settings.formatDateTime   = QStringLiteral("dd.MM.yyyy hh:mm:ss.zzz");
+    m_settings.fileMaxSize      = 10*1024*1024;
+    m_settings.fileRotatePeriod = 0;
+    m_settings.fileCount        = 5;
+    m_settings.changed          = true;
+
+    m_useTimestamp = m_settings.useTimestamp;
+    m_fileMaxSize = m_settings.fileMaxSize;
+    m_fileRotatePeriod = 0;
+    m_fileCount = m_settings.fileCount;
+    m_fileOpened = 0;
+    m_fileFailed = 0;
+    m_traceRecords.resize(64);
+}
+
+mbCoreLogger::~mbCoreLogger()
+{
+    stop();
+    while (Entry *e = dequeue())
+        delete e;
+}
+
+void mbCoreLogger::setQueueSize(int queueSize)
+{
+    if (queueSize > 0)
+        m_queueSize.store(queueSize, std::memory_order_relaxed);
+}
+
+bool mbCoreLogger::useTimestamp() const
+{
+    QMutexLocker _(&m_settingsLock);
+    return m_settings.useTimestamp;
+}
+
+void mbCoreLogger::setUseTimestamp(bool useTimestamp)
+{
+    QMutexLocker _(&m_settingsLock);
+    m_settings.useTimestamp = useTimestamp;
+    m_settings.changed = true;
+}
+
+QString mbCoreLogger::formatDateTime() const
+{
+    QMutexLocker _(&m_settingsLock);
+    return m_settings.formatDateTime;
+}
+
+void mbCoreLogger::setFormatDateTime(const QString &formatDateTime)
+{
+    QMutexLocker _(&m_settingsLock);
+    m_settings.formatDateTime = formatDateTime;
+    m_settings.changed = true;
+}
+
+QString mbCoreLogger::fileName() const
+{
+    QMutexLocker _(&m_settingsLock);
+    return m_settings.fileName;
+}
+
+void mbCoreLogger::setFileName(const QString &fileName)
+{
+    QMutexLocker _(&m_settingsLock);
+    m_settings.fileName = fileName;
+    m_settings.changed = true;
+}
+
+qint64 mbCoreLogger::fileMaxSize() const
+{
+    QMutexLocker _(&m_settingsLock);
+    return m_settings.fileMaxSize;
+}
+
+void mbCoreLogger::setFileMaxSize(qint64 fileMaxSize)
+{
+    QMutexLocker _(&m_settingsLock);
+    m_settings.fileMaxSize = fileMaxSize;
+    m_settings.changed = true;
+}
+
+int mbCoreLogger::fileRotatePeriod() const
+{
+    QMutexLocker _(&m_settingsLock);
+    return m_settings.fileRotatePeriod;
+}
+
+void mbCoreLogger::setFileRotatePeriod(int seconds)
+{
+    QMutexLocker _(&m_settingsLock);
+    m_settings.fileRotatePeriod = seconds;
+    m_settings.changed = true;
+}
+
+int mbCoreLogger::fileCount() const
+{
+    QMutexLocker _(&m_settingsLock);
+    return m_settings.fileCount;
+}
+
+void mbCoreLogger::setFileCount(int fileCount)
+{
+    QMutexLocker _(&m_settingsLock);
+    m_settings.fileCount = fileCount;
+    m_settings.changed = true;
+}
+
+void mbCoreLogger::push(const QString &source, const QString &text, mb::Timestamp_t timestamp)
+{
+    int size = m_queueSize.load(std::memory_order_relaxed);
+    if (m_count.load(std::memory_order_relaxed) >= size)
+    {
+        switch (dropPolicy())
+        {
+        case DropOldest:
+            break; // logger thread trims the queue
+        case Block:
+            // Note: logger thread itself must never wait for itself
+            if (QThread::currentThread() != this)
+            {
+                m_waitLock.lock();
+                while (m_count.load(std::memory_order_acquire) >= size && !m_stop.load(std::memory_order_acquire) && isRunning())
+                {
+                    m_wait.wakeOne();
+                    m_notFull.wait(&m_waitLock, FlushPeriod);
+                }
+                m_waitLock.unlock();
+                break;
+            }
+            Q_FALLTHROUGH();
+        default:
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    Entry *e = new Entry;
+    e->timestamp = timestamp;
+    e->source = source;
+    e->text = text;
+    int c = m_count.fetch_add(1, std::memory_order_relaxed);
+    enqueue(e);
+    // wake up logger thread earlier than 'FlushPeriod' if queue is filling up
+    if (c == size/2 || c == size)
+        m_wait.wakeOne();
+}
+
+void mbCoreLogger::stop()
+{
+    if (!isRunning())
+        return;
+    m_waitLock.lock();
+    m_stop.store(true, std::memory_order_release);
+    m_wait.wakeAll();
+    m_notFull.wakeAll();
+    m_waitLock.unlock();
+    wait();
+}
+
+QStringList mbCoreLogger::takeBatch()
+{
+    QStringList r;
+    if (!isRunning())
+        r.swap(m_batch);
+    return r;
+}
+
+void mbCoreLogger::run()
+{
+    while (!m_stop.load(std::memory_order_acquire))
+    {
+        process(true);
+        m_waitLock.lock();
+        // Note: queue is drained, producers are woken up under the lock, so wake up can't be lost
+        m_notFull.wakeAll();
+        if (!m_stop.load(std::memory_order_acquire))
+            m_wait.wait(&m_waitLock, FlushPeriod);
+        m_waitLock.unlock();
+    }
+    // Note: GUI event loop is already finished, so rest of the lines are taken by 'takeBatch()'
+    process(false);
+    closeFile();
+}
+
+void mbCoreLogger::enqueue(Entry *e)
+{
+    e->next.store(nullptr, std::memory_order_relaxed);
+    Entry *prev = m_tail.exchange(e, std::memory_order_acq_rel);
+    prev->next.store(e, std::memory_order_release);
+}
+
+mbCoreLogger::Entry *mbCoreLogger::dequeue()
+{
+    Entry *head = m_head;
+    Entry *next = head->next.load(std::memory_order_acquire);
+    if (head == &m_stub)
+    {
+        if (!next)
+            return nullptr;
+        m_head = next;
+        head = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if (next)
+    {
+        m_head = next;
+        return head;
+    }
+    // 'head' is the last entry or producer has not linked next one yet
+    if (head != m_tail.load(std::memory_order_acquire))
+        return nullptr;
+    enqueue(&m_stub);
+    next = head->next.load(std::memory_order_acquire);
+    if (next)
+    {
+        m_head = next;
+        return head;
+    }
+    return nullptr;
+}
+
+void mbCoreLogger::process(bool deliver)
+{
+    m_settingsLock.lock();
+    if (m_settings.changed)
+    {
+        m_settings.changed = false;
+        m_useTimestamp     = m_settings.useTimestamp;
+        m_formatDateTime   = m_settings.formatDateTime;
+        m_fileMaxSize      = m_settings.fileMaxSize;
+        m_fileRotatePeriod = static_cast<qint64>(m_settings.fileRotatePeriod) * 1000;
+        m_fileCount        = m_settings.fileCount;
+        if (m_file.fileName() != m_settings.fileName)
+        {
+            closeFile();
+            m_file.setFileName(m_settings.fileName);
+            m_fileFailed = 0;
+        }
+    }
+    m_settingsLock.unlock();
+
+    Entry *e;
+    if (dropPolicy() == DropOldest)
+    {
+        int surplus = m_count.load(std::memory_order_acquire) - queueSize();
+        while (surplus-- > 0 && (e = dequeue()))
+        {
+            m_count.fetch_sub(1, std::memory_order_release);
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            delete e;
+        }
+    }
+    while ((e = dequeue()))
+    {
+        m_count.fetch_sub(1, std::memory_order_release);
+        output(e->source, e->text, e->timestamp);
+        delete e;
+    }
+    processTrace();
+
+    quint64 dropped = droppedCount();
+    if (dropped != m_droppedReported)
+    {
+        output(QStringLiteral("Logger"), QString("%1 log messages dropped (queue is full)").arg(dropped - m_droppedReported), mb::currentTimestamp());
+        m_droppedReported = dropped;
+    }
+    quint64 droppedBatch = droppedBatchCount();
+    if (droppedBatch != m_droppedBatchReported)
+    {
+        output(QStringLiteral("Logger"), QString("%1 log lines were not shown (GUI is busy)").arg(droppedBatch - m_droppedBatchReported), mb::currentTimestamp());
+        m_droppedBatchReported = droppedBatch;
+    }
+    flush(deliver);
+}
+
+void mbCoreLogger::processTrace()
+{
+    if (!m_traceRing)
+        return;
+    int c;
+    while ((c = m_traceRing->pop(m_traceRecords.data(), m_traceRecords.count())) > 0)
+    {
+        for (int i = 0; i < c; i++)
+        {
+            const mbCoreTraceRing::Record &r = m_traceRecords.at(i);
+            QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char*>(r.data), r.size);
+            QString text = (r.format == mbCoreTraceRing::Ascii) ? Modbus::asciiToString(bytes) : Modbus::bytesToString(bytes);
+            text.prepend((r.direction == mbCoreTraceRing::Tx) ? QStringLiteral("Tx: ") : QStringLiteral("Rx: "));
+            output(r.connection.isEmpty() ? m_traceRing->sourceName(r.source) : r.connection, text, r.timestamp);
+        }
+    }
+    quint64 lost = m_traceRing->takeLost();
+    if (lost)
+        output(QStringLiteral("Logger"), QString("Tx/Rx trace: %1 frames lost").arg(lost), mb::currentTimestamp());
+}
+
+void mbCoreLogger::output(const QString &source, const QString &text, mb::Timestamp_t timestamp)
+{
+    QString msg = QString("'%1': %2").arg(source, text);
+    if (m_useTimestamp)
+        msg = QString("%1 %2").arg(QDateTime::fromMSecsSinceEpoch(timestamp).toString(m_formatDateTime), msg);
+    if (m_file.fileName().count())
+    {
+        m_fileBuffer.append(msg.toUtf8());
+        m_fileBuffer.append('\n');
+    }
+    m_batch.append(msg);
+}
+
+void mbCoreLogger::flush(bool deliver)
+{
+    if (m_fileBuffer.count())
+    {
+        if (!m_file.isOpen())
+            openFile();
+        if (m_file.isOpen())
+        {
+            if ((m_fileMaxSize > 0 && m_file.size() > 0 && m_file.size() + m_fileBuffer.size() > m_fileMaxSize) ||
+                (m_fileRotatePeriod > 0 && mb::currentTimestamp() - m_fileOpened >= m_fileRotatePeriod))
+                rotateFile();
+            // Note: file can't be reopened after rotation
+            if (m_file.isOpen())
+            {
+                m_file.write(m_fileBuffer);
+                m_file.flush();
+            }
+        }
+        // Note: while file can't be opened its lines are discarded (GUI still gets them)
+        m_fileBuffer.clear();
+    }
+
+    if (m_batch.isEmpty() || !deliver)
+        return;
+    if (!m_batchBusy.exchange(true, std::memory_order_acq_rel))
+    {
+        Q_EMIT signalMessages(m_batch);
+        m_batch.clear();
+    }
+    else if (m_batch.count() > BatchMaxCount)
+    {
+        // GUI is still busy with the previous batch: keep only the latest lines
+        int c = m_batch.count() - BatchMaxCount;
+        m_batch.erase(m_batch.begin(), m_batch.begin() + c);
+        m_droppedBatch.fetch_add(c, std::memory_order_relaxed);
+    }
+}
+
+void mbCoreLogger::openFile()
+{
+    if (m_file.fileName().isEmpty())
+        return;
+    // Note: failed open is retried (and reported) once per 'FileRetryPeriod', not on every flush
+    mb::Timestamp_t now = mb::currentTimestamp();
+    if (m_fileFailed && now - m_fileFailed < FileRetryPeriod)
+        return;
+    if (m_file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
+    {
+        m_fileOpened = now;
+        m_fileFailed = 0;
+    }
+    else
+    {
+        m_fileFailed = now;
+        output(QStringLiteral("Logger"), QString("Can't open log file '%1': %2 (retry in %3 s)").arg(m_file.fileName(), m_file.errorString()).arg(FileRetryPeriod / 1000), now);
+    }
+}
+
+void mbCoreLogger::rotateFile()
+{
+    // 'name' -> 'name.1' -> ... -> 'name.<fileCount>' (removed)
+    QString name = m_file.fileName();
+    m_file.close();
+    if (m_fileCount > 0)
+    {
+        QFile::remove(QString("%1.%2").arg(name).arg(m_fileCount));
+        for (int i = m_fileCount-1; i > 0; i--)
+            QFile::rename(QString("%1.%2").arg(name).arg(i), QString("%1.%2").arg(name).arg(i+1));
+        QFile::rename(name, name+QStringLiteral(".1"));
+    }
+    else
+        QFile::remove(name);
+    openFile();
+}
+
+void mbCoreLogger::closeFile()
+{
+    if (m_file.isOpen())
+        m_file.close();
+}
@@ -0,0 +1,171 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef CORE_LOGGER_H
+#define CORE_LOGGER_H
+
+#include <atomic>
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QStringList>
+#include <QFile>
+
+#include <mbcore.h>
+
+#include <runtime/core_tracering.h>
+
+// Logging thread. Producers (GUI, port threads) push messages
+// into lock-free multi-producer single-consumer queue and never touch file or GUI.
+// Logger thread formats messages (including raw Tx/Rx frames of trace ring),
+// writes them to the rotated log file and delivers them to GUI in batches.
+class MB_EXPORT mbCoreLogger : public QThread
+{
+    Q_OBJECT
+
+public:
+    // what to do when queue is full
+    enum DropPolicy
+    {
+        DropNewest, // new message is discarded
+        DropOldest, // oldest queued messages are discarded by logger thread
+        Block       // producer waits until logger thread makes room
+    };
+    Q_ENUM(DropPolicy)
+
+    static const int FlushPeriod = 50;    // max delay (milliseconds) of file/GUI output
+    static const int BatchMaxCount = 1000; // max count of undelivered GUI lines
+    static const int FileRetryPeriod = 5000; // min delay (milliseconds) between attempts to open the log file
+
+public:
+    explicit mbCoreLogger(mbCoreTraceRing *traceRing, QObject *parent = nullptr);
+    ~mbCoreLogger();
+
+public: // settings
+    inline int queueSize() const { return m_queueSize.load(std::memory_order_relaxed); }
+    void setQueueSize(int queueSize);
+    inline DropPolicy dropPolicy() const { return static_cast<DropPolicy>(m_dropPolicy.load(std::memory_order_relaxed)); }
+    inline void setDropPolicy(DropPolicy dropPolicy) { m_dropPolicy.store(dropPolicy, std::memory_order_relaxed); }
+    bool useTimestamp() const;
+    void setUseTimestamp(bool useTimestamp);
+    QString formatDateTime() const;
+    void setFormatDateTime(const QString &formatDateTime);
+    QString fileName() const;
+    void setFileName(const QString &fileName);
+    qint64 fileMaxSize() const;
+    void setFileMaxSize(qint64 fileMaxSize);
+    int fileRotatePeriod() const;
+    void setFileRotatePeriod(int seconds);
+    int fileCount() const;
+    void setFileCount(int fileCount);
+
+public: // statistics
+    // messages discarded because queue was full
+    inline quint64 droppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+    // lines discarded because GUI could not keep up
+    inline quint64 droppedBatchCount() const { return m_droppedBatch.load(std::memory_order_relaxed); }
+
+public:
+    // thread safe, never blocks unless drop policy is 'Block' and queue is full
+    void push(const QString &source, const QString &text, mb::Timestamp_t timestamp);
+    // GUI confirms that last batch was shown, so the next one can be sent
+    inline void confirmBatch() { m_batchBusy.store(false, std::memory_order_release); }
+    // stops logger thread, flushes all queued messages to the file and waits for thread to finish
+    void stop();
+    // returns lines that were not delivered by 'signalMessages' (use after 'stop()')
+    QStringList takeBatch();
+
+Q_SIGNALS:
+    void signalMessages(const QStringList &messages);
+
+protected:
+    void run() override;
+
+private:
+    struct Entry
+    {
+        std::atomic<Entry*> next;
+        mb::Timestamp_t timestamp;
+        QString source;
+        QString text;
+    };
+
+private:
+    void enqueue(Entry *e);
+    Entry *dequeue();
+    void process(bool deliver);
+    void processTrace();
+    void output(const QString &source, const QString &text, mb::Timestamp_t timestamp);
+    void flush(bool deliver);
+    void openFile();
+    void rotateFile();
+    void closeFile();
+
+private:
+    mbCoreTraceRing *m_traceRing;
+
+    // Vyukov intrusive MPSC queue: producers exchange 'm_tail', consumer owns 'm_head'
+    Entry m_stub;
+    std::atomic<Entry*> m_tail;
+    Entry *m_head;
+    std::atomic<int> m_count;
+    std::atomic<int> m_queueSize;
+    std::atomic<int> m_dropPolicy;
+    std::atomic<quint64> m_dropped;
+    std::atomic<quint64> m_droppedBatch;
+    std::atomic<bool> m_batchBusy;
+    std::atomic<bool> m_stop;
+    quint64 m_droppedReported;
+    quint64 m_droppedBatchReported;
+
+    QMutex m_waitLock;
+    QWaitCondition m_wait;
+    QWaitCondition m_notFull; // producers wait for room in the queue (drop policy 'Block')
+
+    mutable QMutex m_settingsLock;
+    struct
+    {
+        bool    useTimestamp    ;
+        QString formatDateTime  ;
+        QString fileName        ;
+        qint64  fileMaxSize     ;
+        int     fileRotatePeriod;
+        int     fileCount       ;
+        bool    changed         ;
+    } m_settings;
+
+    // logger thread only
+    bool m_useTimestamp;
+    QString m_formatDateTime;
+    QFile m_file;
+    qint64 m_fileMaxSize;
+    qint64 m_fileRotatePeriod;
+    int m_fileCount;
+    mb::Timestamp_t m_fileOpened;
+    mb::Timestamp_t m_fileFailed; // time of the last failed attempt to open the file, 0 - none
+    QByteArray m_fileBuffer;
+    QStringList m_batch;
+    QVector<mbCoreTraceRing::Record> m_traceRecords;
+};
+
+#endif // CORE_LOGGER_H
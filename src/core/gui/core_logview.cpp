@@ -58,3 +58,9 @@ void mbCoreLogView::showMessage(const QString &message)
 {
     m_text->appendPlainText(message);
 }
+
+void mbCoreLogView::showMessages(const QStringList &messages)
+{
+    // single append per batch: one layout pass instead of one per line
+    m_text->appendPlainText(messages.join(QChar('\n')));
+}
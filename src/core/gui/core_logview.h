@@ -37,6 +37,7 @@ public:
 public Q_SLOTS:
     void clear();
     void showMessage(const QString& message);
+    void showMessages(const QStringList& messages);
 
 Q_SIGNALS:
 
@@ -162,6 +162,11 @@ void mbCoreUi::showMessage(const QString &message)
     m_logView->showMessage(message);
 }
 
+void mbCoreUi::showMessages(const QStringList &messages)
+{
+    m_logView->showMessages(messages);
+}
+
 void mbCoreUi::menuSlotFileNew()
 {
     if (m_core->isRunning())
@@ -93,6 +93,7 @@ public: // settings
 
 public Q_SLOTS:
     void showMessage(const QString& message);
+    void showMessages(const QStringList& messages);
 
 protected Q_SLOTS:
     // ----------------------------
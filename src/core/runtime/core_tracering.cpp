@@ -0,0 +1,106 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "core_tracering.h"
+
+#include <cstring>
+
+mbCoreTraceRing::mbCoreTraceRing(int capacity)
+{
+    m_records.resize(qMax(capacity, 1));
+    m_head = 0;
+    m_count = 0;
+    m_lost = 0;
+}
+
+int mbCoreTraceRing::source(const QString &name)
+{
+    QMutexLocker _(&m_lock);
+    QHash<QString, int>::const_iterator it = m_sources.constFind(name);
+    if (it != m_sources.constEnd())
+        return it.value();
+    int id = m_sourceNames.count();
+    m_sourceNames.append(name);
+    m_sources.insert(name, id);
+    return id;
+}
+
+QString mbCoreTraceRing::sourceName(int source) const
+{
+    QMutexLocker _(&m_lock);
+    return m_sourceNames.value(source);
+}
+
+bool mbCoreTraceRing::push(int source, Direction direction, Format format, const QByteArray &data, const QString &connection)
+{
+    int size = qMin(data.size(), static_cast<int>(sizeof(Record::data)));
+    QMutexLocker _(&m_lock);
+    bool wasEmpty = (m_count == 0);
+    int i = m_head + m_count;
+    if (i >= m_records.count())
+        i -= m_records.count();
+    if (m_count == m_records.count()) // full: overwrite the oldest
+    {
+        m_head = (m_head + 1) % m_records.count();
+        m_lost++;
+    }
+    else
+        m_count++;
+    Record &r = m_records[i];
+    r.timestamp = mb::currentTimestamp();
+    r.source = source;
+    r.direction = direction;
+    r.format = format;
+    r.connection = connection;
+    r.size = size;
+    memcpy(r.data, data.constData(), static_cast<size_t>(size));
+    return wasEmpty;
+}
+
+int mbCoreTraceRing::pop(Record *records, int maxCount)
+{
+    QMutexLocker _(&m_lock);
+    int c = qMin(maxCount, m_count);
+    for (int i = 0; i < c; i++)
+    {
+        const Record &r = m_records.at(m_head);
+        Record &out = records[i];
+        out.timestamp = r.timestamp;
+        out.source = r.source;
+        out.direction = r.direction;
+        out.format = r.format;
+        out.connection = r.connection;
+        out.size = r.size;
+        memcpy(out.data, r.data, static_cast<size_t>(r.size));
+        m_head = (m_head + 1) % m_records.count();
+    }
+    m_count -= c;
+    return c;
+}
+
+quint64 mbCoreTraceRing::takeLost()
+{
+    QMutexLocker _(&m_lock);
+    quint64 lost = m_lost;
+    m_lost = 0;
+    return lost;
+}
@@ -0,0 +1,88 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef CORE_TRACERING_H
+#define CORE_TRACERING_H
+
+#include <QMutex>
+#include <QStringList>
+
+#include <mbcore.h>
+
+// Fixed size ring of raw Tx/Rx frames. Port threads push frames without formatting
+// and any memory allocation, text is made by consumer only. When the ring is full
+// the oldest record is overwritten and counted as lost.
+// Sources (ports, devices) are registered once, connections of the source (e.g. clients
+// of TCP server) are not registered but kept within the record (implicitly shared name).
+class MB_EXPORT mbCoreTraceRing
+{
+public:
+    enum Direction
+    {
+        Tx,
+        Rx
+    };
+
+    enum Format
+    {
+        Bytes,
+        Ascii
+    };
+
+    struct Record
+    {
+        mb::Timestamp_t timestamp;
+        int source;
+        Direction direction;
+        Format format;
+        QString connection; // name of the connection of the source, empty - the source itself
+        int size;
+        uint8_t data[MB_ASC_IO_BUFF_SZ];
+    };
+
+public:
+    explicit mbCoreTraceRing(int capacity = 1024);
+
+public:
+    // returns id of the source with 'name', registers new source if there is no such one
+    int source(const QString &name);
+    QString sourceName(int source) const;
+
+public:
+    // returns true if ring was empty before, so consumer must be notified
+    bool push(int source, Direction direction, Format format, const QByteArray &data, const QString &connection = QString());
+    // pops at most 'maxCount' oldest records, returns count of popped records
+    int pop(Record *records, int maxCount);
+    // returns count of lost records since last call
+    quint64 takeLost();
+
+private:
+    mutable QMutex m_lock;
+    QVector<Record> m_records;
+    int m_head;
+    int m_count;
+    quint64 m_lost;
+    QHash<QString, int> m_sources;
+    QStringList m_sourceNames;
+};
+
+#endif // CORE_TRACERING_H
@@ -1,7 +1,9 @@
 HEADERS += \
     $$PWD/core_runtaskthread.h \
-    $$PWD/core_runtime.h
+    $$PWD/core_runtime.h \
+    $$PWD/core_tracering.h
 
 SOURCES += \
     $$PWD/core_runtaskthread.cpp \
-    $$PWD/core_runtime.cpp
+    $$PWD/core_runtime.cpp \
+    $$PWD/core_tracering.cpp
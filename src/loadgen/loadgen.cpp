@@ -0,0 +1,477 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "loadgen.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include <QEventLoop>
+#include <QAbstractEventDispatcher>
+#include <QTimer>
+
+#include <ModbusClientPort.h>
+#include <ModbusServerPort.h>
+
+// ------------------------------------------------------------------------------------------------------------------
+// ------------------------------------------------- LoadHistogram --------------------------------------------------
+// ------------------------------------------------------------------------------------------------------------------
+
+LoadHistogram::LoadHistogram() :
+    m_buckets(BucketCount, 0),
+    m_count(0),
+    m_sum(0),
+    m_max(0)
+{
+}
+
+void LoadHistogram::add(quint64 v)
+{
+    m_buckets[Modbus::histogramBucket(v)]++;
+    m_count++;
+    m_sum += v;
+    if (v > m_max)
+        m_max = v;
+}
+
+void LoadHistogram::add(const LoadHistogram &other)
+{
+    for (int i = 0; i < BucketCount; i++)
+        m_buckets[i] += other.m_buckets.at(i);
+    m_count += other.m_count;
+    m_sum += other.m_sum;
+    if (other.m_max > m_max)
+        m_max = other.m_max;
+}
+
+quint64 LoadHistogram::percentile(double p) const
+{
+    quint64 v = Modbus::histogramPercentile(m_buckets.constData(), BucketCount, m_count, p);
+    return v < m_max ? v : m_max;
+}
+
+// ------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------- LoadDevice ---------------------------------------------------
+// ------------------------------------------------------------------------------------------------------------------
+
+LoadDevice::LoadDevice() :
+    m_coils(0x10000 / 8, 0),
+    m_discretes(0x10000 / 8, 0),
+    m_holdings(0x10000, 0),
+    m_inputs(0x10000, 0)
+{
+}
+
+Modbus::StatusCode LoadDevice::readCoils(uint8_t /*unit*/, uint16_t offset, uint16_t count, void *values)
+{
+    return readBits(m_coils, offset, count, values);
+}
+
+Modbus::StatusCode LoadDevice::readDiscreteInputs(uint8_t /*unit*/, uint16_t offset, uint16_t count, void *values)
+{
+    return readBits(m_discretes, offset, count, values);
+}
+
+Modbus::StatusCode LoadDevice::readHoldingRegisters(uint8_t /*unit*/, uint16_t offset, uint16_t count, uint16_t *values)
+{
+    return readRegs(m_holdings, offset, count, values);
+}
+
+Modbus::StatusCode LoadDevice::readInputRegisters(uint8_t /*unit*/, uint16_t offset, uint16_t count, uint16_t *values)
+{
+    return readRegs(m_inputs, offset, count, values);
+}
+
+Modbus::StatusCode LoadDevice::writeSingleCoil(uint8_t /*unit*/, uint16_t offset, bool value)
+{
+    char &c = m_coils[offset / 8];
+    if (value)
+        c = static_cast<char>(c | (1 << (offset % 8)));
+    else
+        c = static_cast<char>(c & ~(1 << (offset % 8)));
+    return Modbus::Status_Good;
+}
+
+Modbus::StatusCode LoadDevice::writeSingleRegister(uint8_t /*unit*/, uint16_t offset, uint16_t value)
+{
+    m_holdings[offset] = value;
+    return Modbus::Status_Good;
+}
+
+Modbus::StatusCode LoadDevice::readExceptionStatus(uint8_t /*unit*/, uint8_t *status)
+{
+    *status = 0;
+    return Modbus::Status_Good;
+}
+
+Modbus::StatusCode LoadDevice::writeMultipleCoils(uint8_t unit, uint16_t offset, uint16_t count, const void *values)
+{
+    if (static_cast<int>(offset) + count > 0x10000)
+        return Modbus::Status_BadIllegalDataAddress;
+    const uint8_t *bits = reinterpret_cast<const uint8_t*>(values);
+    for (uint16_t i = 0; i < count; i++)
+        writeSingleCoil(unit, static_cast<uint16_t>(offset + i), (bits[i / 8] >> (i % 8)) & 1);
+    return Modbus::Status_Good;
+}
+
+Modbus::StatusCode LoadDevice::writeMultipleRegisters(uint8_t /*unit*/, uint16_t offset, uint16_t count, const uint16_t *values)
+{
+    if (static_cast<int>(offset) + count > m_holdings.count())
+        return Modbus::Status_BadIllegalDataAddress;
+    memcpy(m_holdings.data() + offset, values, count * sizeof(uint16_t));
+    return Modbus::Status_Good;
+}
+
+Modbus::StatusCode LoadDevice::readBits(const QByteArray &bits, uint16_t offset, uint16_t count, void *values)
+{
+    if (static_cast<int>(offset) + count > bits.count() * 8)
+        return Modbus::Status_BadIllegalDataAddress;
+    uint8_t *out = reinterpret_cast<uint8_t*>(values);
+    memset(out, 0, (count + 7) / 8);
+    for (uint16_t i = 0; i < count; i++)
+    {
+        int b = offset + i;
+        if ((bits.at(b / 8) >> (b % 8)) & 1)
+            out[i / 8] |= static_cast<uint8_t>(1 << (i % 8));
+    }
+    return Modbus::Status_Good;
+}
+
+Modbus::StatusCode LoadDevice::readRegs(const QVector<uint16_t> &regs, uint16_t offset, uint16_t count, uint16_t *values)
+{
+    if (static_cast<int>(offset) + count > regs.count())
+        return Modbus::Status_BadIllegalDataAddress;
+    memcpy(values, regs.constData() + offset, count * sizeof(uint16_t));
+    return Modbus::Status_Good;
+}
+
+// ------------------------------------------------------------------------------------------------------------------
+// --------------------------------------------------- LoadServer ---------------------------------------------------
+// ------------------------------------------------------------------------------------------------------------------
+
+LoadServer::LoadServer(const Modbus::Settings &settings) :
+    m_settings(settings),
+    m_ctrlRun(true),
+    m_ready(false)
+{
+}
+
+void LoadServer::stop()
+{
+    m_ctrlRun = false;
+    QAbstractEventDispatcher *dispatcher = eventDispatcher();
+    if (dispatcher)
+        dispatcher->wakeUp();
+}
+
+void LoadServer::run()
+{
+    QEventLoop loop;
+    QTimer timer;
+    timer.setSingleShot(true);
+    LoadDevice device;
+    Modbus::ServerPort *port = Modbus::createServerPort(m_settings, &device);
+    if (!port)
+        return;
+    while (m_ctrlRun)
+    {
+        Modbus::updateMonotonicTime();
+        loop.processEvents();
+        Modbus::StatusCode r = port->process();
+        if (!m_ready)
+        {
+            if (Modbus::StatusIsBad(r))
+            {
+                fprintf(stderr, "loopback server: failed to open port (status 0x%08x)\n", static_cast<unsigned>(r));
+                break;
+            }
+            if (port->isOpen())
+                m_ready = true;
+        }
+        int timeout = port->idleTimeout();
+        if (timeout > 0)
+        {
+            timer.start(timeout);
+            loop.processEvents(QEventLoop::WaitForMoreEvents);
+        }
+        else if (timeout < 0) // no connections yet
+        {
+            timer.stop();
+            loop.processEvents(QEventLoop::WaitForMoreEvents);
+        }
+        else
+            QThread::usleep(1);
+    }
+    port->close();
+    delete port;
+}
+
+// ------------------------------------------------------------------------------------------------------------------
+// ------------------------------------------------- LoadGenerator --------------------------------------------------
+// ------------------------------------------------------------------------------------------------------------------
+
+LoadGenerator::Settings::Settings() :
+    unit(1),
+    connections(1),
+    concurrency(1),
+    rate(0),
+    duration(10000),
+    timeout(3000),
+    offset(0),
+    range(100),
+    count(10)
+{
+    mix.append(MBF_READ_HOLDING_REGISTERS);
+}
+
+LoadGenerator::Result::Result() :
+    requests(0),
+    good(0),
+    errors(0),
+    backlog(0),
+    seconds(0)
+{
+}
+
+LoadGenerator::LoadGenerator(const Settings &settings) :
+    m_settings(settings)
+{
+    memset(m_values, 0, sizeof(m_values));
+    memset(m_bits, 0, sizeof(m_bits));
+}
+
+LoadGenerator::~LoadGenerator()
+{
+    for (int i = 0; i < m_connections.count(); i++)
+        delete m_connections.at(i).port; // Note: clients are children of the port
+}
+
+bool LoadGenerator::parseMix(const QString &s, QVector<uint8_t> &mix)
+{
+    mix.clear();
+    const QStringList items = s.split(QLatin1Char(','), Qt::SkipEmptyParts);
+    Q_FOREACH (const QString &item, items)
+    {
+        QStringList p = item.split(QLatin1Char(':'));
+        bool ok;
+        int func = p.at(0).trimmed().toInt(&ok);
+        if (!ok)
+            return false;
+        switch (func)
+        {
+        case MBF_READ_COILS:
+        case MBF_READ_DISCRETE_INPUTS:
+        case MBF_READ_HOLDING_REGISTERS:
+        case MBF_READ_INPUT_REGISTERS:
+        case MBF_WRITE_SINGLE_COIL:
+        case MBF_WRITE_SINGLE_REGISTER:
+        case MBF_READ_EXCEPTION_STATUS:
+        case MBF_WRITE_MULTIPLE_COILS:
+        case MBF_WRITE_MULTIPLE_REGISTERS:
+            break;
+        default:
+            return false;
+        }
+        int weight = 1;
+        if (p.count() > 1)
+        {
+            weight = p.at(1).trimmed().toInt(&ok);
+            if (!ok || weight < 0 || weight > 10000)
+                return false;
+        }
+        for (int i = 0; i < weight; i++)
+            mix.append(static_cast<uint8_t>(func));
+    }
+    return !mix.isEmpty();
+}
+
+LoadGenerator::Result LoadGenerator::run()
+{
+    Result res;
+    const int concurrency = m_settings.concurrency > 0 ? m_settings.concurrency : 1;
+    m_connections.resize(m_settings.connections > 0 ? m_settings.connections : 1);
+    const double interval = m_settings.rate > 0 ? 1e9 * m_connections.count() / m_settings.rate : 0;
+    for (int i = 0; i < m_connections.count(); i++)
+    {
+        Connection &c = m_connections[i];
+        c.port = Modbus::createClientPort(m_settings.port);
+        if (!c.port)
+        {
+            m_connections.resize(i);
+            return res;
+        }
+        c.port->setPipelineWindow(static_cast<uint32_t>(concurrency));
+        c.requests.resize(concurrency);
+        for (int j = 0; j < concurrency; j++)
+        {
+            Slot &slot = c.requests[j];
+            slot.client = new Modbus::Client(m_settings.unit, c.port, c.port);
+            slot.start = -1;
+        }
+        // spread connections over the first interval so they don't send in bursts
+        c.due = interval * i / m_connections.count();
+        c.backlog = 0;
+    }
+
+    QEventLoop loop;
+    QTimer timer;
+    timer.setSingleShot(true);
+    timer.setTimerType(Qt::PreciseTimer);
+    const qint64 end = static_cast<qint64>(m_settings.duration) * 1000000;
+    // requests in flight are waited after the end of run for one timeout period
+    const qint64 drain = end + static_cast<qint64>(m_settings.timeout) * 1000000;
+    m_timer.start();
+    for (;;)
+    {
+        Modbus::updateMonotonicTime();
+        loop.processEvents();
+        qint64 now = m_timer.nsecsElapsed();
+        bool running = now < end;
+        int inflight = 0;
+        double due = -1;
+        for (int i = 0; i < m_connections.count(); i++)
+        {
+            Connection &c = m_connections[i];
+            if (interval > 0 && running)
+            {
+                while (c.due <= now)
+                {
+                    c.backlog++;
+                    c.due += interval;
+                }
+                if (due < 0 || c.due < due)
+                    due = c.due;
+            }
+            for (int j = 0; j < c.requests.count(); j++)
+            {
+                Slot &slot = c.requests[j];
+                if (slot.start < 0)
+                {
+                    if (!running)
+                        continue;
+                    if (interval <= 0)
+                        begin(slot, now);
+                    else if (c.backlog)
+                    {
+                        // latency is counted from the scheduled time, not from the time request is sent
+                        begin(slot, static_cast<qint64>(c.due - interval * c.backlog));
+                        c.backlog--;
+                    }
+                    else
+                        continue;
+                }
+                Modbus::StatusCode r = exec(slot);
+                if (Modbus::StatusIsProcessing(r))
+                {
+                    inflight++;
+                    continue;
+                }
+                qint64 t = m_timer.nsecsElapsed();
+                res.requests++;
+                if (Modbus::StatusIsBad(r))
+                    res.errors++;
+                else
+                {
+                    res.good++;
+                    res.latency.add(static_cast<quint64>(t - slot.start) / 1000);
+                }
+                slot.start = -1;
+            }
+        }
+        if (!running && (!inflight || now >= drain))
+            break;
+        // block until socket activity, next scheduled request or 1 ms (to check up timeouts)
+        // Note: timer has millisecond resolution, so it's started for the whole milliseconds before
+        // the next scheduled request and the rest (less than 1 ms) is spun with non-blocking processing
+        qint64 wait = 1000000;
+        if (due >= 0 && static_cast<qint64>(due) - now < wait)
+            wait = static_cast<qint64>(due) - now;
+        if (wait >= 1000000 && (inflight || due >= 0))
+        {
+            timer.start(static_cast<int>(wait / 1000000));
+            loop.processEvents(QEventLoop::WaitForMoreEvents);
+        }
+    }
+    res.seconds = m_timer.nsecsElapsed() / 1e9;
+    for (int i = 0; i < m_connections.count(); i++)
+    {
+        res.backlog += m_connections.at(i).backlog;
+        m_connections.at(i).port->close();
+    }
+    return res;
+}
+
+void LoadGenerator::begin(Slot &slot, qint64 start)
+{
+    slot.func = m_settings.mix.at(static_cast<int>(m_random.bounded(static_cast<quint32>(m_settings.mix.count()))));
+    uint16_t count;
+    switch (slot.func)
+    {
+    case MBF_READ_COILS:
+    case MBF_READ_DISCRETE_INPUTS:
+    case MBF_WRITE_MULTIPLE_COILS:
+        count = m_settings.count < MB_MAX_DISCRETS ? m_settings.count : static_cast<uint16_t>(MB_MAX_DISCRETS);
+        break;
+    case MBF_READ_HOLDING_REGISTERS:
+    case MBF_READ_INPUT_REGISTERS:
+    case MBF_WRITE_MULTIPLE_REGISTERS:
+        count = m_settings.count < MB_MAX_REGISTERS ? m_settings.count : static_cast<uint16_t>(MB_MAX_REGISTERS);
+        break;
+    default:
+        count = 1;
+        break;
+    }
+    if (!count)
+        count = 1;
+    uint16_t offset = m_settings.offset;
+    if (m_settings.range > count)
+        offset = static_cast<uint16_t>(offset + m_random.bounded(static_cast<quint32>(m_settings.range - count + 1)));
+    slot.offset = offset;
+    slot.count = count;
+    slot.start = start;
+}
+
+Modbus::StatusCode LoadGenerator::exec(Slot &slot)
+{
+    Modbus::Client *c = slot.client;
+    switch (slot.func)
+    {
+    case MBF_READ_COILS:
+        return c->readCoils(slot.offset, slot.count, m_bits);
+    case MBF_READ_DISCRETE_INPUTS:
+        return c->readDiscreteInputs(slot.offset, slot.count, m_bits);
+    case MBF_READ_HOLDING_REGISTERS:
+        return c->readHoldingRegisters(slot.offset, slot.count, m_values);
+    case MBF_READ_INPUT_REGISTERS:
+        return c->readInputRegisters(slot.offset, slot.count, m_values);
+    case MBF_WRITE_SINGLE_COIL:
+        return c->writeSingleCoil(slot.offset, true);
+    case MBF_WRITE_SINGLE_REGISTER:
+        return c->writeSingleRegister(slot.offset, slot.offset);
+    case MBF_READ_EXCEPTION_STATUS:
+        return c->readExceptionStatus(m_bits);
+    case MBF_WRITE_MULTIPLE_COILS:
+        return c->writeMultipleCoils(slot.offset, slot.count, m_bits);
+    default:
+        return c->writeMultipleRegisters(slot.offset, slot.count, m_values);
+    }
+}
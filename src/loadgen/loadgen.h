@@ -0,0 +1,180 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef LOADGEN_H
+#define LOADGEN_H
+
+#include <atomic>
+
+#include <QThread>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+
+#include <ModbusClient.h>
+
+// Latency histogram (microseconds) with buckets of 'Modbus::histogramBucket()', mean and exact max
+class LoadHistogram
+{
+public:
+    enum
+    {
+        BucketCount = Modbus::HistogramBucketCount
+    };
+
+public:
+    LoadHistogram();
+
+public:
+    void add(quint64 v);
+    void add(const LoadHistogram &other);
+    quint64 percentile(double p) const;
+    inline quint64 count() const { return m_count; }
+    inline quint64 max() const { return m_max; }
+    inline double mean() const { return m_count ? static_cast<double>(m_sum) / m_count : 0.0; }
+
+private:
+    QVector<quint64> m_buckets;
+    quint64 m_count;
+    quint64 m_sum;
+    quint64 m_max;
+};
+
+// Memory device for in-process loopback server
+class LoadDevice : public Modbus::Interface
+{
+public:
+    LoadDevice();
+
+public:
+    Modbus::StatusCode readCoils(uint8_t unit, uint16_t offset, uint16_t count, void *values) override;
+    Modbus::StatusCode readDiscreteInputs(uint8_t unit, uint16_t offset, uint16_t count, void *values) override;
+    Modbus::StatusCode readHoldingRegisters(uint8_t unit, uint16_t offset, uint16_t count, uint16_t *values) override;
+    Modbus::StatusCode readInputRegisters(uint8_t unit, uint16_t offset, uint16_t count, uint16_t *values) override;
+    Modbus::StatusCode writeSingleCoil(uint8_t unit, uint16_t offset, bool value) override;
+    Modbus::StatusCode writeSingleRegister(uint8_t unit, uint16_t offset, uint16_t value) override;
+    Modbus::StatusCode readExceptionStatus(uint8_t unit, uint8_t *status) override;
+    Modbus::StatusCode writeMultipleCoils(uint8_t unit, uint16_t offset, uint16_t count, const void *values) override;
+    Modbus::StatusCode writeMultipleRegisters(uint8_t unit, uint16_t offset, uint16_t count, const uint16_t *values) override;
+
+private:
+    Modbus::StatusCode readBits(const QByteArray &bits, uint16_t offset, uint16_t count, void *values);
+    Modbus::StatusCode readRegs(const QVector<uint16_t> &regs, uint16_t offset, uint16_t count, uint16_t *values);
+
+private:
+    QByteArray m_coils;
+    QByteArray m_discretes;
+    QVector<uint16_t> m_holdings;
+    QVector<uint16_t> m_inputs;
+};
+
+// In-process Modbus server (Modbus::createServerPort()) running in its own thread
+class LoadServer : public QThread
+{
+public:
+    explicit LoadServer(const Modbus::Settings &settings);
+
+public:
+    void stop();
+    inline bool isReady() const { return m_ready; }
+
+protected:
+    void run() override;
+
+private:
+    Modbus::Settings m_settings;
+    std::atomic<bool> m_ctrlRun;
+    std::atomic<bool> m_ready;
+};
+
+class LoadGenerator
+{
+public:
+    struct Settings
+    {
+        Modbus::Settings port; // client port settings (see Modbus::createClientPort())
+        uint8_t unit;
+        int connections;
+        int concurrency;   // requests in flight per connection (closed loop) or its upper limit (open loop)
+        double rate;       // requests per second for all connections, 0 - closed loop
+        int duration;      // milliseconds
+        int timeout;       // milliseconds to wait for requests in flight after the end of run
+        QVector<uint8_t> mix; // function codes, each one repeated by its weight
+        uint16_t offset;
+        uint16_t range;
+        uint16_t count;
+
+        Settings();
+    };
+
+    struct Result
+    {
+        quint64 requests;
+        quint64 good;
+        quint64 errors;
+        quint64 backlog; // open loop: requests scheduled but not sent at the end of the run
+        double seconds;
+        LoadHistogram latency;
+
+        Result();
+    };
+
+public:
+    explicit LoadGenerator(const Settings &settings);
+    ~LoadGenerator();
+
+public:
+    static bool parseMix(const QString &s, QVector<uint8_t> &mix);
+    Result run();
+
+private:
+    struct Slot
+    {
+        Modbus::Client *client;
+        uint8_t func;
+        uint16_t offset;
+        uint16_t count;
+        qint64 start; // nanoseconds, -1 if slot is idle
+    };
+
+    struct Connection
+    {
+        Modbus::ClientPort *port;
+        QVector<Slot> requests;
+        double due;   // open loop: time (nanoseconds) of next scheduled request
+        quint64 backlog;
+    };
+
+private:
+    void begin(Slot &slot, qint64 start);
+    Modbus::StatusCode exec(Slot &slot);
+
+private:
+    Settings m_settings;
+    QVector<Connection> m_connections;
+    QElapsedTimer m_timer;
+    QRandomGenerator m_random;
+    uint16_t m_values[MB_MAX_REGISTERS];
+    uint8_t m_bits[MB_MAX_BYTES];
+};
+
+#endif // LOADGEN_H
@@ -0,0 +1,23 @@
+TEMPLATE = app
+TARGET = mbloadgen
+
+CONFIG += console no_keywords
+CONFIG -= app_bundle
+
+DESTDIR = ../bin
+
+QT = core network
+
+unix:QMAKE_RPATHDIR += .
+
+INCLUDEPATH += . \
+    $$PWD/../modbus
+
+HEADERS += \
+    loadgen.h
+
+SOURCES += \
+    loadgen.cpp \
+    main.cpp
+
+LIBS += -L../bin -lModbus
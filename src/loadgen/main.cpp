@@ -0,0 +1,155 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+// Headless load generator for Modbus TCP servers built on Modbus::Client.
+// Closed loop (default): every connection keeps '-concurrency' requests in flight (pipelined).
+// Open loop ('-rate'): requests are sent on schedule, latency is counted from the scheduled time.
+// '-server' starts in-process Modbus::ServerTCP on the loopback as the standard benchmark target.
+//
+// Usage: mbloadgen [-host <host>] [-port <port>] [-unit <unit>] [-connections <n>]
+//                  [-concurrency <n>] [-rate <requests per second>] [-duration <seconds>]
+//                  [-timeout <milliseconds>] [-mix <func[:weight],...>]
+//                  [-offset <address>] [-range <addresses>] [-count <values>] [-server]
+
+#include <cstdio>
+
+#include <QCoreApplication>
+
+#include <ModbusPortTCP.h>
+#include <ModbusServerTCP.h>
+
+#include "loadgen.h"
+
+static void usage()
+{
+    fprintf(stderr,
+            "Usage: mbloadgen [options]\n"
+            "  -host <host>          server host (default: localhost)\n"
+            "  -port <port>          server TCP port (default: 502)\n"
+            "  -unit <unit>          unit address (default: 1)\n"
+            "  -connections <n>      count of TCP connections (default: 1)\n"
+            "  -concurrency <n>      requests in flight per connection (default: 1)\n"
+            "  -rate <rps>           open loop: total requests per second (default: 0 - closed loop)\n"
+            "  -duration <seconds>   run duration (default: 10)\n"
+            "  -timeout <ms>         request timeout (default: 3000)\n"
+            "  -mix <func[:weight]>  comma separated function codes mix, e.g. 3:70,16:20,1:10 (default: 3)\n"
+            "  -offset <address>     first address of the range (default: 0)\n"
+            "  -range <addresses>    size of the address range (default: 100)\n"
+            "  -count <values>       count of values per request (default: 10)\n"
+            "  -server               start loopback Modbus TCP server in-process\n");
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+    LoadGenerator::Settings s;
+    QString host = QStringLiteral("localhost");
+    quint16 port = static_cast<quint16>(Modbus::STANDARD_TCP_PORT);
+    bool server = false;
+    bool ok = true;
+    for (int i = 1; ok && i < args.count(); i++)
+    {
+        const QString &a = args.at(i);
+        if (a == QStringLiteral("-server"))
+        {
+            server = true;
+            continue;
+        }
+        if (i + 1 >= args.count())
+        {
+            ok = false;
+            break;
+        }
+        const QString &v = args.at(++i);
+        if      (a == QStringLiteral("-host"       )) host = v;
+        else if (a == QStringLiteral("-port"       )) port = v.toUShort(&ok);
+        else if (a == QStringLiteral("-unit"       )) s.unit = static_cast<uint8_t>(v.toUShort(&ok));
+        else if (a == QStringLiteral("-connections")) s.connections = v.toInt(&ok);
+        else if (a == QStringLiteral("-concurrency")) s.concurrency = v.toInt(&ok);
+        else if (a == QStringLiteral("-rate"       )) s.rate = v.toDouble(&ok);
+        else if (a == QStringLiteral("-duration"   )) s.duration = static_cast<int>(v.toDouble(&ok) * 1000);
+        else if (a == QStringLiteral("-timeout"    )) s.timeout = v.toInt(&ok);
+        else if (a == QStringLiteral("-mix"        )) ok = LoadGenerator::parseMix(v, s.mix);
+        else if (a == QStringLiteral("-offset"     )) s.offset = v.toUShort(&ok);
+        else if (a == QStringLiteral("-range"      )) s.range = v.toUShort(&ok);
+        else if (a == QStringLiteral("-count"      )) s.count = v.toUShort(&ok);
+        else
+            ok = false;
+    }
+    if (!ok || s.connections < 1 || s.concurrency < 1 || s.rate < 0 || s.duration <= 0)
+    {
+        usage();
+        return 1;
+    }
+
+    LoadServer *loopback = nullptr;
+    if (server)
+    {
+        const Modbus::ServerTCP::Strings &ss = Modbus::ServerTCP::Strings::instance();
+        Modbus::Settings ps;
+        ps[Modbus::Port::Strings::instance().type] = Modbus::enumKey(Modbus::TCP);
+        ps[ss.port] = port;
+        ps[ss.eventDriven] = true;
+        host = QStringLiteral("127.0.0.1");
+        loopback = new LoadServer(ps);
+        loopback->start();
+        while (!loopback->isReady() && !loopback->isFinished())
+            QThread::msleep(1);
+        if (!loopback->isReady())
+        {
+            loopback->wait();
+            delete loopback;
+            return 1;
+        }
+    }
+
+    const Modbus::PortTCP::Strings &sTcp = Modbus::PortTCP::Strings::instance();
+    s.port[Modbus::Port::Strings::instance().type] = Modbus::enumKey(Modbus::TCP);
+    s.port[sTcp.host] = host;
+    s.port[sTcp.port] = port;
+    s.port[sTcp.timeout] = s.timeout;
+
+    LoadGenerator gen(s);
+    LoadGenerator::Result r = gen.run();
+
+    if (loopback)
+    {
+        loopback->stop();
+        loopback->wait();
+        delete loopback;
+    }
+
+    printf("bench=loadgen mode=%s connections=%d concurrency=%d rate=%.0f seconds=%.3f requests=%llu errors=%llu backlog=%llu rps=%.1f "
+           "p50_us=%llu p99_us=%llu p999_us=%llu max_us=%llu mean_us=%.1f\n",
+           s.rate > 0 ? "open" : "closed", s.connections, s.concurrency, s.rate, r.seconds,
+           static_cast<unsigned long long>(r.requests),
+           static_cast<unsigned long long>(r.errors),
+           static_cast<unsigned long long>(r.backlog),
+           r.seconds > 0 ? r.good / r.seconds : 0.0,
+           static_cast<unsigned long long>(r.latency.percentile(50)),
+           static_cast<unsigned long long>(r.latency.percentile(99)),
+           static_cast<unsigned long long>(r.latency.percentile(99.9)),
+           static_cast<unsigned long long>(r.latency.max()),
+           r.latency.mean());
+    return r.errors ? 2 : 0;
+}
@@ -29,83 +29,214 @@
 #include "ModbusPortTCP.h"
 #include "ModbusServerTCP.h"
 
+#include <cmath>
+#include <cstring>
+#include <chrono>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define MB_HEX_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace Modbus {
 
-uint16_t crc16(const uint8_t *bytes, uint32_t count)
+// Tables for slicing-by-8 CRC16 (reflected polynom 0xA001):
+// table[0] is classic byte table, table[k][b] is CRC of byte 'b' followed by k zero bytes
+struct Crc16Table
 {
-    uint16_t crc = 0xFFFF;
-    for (uint32_t i = 0; i < count; i++)
+    uint16_t table[8][256];
+
+    Crc16Table()
     {
-        crc ^= bytes[i];
-        for (uint32_t j = 0; j < 8; j++)
+        for (uint32_t b = 0; b < 256; b++)
         {
-            uint16_t temp = crc & 0x0001;
-            crc >>= 1;
-            if (temp) crc ^= 0xA001;
+            uint16_t crc = static_cast<uint16_t>(b);
+            for (uint32_t j = 0; j < 8; j++)
+            {
+                uint16_t temp = crc & 0x0001;
+                crc >>= 1;
+                if (temp) crc ^= 0xA001;
+            }
+            table[0][b] = crc;
+        }
+        for (uint32_t k = 1; k < 8; k++)
+        {
+            for (uint32_t b = 0; b < 256; b++)
+            {
+                uint16_t crc = table[k-1][b];
+                table[k][b] = (crc >> 8) ^ table[0][crc & 0xFF];
+            }
         }
     }
+};
+
+static const Crc16Table s_crc16;
+
+uint16_t crc16(const uint8_t *bytes, uint32_t count)
+{
+    const uint16_t (*t)[256] = s_crc16.table;
+    uint16_t crc = 0xFFFF;
+    for (; count >= 8; count -= 8, bytes += 8)
+    {
+        crc = t[7][bytes[0] ^ (crc & 0xFF)] ^
+              t[6][bytes[1] ^ (crc >> 8)  ] ^
+              t[5][bytes[2]] ^
+              t[4][bytes[3]] ^
+              t[3][bytes[4]] ^
+              t[2][bytes[5]] ^
+              t[1][bytes[6]] ^
+              t[0][bytes[7]];
+    }
+    for (; count; count--)
+        crc = (crc >> 8) ^ t[0][(crc ^ *bytes++) & 0xFF];
     return crc;
 }
 
 uint8_t lrc(const uint8_t *bytes, uint32_t count)
 {
-    uint8_t lrc = 0x00;
+    // Note: bytes are summed by 8 at a time in 16-bit lanes of 64-bit word,
+    // lanes are folded before they can overflow (every 128 words)
+    const uint64_t mask = 0x00FF00FF00FF00FFULL;
+    uint32_t lrc = 0;
+    while (count >= 8)
+    {
+        uint64_t sum = 0;
+        for (uint32_t i = 0; (i < 128) && (count >= 8); i++, count -= 8, bytes += 8)
+        {
+            uint64_t w;
+            memcpy(&w, bytes, sizeof(w));
+            sum += (w & mask) + ((w >> 8) & mask);
+        }
+        sum = (sum & 0x0000FFFF0000FFFFULL) + ((sum >> 16) & 0x0000FFFF0000FFFFULL);
+        lrc += static_cast<uint32_t>(sum) + static_cast<uint32_t>(sum >> 32);
+    }
     for (; count; count--)
         lrc += *bytes++;
-    return static_cast<uint8_t>(-static_cast<int8_t>(lrc));
+    return static_cast<uint8_t>(-static_cast<int8_t>(static_cast<uint8_t>(lrc)));
 }
 
-uint16_t bytesToAscii(uint8_t* bytesBuff, uint8_t* asciiBuff, uint16_t count)
+static const char s_hexDigits[] = "0123456789ABCDEF";
+
+// Reverse table for upper case hex digits, 0xFF - not a hex digit
+struct HexTable
 {
-    uint16_t i, j, qAscii = 0;
-    uint8_t tmp;
+    uint8_t nibble[256];
 
-    for (i = 0; i < count; i++)
+    HexTable()
     {
-        for (j = 0; j < 2; j++)
-        {
-            tmp = (bytesBuff[i] >> ((1 - j) * 4)) & 0x0F;
-            asciiBuff[i * 2 + j] = ((tmp < 10) ? (0x30 | tmp) : (55 + tmp));
-            qAscii++;
-        }
+        memset(nibble, 0xFF, sizeof(nibble));
+        for (uint8_t i = 0; i < 16; i++)
+            nibble[static_cast<uint8_t>(s_hexDigits[i])] = i;
+    }
+};
+
+static const HexTable s_hex;
+
+// Encodes 'count' bytes into '2*count' upper case hex digits
+static void hexEncode(const uint8_t *bytes, uint8_t *ascii, uint32_t count)
+{
+#ifdef MB_HEX_SSE2
+    const __m128i mask  = _mm_set1_epi8(0x0F);
+    const __m128i nine  = _mm_set1_epi8(9);
+    const __m128i zero  = _mm_set1_epi8('0');
+    const __m128i alpha = _mm_set1_epi8('A' - '0' - 10);
+    for (; count >= 16; count -= 16, bytes += 16, ascii += 32)
+    {
+        __m128i v  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+        __m128i lo = _mm_and_si128(v, mask);
+        hi = _mm_add_epi8(_mm_add_epi8(hi, zero), _mm_and_si128(_mm_cmpgt_epi8(hi, nine), alpha));
+        lo = _mm_add_epi8(_mm_add_epi8(lo, zero), _mm_and_si128(_mm_cmpgt_epi8(lo, nine), alpha));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(ascii)     , _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(ascii + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+#endif
+    for (; count; count--, bytes++, ascii += 2)
+    {
+        ascii[0] = static_cast<uint8_t>(s_hexDigits[*bytes >> 4]);
+        ascii[1] = static_cast<uint8_t>(s_hexDigits[*bytes & 0x0F]);
     }
-    return qAscii;
 }
 
-uint16_t asciiToBytes(uint8_t* asciiBuff, uint8_t* bytesBuff, uint16_t count)
+// Decodes 'count' upper case hex digits into '(count+1)/2' bytes (odd last digit is high nibble).
+// Returns false if there is not a hex digit
+static bool hexDecode(const uint8_t *ascii, uint8_t *bytes, uint32_t count)
 {
-    uint16_t i, j, qBytes = 0;
-    uint8_t tmp;
-    for (i = 0; i < count; i++)
+#ifdef MB_HEX_SSE2
+    const __m128i digitBase  = _mm_set1_epi8('0');
+    const __m128i digitMax   = _mm_set1_epi8(9);
+    const __m128i letterBase = _mm_set1_epi8('A');
+    const __m128i letterMax  = _mm_set1_epi8(5);
+    const __m128i ten        = _mm_set1_epi8(10);
+    const __m128i lowByte    = _mm_set1_epi16(0x00FF);
+    for (; count >= 32; count -= 32, ascii += 32, bytes += 16)
     {
-        j = i & 1;
-        if (!j)
+        __m128i r[2];
+        for (int i = 0; i < 2; i++)
         {
-            bytesBuff[i / 2] = 0;
-            qBytes++;
+            __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ascii + i * 16));
+            __m128i d = _mm_sub_epi8(c, digitBase);
+            __m128i l = _mm_sub_epi8(c, letterBase);
+            __m128i isDigit  = _mm_cmpeq_epi8(_mm_min_epu8(d, digitMax), d);  // unsigned d <= 9
+            __m128i isLetter = _mm_cmpeq_epi8(_mm_min_epu8(l, letterMax), l); // unsigned l <= 5
+            if (_mm_movemask_epi8(_mm_or_si128(isDigit, isLetter)) != 0xFFFF)
+                return false;
+            __m128i n = _mm_or_si128(_mm_and_si128(isDigit, d), _mm_and_si128(isLetter, _mm_add_epi8(l, ten)));
+            // every 16-bit lane holds pair of nibbles: high nibble in low byte
+            r[i] = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(n, lowByte), 4), _mm_srli_epi16(n, 8));
         }
-        tmp = asciiBuff[i];
-        if ((tmp >= '0') && (tmp <= '9'))
-            tmp &= 0x0F;
-        else if ((tmp >= 'A') && (tmp <= 'F'))
-            tmp -= 55;
-        else
-            return 0;
-        bytesBuff[i / 2] |= tmp << (4 * (1 - j));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(bytes), _mm_packus_epi16(r[0], r[1]));
     }
-    return qBytes;
+#endif
+    for (; count >= 2; count -= 2, ascii += 2, bytes++)
+    {
+        uint8_t hi = s_hex.nibble[ascii[0]];
+        uint8_t lo = s_hex.nibble[ascii[1]];
+        if ((hi | lo) & 0xF0)
+            return false;
+        *bytes = static_cast<uint8_t>((hi << 4) | lo);
+    }
+    if (count)
+    {
+        uint8_t hi = s_hex.nibble[ascii[0]];
+        if (hi & 0xF0)
+            return false;
+        *bytes = static_cast<uint8_t>(hi << 4);
+    }
+    return true;
+}
+
+uint16_t bytesToAscii(uint8_t* bytesBuff, uint8_t* asciiBuff, uint16_t count)
+{
+    hexEncode(bytesBuff, asciiBuff, count);
+    return count * 2;
+}
+
+uint16_t asciiToBytes(uint8_t* asciiBuff, uint8_t* bytesBuff, uint16_t count)
+{
+    if (!hexDecode(asciiBuff, bytesBuff, count))
+        return 0;
+    return (count + 1) / 2;
 }
 
 QString bytesToString(const QByteArray& bytes)
 {
-    QString str;
-    for (int i = 0; i < bytes.count(); ++i)
+    const int chunk = 256;
+    uint8_t ascii[chunk * 2];
+    const uint8_t *data = reinterpret_cast<const uint8_t*>(bytes.constData());
+    QString str(bytes.count() * 3, Qt::Uninitialized);
+    QChar *p = str.data();
+    for (int i = 0; i < bytes.count(); i += chunk)
     {
-        uint8_t num = *reinterpret_cast<const uint8_t*>(&bytes.constData()[i]);
-        QString  c = QString::number(num, 16).toUpper();
-        if (c.length() == 1)
-            c = "0" + c;
-        str += c + " ";
+        int c = qMin(chunk, bytes.count() - i);
+        hexEncode(data + i, ascii, static_cast<uint32_t>(c));
+        for (int j = 0; j < c; j++, p += 3)
+        {
+            p[0] = QLatin1Char(static_cast<char>(ascii[j * 2]));
+            p[1] = QLatin1Char(static_cast<char>(ascii[j * 2 + 1]));
+            p[2] = QLatin1Char(' ');
+        }
     }
     return str;
 }
@@ -113,25 +244,127 @@ QString bytesToString(const QByteArray& bytes)
 QString asciiToString(const QByteArray &bytes)
 {
     QString str;
+    str.reserve(bytes.count() * 2);
     int j = 0;
     for (int i = 0; i < bytes.count(); ++i)
     {
         QChar c = QChar(bytes.at(i));
         if (c == QChar::CarriageReturn)
-            str += ((str.right(1) == " ") ? "CR " : " CR ");
+            str += ((str.endsWith(QLatin1Char(' '))) ? QLatin1String("CR ") : QLatin1String(" CR "));
         else if (c == QChar::LineFeed)
-            str += ((str.right(1) == " ") ? "LF " : " LF ");
+            str += ((str.endsWith(QLatin1Char(' '))) ? QLatin1String("LF ") : QLatin1String(" LF "));
         else
         {
             str += c;
             j++;
             if (j & 1)
-                str += " ";
+                str += QLatin1Char(' ');
         }
     }
     return str;
 }
 
+static inline qint64 readMonotonicClock()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// cached monotonic time of the thread, negative value means that thread doesn't cache the time
+static thread_local qint64 s_monotonicTime = -1;
+
+qint64 monotonicTime()
+{
+    if (s_monotonicTime >= 0)
+        return s_monotonicTime;
+    return readMonotonicClock();
+}
+
+qint64 updateMonotonicTime()
+{
+    s_monotonicTime = readMonotonicClock();
+    return s_monotonicTime;
+}
+
+qint64 refreshMonotonicTime()
+{
+    qint64 t = readMonotonicClock();
+    if (s_monotonicTime >= 0)
+        s_monotonicTime = t;
+    return t;
+}
+
+uint32_t timeoutToUs(const QVariant &msec, bool *ok)
+{
+    bool okInner;
+    double v = msec.toDouble(&okInner);
+    if (ok)
+        *ok = okInner && (v >= 0);
+    if (!okInner || (v <= 0))
+        return 0;
+    v = v * 1000.0 + 0.5;
+    if (v >= static_cast<double>(std::numeric_limits<uint32_t>::max()))
+        return std::numeric_limits<uint32_t>::max();
+    return static_cast<uint32_t>(v);
+}
+
+uint32_t timeoutMsToUs(qint64 msec)
+{
+    if (msec <= 0)
+        return 0;
+    if (msec >= static_cast<qint64>(std::numeric_limits<uint32_t>::max() / 1000))
+        return std::numeric_limits<uint32_t>::max();
+    return static_cast<uint32_t>(msec * 1000);
+}
+
+QVariant timeoutFromUs(uint32_t usec)
+{
+    if (usec % 1000 == 0)
+        return QVariant(usec / 1000);
+    return QVariant(usec / 1000.0);
+}
+
+int histogramBucket(quint64 value)
+{
+    if (value < static_cast<quint64>(HistogramSubBucketCount))
+        return static_cast<int>(value);
+    int msb = 63;
+    while (!(value & (Q_UINT64_C(1) << msb)))
+        msb--;
+    int shift = msb - HistogramSubBucketBits;
+    return (shift + 1) * HistogramSubBucketCount + static_cast<int>((value >> shift) & (HistogramSubBucketCount - 1));
+}
+
+quint64 histogramBucketUpperBound(int bucket)
+{
+    if (bucket < HistogramSubBucketCount)
+        return static_cast<quint64>(bucket);
+    int shift = bucket / HistogramSubBucketCount - 1;
+    quint64 lower = static_cast<quint64>(HistogramSubBucketCount + bucket % HistogramSubBucketCount) << shift;
+    return lower + ((Q_UINT64_C(1) << shift) - 1);
+}
+
+quint64 histogramPercentile(const quint64 *counts, int bucketCount, quint64 total, double percentile)
+{
+    if (!total || (bucketCount <= 0))
+        return 0;
+    quint64 rank = static_cast<quint64>(std::ceil(percentile / 100.0 * total));
+    if (rank < 1)
+        rank = 1;
+    quint64 c = 0;
+    for (int i = 0; i < bucketCount; i++)
+    {
+        if (c + counts[i] >= rank)
+        {
+            // Note: buckets are adjacent, so the bucket starts right after the previous one
+            quint64 lower = i ? histogramBucketUpperBound(i - 1) + 1 : 0;
+            quint64 upper = histogramBucketUpperBound(i);
+            return lower + static_cast<quint64>(static_cast<double>(upper - lower) * (rank - c) / counts[i]);
+        }
+        c += counts[i];
+    }
+    return histogramBucketUpperBound(bucketCount - 1);
+}
+
 ClientPort *createClientPort(const Settings &settings, QObject *parent)
 {
     Port *p;
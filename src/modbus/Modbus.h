@@ -361,6 +361,45 @@ MODBUS_EXPORT QString bytesToString(const QByteArray& bytes);
 // make string representation of ASCII array and separate bytes by space
 MODBUS_EXPORT QString asciiToString(const QByteArray& bytes);
 
+// Monotonic time in nanoseconds for internal timing (timeouts, scheduling), it's not related to wall-clock.
+// Note: the value is cached per thread after the thread calls 'updateMonotonicTime()' (e.g. once per loop iteration)
+MODBUS_EXPORT qint64 monotonicTime();
+
+// Read monotonic clock, cache it for the current thread and return the value (nanoseconds)
+MODBUS_EXPORT qint64 updateMonotonicTime();
+
+// Read monotonic clock (nanoseconds) bypassing the cache, cached value is refreshed if the thread caches the time.
+// Must be used to measure time within blocking waits
+MODBUS_EXPORT qint64 refreshMonotonicTime();
+
+// Convert timeout setting value (milliseconds, fractional part is allowed) to microseconds
+MODBUS_EXPORT uint32_t timeoutToUs(const QVariant &msec, bool *ok = nullptr);
+
+// Convert timeout in whole milliseconds to microseconds, negative value is 0 and too large value is saturated
+MODBUS_EXPORT uint32_t timeoutMsToUs(qint64 msec);
+
+// Convert timeout in microseconds to setting value (milliseconds, integer if it's a whole number of milliseconds)
+MODBUS_EXPORT QVariant timeoutFromUs(uint32_t usec);
+
+// Log-linear (HDR style) histogram of 64-bit values: every power of two is divided into 'HistogramSubBucketCount'
+// buckets, so relative error of the value is less than 1/HistogramSubBucketCount (~3%)
+enum HistogramConstants
+{
+    HistogramSubBucketBits  = 5,
+    HistogramSubBucketCount = 1 << HistogramSubBucketBits,
+    HistogramBucketCount    = (65 - HistogramSubBucketBits) * HistogramSubBucketCount
+};
+
+// Index of the histogram bucket of the 'value'
+MODBUS_EXPORT int histogramBucket(quint64 value);
+
+// The largest value of the histogram 'bucket'
+MODBUS_EXPORT quint64 histogramBucketUpperBound(int bucket);
+
+// Value at 'percentile' (0..100) of histogram 'counts' of 'bucketCount' size, 'total' is the sum of the counts.
+// Value is interpolated linearly within the bucket by the rank of the percentile
+MODBUS_EXPORT quint64 histogramPercentile(const quint64 *counts, int bucketCount, quint64 total, double percentile);
+
 // 'ClientPort'-factory function
 MODBUS_EXPORT ClientPort *createClientPort(const Settings &settings, QObject *parent = nullptr);
 
@@ -76,6 +76,16 @@ bool Client::isOpen() const
     return m_port->isOpen();
 }
 
+uint32_t Client::timeout() const
+{
+    return m_port->requestTimeout(m_rp);
+}
+
+void Client::setTimeout(uint32_t timeout)
+{
+    m_port->setRequestTimeout(m_rp, timeout);
+}
+
 Modbus::Settings Client::settings() const
 {
     Settings params;
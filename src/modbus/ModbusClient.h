@@ -62,6 +62,9 @@ public:
     Settings settings() const;
     bool setSettings(const Settings& settings);
     inline ClientPort *port() const { return m_port; }
+    // response timeout (microseconds) of the requests of the client, 0 - timeout of the port is used
+    uint32_t timeout() const;
+    void setTimeout(uint32_t timeout);
 
 public:
     inline StatusCode readCoils(uint16_t offset, uint16_t count, void *values) { return readCoils(m_unit, offset, count, values); }
@@ -22,20 +22,47 @@
 */
 #include "ModbusClientPort.h"
 
+#include <algorithm>
+
 #include <QDateTime>
 
 #include "ModbusPort.h"
+#include "ModbusPortTCP.h"
 
 namespace Modbus {
 
 struct ClientPort::RequestParams
 {
+    enum State
+    {
+        STATE_IDLE,
+        STATE_BEGIN,    // request is enabled by 'getRequestStatus()'
+        STATE_WAIT,     // request was sent, waiting for the response
+        STATE_REPEAT,   // response timeout elapsed, request must be sent again
+        STATE_COMPLETE  // response was received or an error occured
+    };
+
     void *object;
     QString name;
+    // Note: next members are used in pipelined mode only
+    State state;
+    uint16_t transaction;
+    uint8_t unit;
+    uint8_t func;
+    uint32_t repeats;
+    uint32_t timeout; // response timeout, microseconds (0 - timeout of the port)
+    qint64 timestamp; // monotonic time the request was sent at, nanoseconds
+    qint64 start; // nanoseconds of 'ClientPort::m_timer' when request was sent first time
+    StatusCode status;
+    QString errorText;
+    uint16_t szIn; // size of request data within 'buff'
+    uint16_t sz;   // size of response data within 'buff'
+    uint8_t buff[MB_TCP_IO_BUFF_SZ];
 };
 
 ClientPort::Strings::Strings() :
-    repeatCount(QStringLiteral("repeatCount"))
+    repeatCount(QStringLiteral("repeatCount")),
+    pipelineWindow(QStringLiteral("pipelineWindow"))
 {
 }
 
@@ -46,7 +73,8 @@ const ClientPort::Strings& ClientPort::Strings::instance()
 }
 
 ClientPort::Defaults::Defaults() :
-    repeatCount(1)
+    repeatCount(1),
+    pipelineWindow(1)
 {
 }
 
@@ -66,7 +94,15 @@ ClientPort::ClientPort(Port *port, QObject *parent) :
     port->setServerMode(false);
     m_repeats = 0;
     m_settings.repeatCount = Defaults::instance().repeatCount;
+    m_settings.pipelineWindow = Defaults::instance().pipelineWindow;
     m_lastStatusTimestamp = 0;
+    m_timer.start();
+    m_requestStart = -1;
+    m_lastLatency = 0;
+    m_lastRepeatCount = 0;
+    m_transaction = 0;
+    m_pipelineCount = 0;
+    m_lastFrameTimestamp = 0;
 
     connect(m_port, &Port::signalTx     , this, &ClientPort::slotTx     );
     connect(m_port, &Port::signalRx     , this, &ClientPort::slotRx     );
@@ -90,7 +126,9 @@ StatusCode ClientPort::close()
     {
         s = m_port->close();
         m_currentRequestParams = nullptr;
+        m_requestStart = -1;
     }
+    abortPipeline(Status_BadTcpDisconnect, QStringLiteral("TCP. Connection was closed"));
     return s;
 }
 
@@ -99,6 +137,18 @@ bool ClientPort::isOpen() const
     return m_port->isOpen();
 }
 
+bool ClientPort::isPipelined() const
+{
+    return (m_settings.pipelineWindow > 1) && (m_port->type() == TCP);
+}
+
+QString ClientPort::lastErrorText() const
+{
+    if (isPipelined())
+        return m_lastErrorText;
+    return m_port->lastErrorText();
+}
+
 Settings ClientPort::settings() const
 {
     return m_port->settings();
@@ -118,11 +168,33 @@ bool ClientPort::setSettings(const Settings &settings)
         setRepeatCount(v.toUInt());
     }
 
+    it = settings.find(s.pipelineWindow);
+    if (it != end)
+    {
+        QVariant v = it.value();
+        setPipelineWindow(v.toUInt());
+    }
+
     return m_port->setSettings(settings);
 }
 
 StatusCode ClientPort::request(uint8_t unit, uint8_t func, uint8_t *buff, uint16_t szInBuff, uint16_t maxSzBuff, uint16_t *szOutBuff)
 {
+    if (isPipelined())
+    {
+        RequestParams *rp = m_currentRequestParams;
+        // Note: in pipelined mode current request params is valid only within single call
+        m_currentRequestParams = nullptr;
+        if (!rp)
+        {
+            m_lastErrorText = QStringLiteral("Pipelined request must be enabled by 'getRequestStatus()'");
+            return Status_BadNotCorrectRequest;
+        }
+        return requestPipelined(rp, unit, func, buff, szInBuff, maxSzBuff, szOutBuff);
+    }
+    if (m_requestStart < 0)
+        m_requestStart = m_timer.nsecsElapsed();
+    m_port->setResponseTimeout(m_currentRequestParams ? m_currentRequestParams->timeout : 0);
     m_port->writeBuffer(unit, func, buff, szInBuff);
     StatusCode r = process();
     if (StatusIsProcessing(r))
@@ -137,6 +209,8 @@ StatusCode ClientPort::request(uint8_t unit, uint8_t func, uint8_t *buff, uint16
             return Status_Processing;
         }
     }
+    setLastRequest(m_requestStart, m_repeats);
+    m_requestStart = -1;
     m_repeats = 0;
     m_currentRequestParams = nullptr;
     if (StatusIsBad(r))
@@ -244,6 +318,17 @@ ClientPort::RequestParams *ClientPort::createRequestParams(void *obj, const QStr
     RequestParams *rp = new RequestParams;
     rp->object = obj;
     rp->name = name;
+    rp->state = RequestParams::STATE_IDLE;
+    rp->transaction = 0;
+    rp->unit = 0;
+    rp->func = 0;
+    rp->repeats = 0;
+    rp->timeout = 0;
+    rp->timestamp = 0;
+    rp->start = 0;
+    rp->status = Status_Uncertain;
+    rp->szIn = 0;
+    rp->sz = 0;
     return rp;
 }
 
@@ -254,11 +339,33 @@ void ClientPort::renameRequestParams(RequestParams *rp, const QString &name)
 
 void ClientPort::deleteRequestParams(RequestParams *rp)
 {
+    if (rp->state != RequestParams::STATE_IDLE)
+    {
+        if (rp->state == RequestParams::STATE_WAIT)
+            m_transactions.removeOne(rp);
+        m_pipelineCount--;
+    }
+    if (m_currentRequestParams == rp)
+        m_currentRequestParams = nullptr;
     delete rp;
 }
 
 ClientPort::RequestStatus ClientPort::getRequestStatus(RequestParams *rp)
 {
+    if (isPipelined())
+    {
+        if (rp->state == RequestParams::STATE_IDLE)
+        {
+            if (m_pipelineCount >= static_cast<int>(m_settings.pipelineWindow))
+                return Disable;
+            rp->state = RequestParams::STATE_BEGIN;
+            m_pipelineCount++;
+            m_currentRequestParams = rp;
+            return Enable;
+        }
+        m_currentRequestParams = rp;
+        return Process;
+    }
     if (m_currentRequestParams)
     {
         if (m_currentRequestParams == rp)
@@ -274,8 +381,26 @@ ClientPort::RequestStatus ClientPort::getRequestStatus(RequestParams *rp)
 
 void ClientPort::cancelRequest(RequestParams* rp)
 {
+    if (rp->state == RequestParams::STATE_BEGIN) // pipelined request is not sent yet
+    {
+        rp->state = RequestParams::STATE_IDLE;
+        m_pipelineCount--;
+    }
     if (m_currentRequestParams == rp)
+    {
         m_currentRequestParams = nullptr;
+        m_requestStart = -1;
+    }
+}
+
+uint32_t ClientPort::requestTimeout(const RequestParams *rp) const
+{
+    return rp->timeout;
+}
+
+void ClientPort::setRequestTimeout(RequestParams *rp, uint32_t timeout)
+{
+    rp->timeout = timeout;
 }
 
 void ClientPort::slotTx(const QByteArray &bytes)
@@ -310,4 +435,192 @@ void ClientPort::setStatus(StatusCode s)
     m_lastStatusTimestamp = QDateTime::currentMSecsSinceEpoch();
 }
 
+void ClientPort::setLastRequest(qint64 start, uint32_t repeats)
+{
+    qint64 us = (m_timer.nsecsElapsed() - start) / 1000;
+    m_lastLatency = (us > UINT32_MAX) ? UINT32_MAX : static_cast<uint32_t>(us);
+    // Note: failed request increments repeats counter even if there is no repeat left
+    m_lastRepeatCount = (repeats < m_settings.repeatCount) ? repeats : m_settings.repeatCount - 1;
+}
+
+StatusCode ClientPort::requestPipelined(RequestParams *rp, uint8_t unit, uint8_t func, uint8_t *buff, uint16_t szInBuff, uint16_t maxSzBuff, uint16_t *szOutBuff)
+{
+    StatusCode r;
+    switch (rp->state)
+    {
+    case RequestParams::STATE_BEGIN:
+        if (szInBuff > sizeof(rp->buff))
+        {
+            completePipelined(rp, Status_BadWriteBufferOverflow, QStringLiteral("TCP. Write-buffer overflow"));
+            break;
+        }
+        rp->unit = unit;
+        rp->func = func;
+        rp->repeats = 0;
+        rp->start = m_timer.nsecsElapsed();
+        memcpy(rp->buff, buff, szInBuff);
+        rp->szIn = szInBuff;
+        // no need break
+    case RequestParams::STATE_REPEAT:
+        r = sendPipelined(rp);
+        if (StatusIsProcessing(r))
+            return r;
+        break;
+    case RequestParams::STATE_WAIT:
+        processPipeline();
+        break;
+    default:
+        break;
+    }
+    if (rp->state != RequestParams::STATE_COMPLETE)
+        return Status_Processing;
+    rp->state = RequestParams::STATE_IDLE;
+    m_pipelineCount--;
+    setLastRequest(rp->start, rp->repeats);
+    r = rp->status;
+    if (StatusIsBad(r))
+    {
+        m_lastErrorText = rp->errorText;
+        m_currentRequestParams = rp;
+        setError(r, rp->errorText);
+        m_currentRequestParams = nullptr;
+        return r;
+    }
+    *szOutBuff = (rp->sz > maxSzBuff) ? maxSzBuff : rp->sz;
+    memcpy(buff, rp->buff, *szOutBuff);
+    setStatus(r);
+    return r;
+}
+
+StatusCode ClientPort::sendPipelined(RequestParams *rp)
+{
+    PortTCP *tcp = static_cast<PortTCP*>(m_port);
+    if (m_port->isChanged()) // settings was changed so connection must be reestablished
+    {
+        abortPipeline(Status_BadTcpDisconnect, QStringLiteral("TCP. Connection settings was changed"));
+        m_port->close();
+    }
+    StatusCode r = m_port->open();
+    if (StatusIsProcessing(r))
+        return r;
+    if (StatusIsBad(r))
+    {
+        completePipelined(rp, r, m_port->lastErrorText());
+        return r;
+    }
+    do
+        m_transaction++;
+    while (std::any_of(m_transactions.cbegin(), m_transactions.cend(), [this](const RequestParams *t) { return t->transaction == m_transaction; }));
+    rp->transaction = m_transaction;
+    m_currentRequestParams = rp;
+    r = tcp->writeTransaction(rp->transaction, rp->unit, rp->func, rp->buff, rp->szIn);
+    m_currentRequestParams = nullptr;
+    if (StatusIsBad(r))
+    {
+        completePipelined(rp, r, m_port->lastErrorText());
+        return r;
+    }
+    rp->timestamp = monotonicTime();
+    rp->state = RequestParams::STATE_WAIT;
+    m_transactions.append(rp);
+    return Status_Processing;
+}
+
+void ClientPort::processPipeline()
+{
+    PortTCP *tcp = static_cast<PortTCP*>(m_port);
+    uint8_t buff[MB_TCP_IO_BUFF_SZ];
+    uint16_t transaction, sz;
+    StatusCode r;
+
+    if (!m_port->isOpen())
+    {
+        abortPipeline(Status_BadTcpDisconnect, QStringLiteral("TCP. Connection was closed"));
+        return;
+    }
+    // read all available responses and dispatch it to requests by transaction id
+    while (m_transactions.count())
+    {
+        r = tcp->readTransaction(&transaction);
+        if (StatusIsProcessing(r))
+            break;
+        if (StatusIsBad(r)) // frame sequence is broken so connection must be reestablished
+        {
+            abortPipeline(r, m_port->lastErrorText());
+            m_port->close();
+            return;
+        }
+        m_lastFrameTimestamp = monotonicTime();
+        RequestParams *rp = takeTransaction(transaction);
+        if (!rp) // response for the request which timeout is already elapsed
+            continue;
+        m_currentRequestParams = rp;
+        r = tcp->readTransactionBuffer(rp->unit, rp->func, buff, sizeof(buff), &sz);
+        m_currentRequestParams = nullptr;
+        if (StatusIsBad(r))
+        {
+            completePipelined(rp, r, m_port->lastErrorText());
+            continue;
+        }
+        memcpy(rp->buff, buff, sz);
+        rp->sz = sz;
+        completePipelined(rp, r, QString());
+    }
+    // check up timeouts of requests waiting for the response
+    qint64 timestamp = monotonicTime();
+    // Note: when every request in flight is timed out and nothing was received since the oldest one
+    // was sent, connection is considered as half-open, so it's closed and reestablished by next send
+    bool stale = m_transactions.count() && (m_lastFrameTimestamp < m_transactions.first()->timestamp);
+    for (Transactions_t::iterator it = m_transactions.begin(); it != m_transactions.end(); )
+    {
+        RequestParams *rp = *it;
+        uint32_t timeout = (rp->timeout && (rp->timeout < tcp->timeoutUs())) ? rp->timeout : tcp->timeoutUs();
+        if (timestamp - rp->timestamp >= timeout * 1000LL)
+        {
+            it = m_transactions.erase(it);
+            rp->repeats++;
+            if (rp->repeats < m_settings.repeatCount)
+                rp->state = RequestParams::STATE_REPEAT;
+            else
+                completePipelined(rp, Status_BadTcpRead, QStringLiteral("TCP. Error while reading - timeout"));
+            continue;
+        }
+        stale = false;
+        ++it;
+    }
+    if (stale)
+    {
+        abortPipeline(Status_BadTcpRead, QStringLiteral("TCP. Error while reading - timeout"));
+        m_port->close();
+    }
+}
+
+ClientPort::RequestParams *ClientPort::takeTransaction(uint16_t transaction)
+{
+    for (int i = 0; i < m_transactions.count(); i++)
+    {
+        RequestParams *rp = m_transactions.at(i);
+        if (rp->transaction == transaction)
+        {
+            m_transactions.remove(i);
+            return rp;
+        }
+    }
+    return nullptr;
+}
+
+void ClientPort::completePipelined(RequestParams *rp, StatusCode status, const QString &errorText)
+{
+    rp->status = status;
+    rp->errorText = errorText;
+    rp->state = RequestParams::STATE_COMPLETE;
+}
+
+void ClientPort::abortPipeline(StatusCode status, const QString &errorText)
+{
+    Q_FOREACH (RequestParams *rp, m_transactions)
+        completePipelined(rp, status, errorText);
+    m_transactions.clear();
+}
+
 } // namespace Modbus 
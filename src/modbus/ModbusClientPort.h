@@ -23,6 +23,9 @@
 #ifndef MODBUSCLIENTPORT_H
 #define MODBUSCLIENTPORT_H
 
+#include <QVector>
+#include <QElapsedTimer>
+
 #include "ModbusPort.h"
 
 namespace Modbus {
@@ -37,6 +40,7 @@ public:
     struct MODBUS_EXPORT Strings
     {
         const QString repeatCount;
+        const QString pipelineWindow;
 
         Strings();
         static const Strings& instance();
@@ -45,6 +49,7 @@ public:
     struct MODBUS_EXPORT Defaults
     {
         const uint32_t repeatCount;
+        const uint32_t pipelineWindow;
 
         Defaults();
         static const Defaults& instance();
@@ -83,20 +88,31 @@ public:
     bool isOpen() const;
     uint32_t repeatCount() const { return m_settings.repeatCount; }
     void setRepeatCount(uint32_t v) { if (v > 0) m_settings.repeatCount = v; }
+    // maximum count of requests that can be sent without waiting for the response (TCP only)
+    uint32_t pipelineWindow() const { return m_settings.pipelineWindow; }
+    void setPipelineWindow(uint32_t v) { if (v > 0) m_settings.pipelineWindow = v; }
+    bool isPipelined() const;
     Settings settings() const;
     bool setSettings(const Settings& settings);
 
 public:
     inline Port *port() const { return m_port; }
+    inline bool isTraceEnabled() const { return m_port->isTraceEnabled(); }
+    inline void setTraceEnabled(bool enable) { m_port->setTraceEnabled(enable); }
 
 public:
     inline StatusCode lastStatus() const { return m_lastStatus; }
     inline qint64 lastStatusTimestamp() const { return m_lastStatusTimestamp; }
-    inline QString lastErrorText() const { return m_port->lastErrorText(); }
+    QString lastErrorText() const;
+    // time (microseconds) from the first write of the last completed request to its completion
+    inline uint32_t lastLatency() const { return m_lastLatency; }
+    // count of repeats made by the last completed request
+    inline uint32_t lastRepeatCount() const { return m_lastRepeatCount; }
 
 public:
     StatusCode request(uint8_t unit, uint8_t func, uint8_t *buff, uint16_t szInBuff, uint16_t maxSzBuff, uint16_t *szOutBuff);
     StatusCode process();
+    inline int pipelineCount() const { return m_pipelineCount; }
 
 public:
     struct RequestParams;
@@ -106,6 +122,9 @@ public:
     void deleteRequestParams(RequestParams *rp);
     RequestStatus getRequestStatus(RequestParams *rp);
     void cancelRequest(RequestParams* rp);
+    // response timeout (microseconds) of the requests, it can only shorten the timeout of the port, 0 - timeout of the port
+    uint32_t requestTimeout(const RequestParams *rp) const;
+    void setRequestTimeout(RequestParams *rp, uint32_t timeout);
 
 Q_SIGNALS:
     void signalTx(const QString& source, const QByteArray& bytes);
@@ -122,6 +141,17 @@ protected Q_SLOTS:
 protected:
     void setStatus(StatusCode s);
 
+private:
+    void setLastRequest(qint64 start, uint32_t repeats);
+
+private:
+    StatusCode requestPipelined(RequestParams *rp, uint8_t unit, uint8_t func, uint8_t *buff, uint16_t szInBuff, uint16_t maxSzBuff, uint16_t *szOutBuff);
+    StatusCode sendPipelined(RequestParams *rp);
+    void processPipeline();
+    RequestParams *takeTransaction(uint16_t transaction);
+    void completePipelined(RequestParams *rp, StatusCode status, const QString &errorText);
+    void abortPipeline(StatusCode status, const QString &errorText);
+
 protected:
     Port *m_port;
     State m_state;
@@ -129,12 +159,26 @@ protected:
     uint32_t m_repeats;
     StatusCode m_lastStatus;
     qint64 m_lastStatusTimestamp;
+    QString m_lastErrorText;
+    QElapsedTimer m_timer;
+    qint64 m_requestStart; // nanoseconds of 'm_timer', -1 if there is no request in progress
+    uint32_t m_lastLatency;
+    uint32_t m_lastRepeatCount;
 
     struct
     {
         uint32_t repeatCount;
+        uint32_t pipelineWindow;
     } m_settings;
 
+private: // pipelined mode
+    // Note: vector keeps its capacity, so requests in flight are tracked without heap allocations
+    typedef QVector<RequestParams*> Transactions_t;
+    Transactions_t m_transactions;
+    uint16_t m_transaction;
+    int m_pipelineCount;
+    qint64 m_lastFrameTimestamp; // monotonic time of the last received response
+
 };
 
 } // namespace Modbus
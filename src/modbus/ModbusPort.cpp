@@ -54,6 +54,9 @@ Port::Port(QObject *parent) : QObject(parent)
     m_func = 0;
     m_block = false;
     m_modeServer = false;
+    m_trace = true;
+    m_responseTimeout = 0;
+    m_discarded = 0;
     clearChanged();
 }
 
@@ -75,9 +78,22 @@ void Port::setNextRequestRepeated(bool /* v */)
 {
 }
 
+bool Port::hasPendingFrame() const
+{
+    return false;
+}
+
 void Port::setServerMode(bool mode)
 {
     m_modeServer = mode;
 }
 
+const QByteArray &Port::traceBytes(const uint8_t *bytes, uint16_t size)
+{
+    // Note: buffer is reallocated only if it's grown or previous frame is still referenced by receiver
+    m_traceBuff.resize(size);
+    memcpy(m_traceBuff.data(), bytes, size);
+    return m_traceBuff;
+}
+
 } // namespace Modbus
@@ -96,6 +96,23 @@ public:
     virtual StatusCode readBuffer(uint8_t &unit, uint8_t &func, uint8_t *buff, uint16_t maxSzBuff, uint16_t *szOutBuff) = 0;
     virtual StatusCode write() = 0;
     virtual StatusCode read() = 0;
+    // next frame is already received so 'read()' can return it without waiting
+    virtual bool hasPendingFrame() const;
+
+public:
+    // timeout (microseconds) of waiting for the response of the current request (client mode),
+    // it can only shorten the timeout of the port, 0 - timeout of the port is used
+    inline uint32_t responseTimeout() const { return m_responseTimeout; }
+    inline void setResponseTimeout(uint32_t timeout) { m_responseTimeout = timeout; }
+
+public:
+    // 'signalTx'/'signalRx' are emitted only when trace is enabled (enabled by default)
+    inline bool isTraceEnabled() const { return m_trace; }
+    inline void setTraceEnabled(bool enable) { m_trace = enable; }
+
+public:
+    // bytes discarded while valid frames were resynchronized (noise, late responses of other devices)
+    inline uint64_t discardedBytes() const { return m_discarded; }
 
 Q_SIGNALS:
     void signalTx(const QByteArray& bytes);
@@ -107,7 +124,13 @@ protected:
     inline void setChanged(bool changed = true) { m_changed = changed; }
     inline void clearChanged() { setChanged(false); }
     inline StatusCode setError(StatusCode status, const QString &text) { m_lastErrorText = text; return status; }
+    inline uint32_t effectiveResponseTimeout(uint32_t portTimeout) const { return (m_responseTimeout && (m_responseTimeout < portTimeout)) ? m_responseTimeout : portTimeout; }
     inline void setMessage(const QString &text) { Q_EMIT signalMessage(text); }
+    inline void emitTx(const uint8_t *bytes, uint16_t size) { if (m_trace) Q_EMIT signalTx(traceBytes(bytes, size)); }
+    inline void emitRx(const uint8_t *bytes, uint16_t size) { if (m_trace) Q_EMIT signalRx(traceBytes(bytes, size)); }
+
+private:
+    const QByteArray &traceBytes(const uint8_t *bytes, uint16_t size);
 
 protected:
     State m_state;
@@ -117,6 +140,12 @@ protected:
     bool m_block;
     bool m_modeServer;
     bool m_changed;
+    bool m_trace;
+    uint32_t m_responseTimeout;
+    uint64_t m_discarded;
+
+private:
+    QByteArray m_traceBuff; // reused for every traced frame, receiver must copy bytes it keeps
 };
 
 } // namespace Modbus
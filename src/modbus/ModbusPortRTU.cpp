@@ -22,18 +22,52 @@
 */
 #include "ModbusPortRTU.h"
 
+#include <QVariant>
+
 namespace Modbus {
 
+PortRTU::Strings::Strings() : PortSerial::Strings(),
+    preciseFraming(QStringLiteral("preciseFraming")),
+    earlyFrameEnd(QStringLiteral("earlyFrameEnd"))
+{
+}
+
+const PortRTU::Strings &PortRTU::Strings::instance()
+{
+    static const Strings s;
+    return s;
+}
+
+PortRTU::Defaults::Defaults() : PortSerial::Defaults(),
+    preciseFraming(false),
+    earlyFrameEnd(false)
+{
+}
+
+const PortRTU::Defaults &PortRTU::Defaults::instance()
+{
+    static const Defaults d;
+    return d;
+}
+
 PortRTU::PortRTU(QSerialPort *serialPort, QObject *parent) : PortSerial(serialPort, parent)
 {
+    const Defaults &d = Defaults::instance();
+
     c_buffSz = MB_RTU_IO_BUFF_SZ;
     m_buff = new quint8[c_buffSz];
+    m_preciseFraming = d.preciseFraming;
+    m_earlyFrameEnd = d.earlyFrameEnd;
 }
 
 PortRTU::PortRTU(QObject *parent) : PortSerial(parent)
 {
+    const Defaults &d = Defaults::instance();
+
     c_buffSz = MB_RTU_IO_BUFF_SZ;
     m_buff = new quint8[c_buffSz];
+    m_preciseFraming = d.preciseFraming;
+    m_earlyFrameEnd = d.earlyFrameEnd;
 }
 
 PortRTU::~PortRTU()
@@ -72,6 +106,17 @@ StatusCode PortRTU::readBuffer(quint8& slave, quint8& func, quint8 *buff, quint1
     if (m_sz < 5)
         return setError(Status_BadNotCorrectRequest, QStringLiteral("Not correct response. Responsed data length to small"));
 
+    // Note: bytes around the valid frame are discarded, otherwise whole buffer is checked up as one frame
+    uint16_t szFrame;
+    int i = findFrame(&szFrame);
+    if ((i >= 0) && (szFrame != m_sz))
+    {
+        m_discarded += m_sz - szFrame;
+        setMessage(QString("Frame resynchronized, %1 byte(s) discarded").arg(m_sz - szFrame));
+        memmove(m_buff, &m_buff[i], szFrame);
+        m_sz = szFrame;
+    }
+
     crc = m_buff[m_sz-2] | (m_buff[m_sz-1] << 8);
     if (Modbus::crc16(m_buff, m_sz-2) != crc)
         return setError(Status_BadCrc, QStringLiteral("Wrong CRC"));
@@ -101,4 +146,175 @@ StatusCode PortRTU::readBuffer(quint8& slave, quint8& func, quint8 *buff, quint1
     return Status_Good;
 }
 
+uint32_t PortRTU::t15() const
+{
+    return charTimes(3);
+}
+
+uint32_t PortRTU::t35() const
+{
+    return charTimes(7);
+}
+
+Settings PortRTU::settings() const
+{
+    Settings params = PortSerial::settings();
+    const Strings &s = Strings::instance();
+    params.insert(s.preciseFraming, isPreciseFraming());
+    params.insert(s.earlyFrameEnd, isEarlyFrameEnd());
+    return params;
+}
+
+bool PortRTU::setSettings(const Settings &settings)
+{
+    PortSerial::setSettings(settings);
+
+    const Strings &s = Strings::instance();
+
+    Settings::const_iterator it;
+    Settings::const_iterator end = settings.end();
+
+    it = settings.find(s.preciseFraming);
+    if (it != end)
+    {
+        QVariant v = it.value();
+        setPreciseFraming(v.toBool());
+    }
+
+    it = settings.find(s.earlyFrameEnd);
+    if (it != end)
+    {
+        QVariant v = it.value();
+        setEarlyFrameEnd(v.toBool());
+    }
+
+    return true;
+}
+
+uint32_t PortRTU::frameGapUs() const
+{
+    if (m_preciseFraming)
+        return t35();
+    return PortSerial::frameGapUs();
+}
+
+bool PortRTU::isFrameComplete() const
+{
+    if (!m_earlyFrameEnd)
+        return false;
+    uint16_t szFrame;
+    return findFrame(&szFrame) >= 0;
+}
+
+bool PortRTU::isPreciseTiming() const
+{
+    return m_preciseFraming;
+}
+
+uint32_t PortRTU::charTimes(uint32_t halfChars) const
+{
+    qint32 baud = baudRate();
+    if (baud <= 0)
+        return PortSerial::frameGapUs();
+    // Note: Modbus over serial line specification recommends fixed t1.5 = 750 us and t3.5 = 1750 us above 19200 bps
+    if (baud > 19200)
+        return halfChars * 250;
+    uint32_t bits = 1; // start bit
+    bits += (dataBits() >= QSerialPort::Data5) ? static_cast<uint32_t>(dataBits()) : 8;
+    if (parity() != QSerialPort::NoParity)
+        bits++;
+    bits += (stopBits() == QSerialPort::OneStop) ? 1 : 2; // 1.5 stop bits are rounded up
+    return (bits * halfChars * 500000 + static_cast<uint32_t>(baud) - 1) / static_cast<uint32_t>(baud);
+}
+
+int PortRTU::findFrame(uint16_t *szFrame) const
+{
+    // scan received bytes for the first frame with known size and valid CRC,
+    // in client mode the frame must also have unit and function of the request
+    for (uint16_t i = 0; i + 4 <= m_sz; i++)
+    {
+        const uint8_t *frame = &m_buff[i];
+        uint16_t c = static_cast<uint16_t>(m_sz - i);
+        if (!m_modeServer && ((frame[0] != m_unit) || ((frame[1] & ~MBF_EXCEPTION) != m_func)))
+            continue;
+        uint16_t sz = expectedFrameSize(frame, c);
+        if (!sz || (sz > c))
+            continue;
+        uint16_t crc = frame[sz-2] | (frame[sz-1] << 8);
+        if (Modbus::crc16(frame, sz-2) == crc)
+        {
+            *szFrame = sz;
+            return i;
+        }
+    }
+    return -1;
+}
+
+uint16_t PortRTU::expectedFrameSize(const uint8_t *frame, uint16_t sz) const
+{
+    // Note: sizes include unit, function and CRC, 0 means size is unknown (yet)
+    if (sz < 2)
+        return 0;
+    uint8_t func = frame[1];
+    if (!m_modeServer) // response
+    {
+        if (func & MBF_EXCEPTION)
+            return 5;
+        switch (func)
+        {
+        case MBF_READ_EXCEPTION_STATUS:
+            return 5;
+        case MBF_WRITE_SINGLE_COIL:
+        case MBF_WRITE_SINGLE_REGISTER:
+        case MBF_DIAGNOSTICS:
+        case MBF_GET_COMM_EVENT_COUNTER:
+        case MBF_WRITE_MULTIPLE_COILS:
+        case MBF_WRITE_MULTIPLE_REGISTERS:
+            return 8;
+        case MBF_MASK_WRITE_REGISTER:
+            return 10;
+        case MBF_READ_COILS:
+        case MBF_READ_DISCRETE_INPUTS:
+        case MBF_READ_HOLDING_REGISTERS:
+        case MBF_READ_INPUT_REGISTERS:
+        case MBF_GET_COMM_EVENT_LOG:
+        case MBF_REPORT_SERVER_ID:
+        case MBF_READ_FILE_RECORD:
+        case MBF_WRITE_FILE_RECORD:
+        case MBF_READ_WRITE_MULTIPLE_REGISTERS:
+            return (sz > 2) ? 5 + frame[2] : 0;
+        default:
+            return 0;
+        }
+    }
+    switch (func) // request
+    {
+    case MBF_READ_EXCEPTION_STATUS:
+    case MBF_GET_COMM_EVENT_COUNTER:
+    case MBF_GET_COMM_EVENT_LOG:
+    case MBF_REPORT_SERVER_ID:
+        return 4;
+    case MBF_READ_COILS:
+    case MBF_READ_DISCRETE_INPUTS:
+    case MBF_READ_HOLDING_REGISTERS:
+    case MBF_READ_INPUT_REGISTERS:
+    case MBF_WRITE_SINGLE_COIL:
+    case MBF_WRITE_SINGLE_REGISTER:
+    case MBF_DIAGNOSTICS:
+        return 8;
+    case MBF_MASK_WRITE_REGISTER:
+        return 10;
+    case MBF_READ_FILE_RECORD:
+    case MBF_WRITE_FILE_RECORD:
+        return (sz > 2) ? 5 + frame[2] : 0;
+    case MBF_WRITE_MULTIPLE_COILS:
+    case MBF_WRITE_MULTIPLE_REGISTERS:
+        return (sz > 6) ? 9 + frame[6] : 0;
+    case MBF_READ_WRITE_MULTIPLE_REGISTERS:
+        return (sz > 10) ? 13 + frame[10] : 0;
+    default:
+        return 0;
+    }
+}
+
 } // namespace Modbus
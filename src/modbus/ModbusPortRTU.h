@@ -29,6 +29,25 @@ namespace Modbus {
 
 class MODBUS_EXPORT PortRTU : public PortSerial
 {
+public:
+    struct MODBUS_EXPORT Strings : public PortSerial::Strings
+    {
+        const QString preciseFraming;
+        const QString earlyFrameEnd;
+
+        Strings();
+        static const Strings &instance();
+    };
+
+    struct MODBUS_EXPORT Defaults : public PortSerial::Defaults
+    {
+        const bool preciseFraming;
+        const bool earlyFrameEnd;
+
+        Defaults();
+        static const Defaults &instance();
+    };
+
 public:
     PortRTU(QSerialPort *serialPort, QObject *parent = nullptr);
     PortRTU(QObject* parent = nullptr);
@@ -37,9 +56,35 @@ public:
 public:
     Type type() const override { return RTU; }
 
+public: // settings
+    // frame ends after t3.5 silence derived from the baud rate instead of 'timeoutInterByte'
+    inline bool isPreciseFraming() const { return m_preciseFraming; }
+    inline void setPreciseFraming(bool enable) { m_preciseFraming = enable; }
+    // frame ends as soon as expected size for the function is received with valid CRC
+    inline bool isEarlyFrameEnd() const { return m_earlyFrameEnd; }
+    inline void setEarlyFrameEnd(bool enable) { m_earlyFrameEnd = enable; }
+    // character times t1.5 and t3.5 (microseconds) for current serial port settings
+    uint32_t t15() const;
+    uint32_t t35() const;
+    // settings
+    Settings settings() const override;
+    bool setSettings(const Settings& settings) override;
+
 protected:
     StatusCode writeBuffer(uint8_t slave, uint8_t func, uint8_t *buff, uint16_t szInBuff) override;
     StatusCode readBuffer(uint8_t &slave, uint8_t &func, uint8_t *buff, uint16_t maxSzBuff, uint16_t *szOutBuff) override;
+    uint32_t frameGapUs() const override;
+    bool isFrameComplete() const override;
+    bool isPreciseTiming() const override;
+
+private:
+    uint32_t charTimes(uint32_t halfChars) const;
+    uint16_t expectedFrameSize(const uint8_t *frame, uint16_t sz) const;
+    int findFrame(uint16_t *szFrame) const;
+
+private:
+    bool m_preciseFraming;
+    bool m_earlyFrameEnd;
 };
 
 } // namespace Modbus
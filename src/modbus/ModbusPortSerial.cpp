@@ -23,7 +23,10 @@
 #include "ModbusPortSerial.h"
 
 #include <QVariant>
-#include <QDateTime>
+
+#ifdef Q_OS_UNIX
+#include <sys/select.h>
+#endif
 
 namespace Modbus {
 
@@ -111,7 +114,7 @@ StatusCode PortSerial::open()
                 m_state = STATE_BEGIN;
                 return Status_Good;
             }
-            m_timestamp = QDateTime::currentMSecsSinceEpoch();
+            m_timestamp = monotonicTime();
             m_state = STATE_WAIT_FOR_OPEN;
         }
             // no need break
@@ -122,7 +125,7 @@ StatusCode PortSerial::open()
                 m_state = STATE_BEGIN;
                 return Status_Good;
             }
-            else if (QDateTime::currentMSecsSinceEpoch() - m_timestamp >= m_timeoutFB)
+            else if (monotonicTime() - m_timestamp >= m_timeoutFB * 1000LL)
             {
                 //m_serialPort->close();
                 m_state = STATE_CLOSED;
@@ -167,8 +170,8 @@ Settings PortSerial::settings() const
     params.insert(s.parity, Modbus::enumKey<QSerialPort::Parity>(parity()));
     params.insert(s.stopBits, Modbus::enumKey<QSerialPort::StopBits>(stopBits()));
     params.insert(s.flowControl, Modbus::enumKey<QSerialPort::FlowControl>(flowControl()));
-    params.insert(s.timeoutFirstByte, timeoutFirstByte());
-    params.insert(s.timeoutInterByte, timeoutInterByte());
+    params.insert(s.timeoutFirstByte, timeoutFromUs(timeoutFirstByteUs()));
+    params.insert(s.timeoutInterByte, timeoutFromUs(timeoutInterByteUs()));
     return params;
 }
 
@@ -234,14 +237,14 @@ bool PortSerial::setSettings(const Settings &settings)
     if (it != end)
     {
         QVariant v = it.value();
-        setTimeoutFirstByte(v.toUInt());
+        setTimeoutFirstByteUs(timeoutToUs(v));
     }
 
     it = settings.find(s.timeoutInterByte);
     if (it != end)
     {
         QVariant v = it.value();
-        setTimeoutInterByte(v.toUInt());
+        setTimeoutInterByteUs(timeoutToUs(v));
     }
 
     return true;
@@ -257,7 +260,7 @@ StatusCode PortSerial::write()
         {
         case STATE_BEGIN:
         case STATE_PREPARE_TO_WRITE:
-            m_timestamp = QDateTime::currentMSecsSinceEpoch();
+            m_timestamp = monotonicTime();
             m_state = STATE_WAIT_FOR_WRITE;
             // no need break
         case STATE_WAIT_FOR_WRITE:
@@ -275,10 +278,10 @@ StatusCode PortSerial::write()
             if (m_serialPort->bytesToWrite() == 0)
             {
                 m_state = STATE_BEGIN;
-                Q_EMIT signalTx(QByteArray(reinterpret_cast<char*>(m_buff), m_sz));
+                emitTx(m_buff, m_sz);
                 return Status_Good;
             }
-            else if (QDateTime::currentMSecsSinceEpoch() - m_timestamp > m_timeoutFB)
+            else if (monotonicTime() - m_timestamp > m_timeoutFB * 1000LL)
             {
                 m_state = STATE_BEGIN;
                 return setError(Status_BadSerialWrite, QString("Error while writing serial port '%1' - %2")
@@ -308,7 +311,7 @@ StatusCode PortSerial::read()
         {
         case STATE_BEGIN:
         case STATE_PREPARE_TO_READ:
-            m_timestamp = QDateTime::currentMSecsSinceEpoch();
+            m_timestamp = monotonicTime();
             m_state = STATE_WAIT_FOR_READ;
             m_sz = 0;
             // no need break
@@ -329,8 +332,14 @@ StatusCode PortSerial::read()
                     m_state = STATE_BEGIN;
                     return setError(Status_BadReadBufferOverflow, QString("Serial port's '%1' read-buffer overflow").arg(serialPortName()));
                 }
+                if (isFrameComplete())
+                {
+                    m_state = STATE_BEGIN;
+                    emitRx(m_buff, m_sz);
+                    return Status_Good;
+                }
             }
-            else if (QDateTime::currentMSecsSinceEpoch() - m_timestamp >= m_timeoutFB) // waiting timeout read first byte elapsed
+            else if (monotonicTime() - m_timestamp >= effectiveResponseTimeout(m_timeoutFB) * 1000LL) // waiting timeout read first byte elapsed
             {
                 m_state = STATE_BEGIN;
                 return setError(Status_BadSerialRead, QString("Error while reading serial port '%1' - timeout")
@@ -340,7 +349,7 @@ StatusCode PortSerial::read()
             {
                 break;
             }
-            m_timestamp = QDateTime::currentMSecsSinceEpoch();
+            m_timestamp = monotonicTime();
             m_state = STATE_WAIT_FOR_READ_ALL;
             // no need break
         case STATE_WAIT_FOR_READ_ALL:
@@ -354,15 +363,36 @@ StatusCode PortSerial::read()
                 m_sz += static_cast<quint16>(c);
                 if (m_sz > c_buffSz)
                     return setError(Modbus::Status_BadReadBufferOverflow, QString("Serial port's '%1' read-buffer overflow").arg(serialPortName()));
-                m_timestamp = QDateTime::currentMSecsSinceEpoch();
+                m_timestamp = monotonicTime();
+                if (isFrameComplete())
+                {
+                    m_state = STATE_BEGIN;
+                    emitRx(m_buff, m_sz);
+                    return Status_Good;
+                }
+                if (isPreciseTiming() && (frameGapUs() * 1000LL <= InPlaceWaitLimit))
+                {
+                    fRepeatAgain = true;
+                    break;
+                }
             }
-            else if (QDateTime::currentMSecsSinceEpoch() - m_timestamp >= m_timeoutIB) // waiting timeout read next byte elapsed
+            else
             {
-                m_state = STATE_BEGIN;
-                QByteArray tmp = QByteArray(reinterpret_cast<char*>(m_buff), m_sz);
-                Q_EMIT signalRx(tmp);
-                //Q_EMIT signalRx(QByteArray(reinterpret_cast<char*>(m_buff), m_sz));
-                return Status_Good;
+                qint64 gap = frameGapUs() * 1000LL;
+                qint64 rest = m_timestamp + gap - monotonicTime();
+                if (rest <= 0) // waiting timeout read next byte elapsed
+                {
+                    m_state = STATE_BEGIN;
+                    emitRx(m_buff, m_sz);
+                    return Status_Good;
+                }
+                if (isPreciseTiming() && (gap <= InPlaceWaitLimit)) // short silence is waited without returning to the loop
+                {
+                    waitForReadyRead(rest);
+                    refreshMonotonicTime();
+                    fRepeatAgain = true;
+                    break;
+                }
             }
             return Status_Processing;
         default:
@@ -378,4 +408,40 @@ StatusCode PortSerial::read()
     return Status_Processing;
 }
 
+uint32_t PortSerial::frameGapUs() const
+{
+    return m_timeoutIB;
+}
+
+bool PortSerial::isFrameComplete() const
+{
+    return false;
+}
+
+bool PortSerial::isPreciseTiming() const
+{
+    return false;
+}
+
+void PortSerial::waitForReadyRead(qint64 nsec)
+{
+#ifdef Q_OS_UNIX
+    int fd = static_cast<int>(m_serialPort->handle());
+    if (fd >= 0)
+    {
+        fd_set fds;
+        FD_ZERO(&fds);
+        FD_SET(fd, &fds);
+        struct timeval tv;
+        tv.tv_sec = static_cast<time_t>(nsec / 1000000000);
+        tv.tv_usec = static_cast<suseconds_t>((nsec % 1000000000 + 999) / 1000);
+        // Note: received bytes are moved to the buffer of 'QSerialPort' by 'waitForReadyRead(0)'
+        if (::select(fd + 1, &fds, nullptr, nullptr, &tv) > 0)
+            m_serialPort->waitForReadyRead(0);
+        return;
+    }
+#endif
+    m_serialPort->waitForReadyRead(static_cast<int>((nsec + 999999) / 1000000));
+}
+
 } // namespace Modbus
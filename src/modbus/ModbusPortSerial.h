@@ -85,10 +85,16 @@ public: //settings
     inline bool setParity(QSerialPort::Parity parity) { return m_serialPort->setParity(parity); }
     inline QSerialPort::FlowControl flowControl() const { return m_serialPort->flowControl(); }
     inline bool setFlowControl(QSerialPort::FlowControl flowControl) { return m_serialPort->setFlowControl(flowControl); }
-    inline int timeoutFirstByte() const { return m_timeoutFB; }
-    inline void setTimeoutFirstByte(int timeout) { m_timeoutFB = timeout; }
-    inline int timeoutInterByte() const { return m_timeoutIB; }
-    inline void setTimeoutInterByte(int timeout) { m_timeoutIB = timeout; }
+    // timeouts in milliseconds
+    inline int timeoutFirstByte() const { return static_cast<int>(m_timeoutFB / 1000); }
+    inline void setTimeoutFirstByte(int timeout) { m_timeoutFB = timeoutMsToUs(timeout); }
+    inline int timeoutInterByte() const { return static_cast<int>(m_timeoutIB / 1000); }
+    inline void setTimeoutInterByte(int timeout) { m_timeoutIB = timeoutMsToUs(timeout); }
+    // timeouts in microseconds
+    inline uint32_t timeoutFirstByteUs() const { return m_timeoutFB; }
+    inline void setTimeoutFirstByteUs(uint32_t timeout) { m_timeoutFB = timeout; }
+    inline uint32_t timeoutInterByteUs() const { return m_timeoutIB; }
+    inline void setTimeoutInterByteUs(uint32_t timeout) { m_timeoutIB = timeout; }
     // settings
     Settings settings() const override;
     bool setSettings(const Settings& settings) override;
@@ -96,12 +102,24 @@ public: //settings
 protected:
     StatusCode write() override;
     StatusCode read() override;
+    // silence (microseconds) after the last received byte which ends the frame
+    virtual uint32_t frameGapUs() const;
+    // frame is already received completely, so there is no need to wait for the silence
+    virtual bool isFrameComplete() const;
+    // short frame gap is waited in place (see 'InPlaceWaitLimit') only when framing needs precise timing
+    virtual bool isPreciseTiming() const;
+
+private:
+    void waitForReadyRead(qint64 nsec);
 
 protected:
+    // the silence up to this value (nanoseconds) is waited in place instead of returning to the caller's loop
+    static const qint64 InPlaceWaitLimit = 2000000;
+
     QSerialPort *m_serialPort;
-    uint32_t m_timeoutFB;
-    uint32_t m_timeoutIB;
-    qint64 m_timestamp;
+    uint32_t m_timeoutFB; // microseconds
+    uint32_t m_timeoutIB; // microseconds
+    qint64 m_timestamp;   // monotonic, nanoseconds
     uint8_t *m_buff;
     uint16_t c_buffSz;
     uint16_t m_sz;
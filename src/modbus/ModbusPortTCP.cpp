@@ -22,7 +22,6 @@
 */
 #include "ModbusPortTCP.h"
 
-#include <QDateTime>
 #include <QTcpSocket>
 
 namespace Modbus {
@@ -62,8 +61,11 @@ PortTCP::PortTCP(QTcpSocket *socket, QObject *parent) :
     m_autoIncrement = true;
     m_host = d.host;
     m_port = d.port;
-    m_timeout = d.timeout;
+    setTimeout(d.timeout);
     m_transaction = 0;
+    m_rxHead = 0;
+    m_rxTail = 0;
+    m_txSz = 0;
 }
 
 PortTCP::PortTCP(QObject *parent) :
@@ -83,7 +85,7 @@ Settings PortTCP::settings() const
     Strings s = Strings::instance();
     params[s.host] = host();
     params[s.port] = port();
-    params[s.timeout] = timeout();
+    params[s.timeout] = timeoutFromUs(timeoutUs());
     return params;
 }
 
@@ -112,7 +114,7 @@ bool PortTCP::setSettings(const Settings &settings)
     if (it != end)
     {
         QVariant v = it.value();
-        setTimeout(v.toUInt());
+        setTimeoutUs(timeoutToUs(v));
     }
 
     return true;
@@ -136,7 +138,7 @@ StatusCode PortTCP::open()
                 return Status_Good;
             }
             m_socket->connectToHost(m_host, m_port);
-            m_timestamp = QDateTime::currentMSecsSinceEpoch();
+            m_timestamp = monotonicTime();
             m_state = STATE_WAIT_FOR_OPEN;
         }
             // no need break
@@ -149,7 +151,7 @@ StatusCode PortTCP::open()
                 m_state = STATE_BEGIN;
                 return Status_Good;
             }
-            else if (QDateTime::currentMSecsSinceEpoch() - m_timestamp >= m_timeout)
+            else if (monotonicTime() - m_timestamp >= m_timeout * 1000LL)
             {
                 m_socket->abort();
                 m_state = STATE_CLOSED;
@@ -174,6 +176,9 @@ StatusCode PortTCP::open()
 StatusCode PortTCP::close()
 {
     m_socket->close();
+    m_rxHead = 0;
+    m_rxTail = 0;
+    m_txSz = 0;
     m_state = STATE_CLOSED;
     return Status_Good;
 }
@@ -208,6 +213,8 @@ void PortTCP::setNextRequestRepeated(bool v)
 
 StatusCode PortTCP::write()
 {
+    if (m_modeServer)
+        return writeFrame();
     bool fRepeatAgain;
     do
     {
@@ -216,7 +223,7 @@ StatusCode PortTCP::write()
         {
         case STATE_BEGIN:
         case STATE_PREPARE_TO_WRITE:
-            m_timestamp = QDateTime::currentMSecsSinceEpoch();
+            m_timestamp = monotonicTime();
             m_state = STATE_WAIT_FOR_WRITE;
             // no need break
         case STATE_WAIT_FOR_WRITE:
@@ -228,12 +235,12 @@ StatusCode PortTCP::write()
             m_state = STATE_WAIT_FOR_WRITE_ALL;
             // no need break
         case STATE_WAIT_FOR_WRITE_ALL:
-            Q_EMIT signalTx(QByteArray(reinterpret_cast<char*>(m_buff), m_sz));
+            emitTx(m_buff, m_sz);
             m_state = STATE_BEGIN;
             return Status_Good;
             /*if (m_socket->bytesToWrite() == 0)
             {
-                Q_EMIT signalTx(QByteArray(reinterpret_cast<char*>(m_buff), m_sz));
+                emitTx(m_buff, m_sz);
                 m_state = STATE_BEGIN;
                 return Status_Good;
             }
@@ -259,6 +266,8 @@ StatusCode PortTCP::write()
 
 StatusCode PortTCP::read()
 {
+    if (m_modeServer)
+        return readFrame();
     bool fRepeatAgain;
     do
     {
@@ -269,7 +278,7 @@ StatusCode PortTCP::read()
         case STATE_PREPARE_TO_READ:
             m_sz = 0;
             m_packetSz = 0;
-            m_timestamp = QDateTime::currentMSecsSinceEpoch();
+            m_timestamp = monotonicTime();
             m_state = STATE_WAIT_FOR_READ;
             // no need break
         case STATE_WAIT_FOR_READ:
@@ -286,7 +295,7 @@ StatusCode PortTCP::read()
                 m_state = STATE_WAIT_FOR_READ_ALL;
                 // no need break
             }
-            else if (QDateTime::currentMSecsSinceEpoch()-m_timestamp >= m_timeout) // waiting timeout read first byte elapsed
+            else if (monotonicTime()-m_timestamp >= effectiveResponseTimeout(m_timeout) * 1000LL) // waiting timeout read first byte elapsed
             {
                 close();
                 return setError(Status_BadTcpRead, QStringLiteral("TCP. Error while reading - timeout"));
@@ -306,12 +315,12 @@ StatusCode PortTCP::read()
                 m_sz += static_cast<uint16_t>(c);
                 if (m_sz >= m_packetSz)
                 {
-                    Q_EMIT signalRx(QByteArray(reinterpret_cast<char*>(m_buff), m_sz));
+                    emitRx(m_buff, m_sz);
                     m_state = STATE_BEGIN;
                     return Status_Good;
                 }
             }
-            else if (QDateTime::currentMSecsSinceEpoch()-m_timestamp >= m_timeout) // waiting timeout read first byte elapsed
+            else if (monotonicTime()-m_timestamp >= effectiveResponseTimeout(m_timeout) * 1000LL) // waiting timeout read first byte elapsed
             {
                 close();
                 return setError(Status_BadTcpRead, QStringLiteral("TCP. Error while reading - timeout"));
@@ -331,6 +340,201 @@ StatusCode PortTCP::read()
     return Status_Processing;
 }
 
+bool PortTCP::hasPendingFrame() const
+{
+    uint32_t c = m_rxTail - m_rxHead;
+    if (c < MB_TCP_PREFIX_SZ)
+        return false;
+    uint32_t sz = (rxByte(5) | (rxByte(4) << 8)) + MB_TCP_PREFIX_SZ;
+    return c >= sz;
+}
+
+StatusCode PortTCP::readFrame()
+{
+    if (m_state != STATE_WAIT_FOR_READ)
+    {
+        if (!isOpen())
+            return Status_Processing;
+        m_timestamp = monotonicTime();
+        m_state = STATE_WAIT_FOR_READ;
+    }
+    StatusCode r = fillRxBuffer();
+    if (StatusIsBad(r))
+    {
+        m_state = STATE_BEGIN;
+        return r;
+    }
+    uint32_t c = m_rxTail - m_rxHead;
+    if (c >= MB_TCP_PREFIX_SZ)
+    {
+        uint32_t sz = (rxByte(5) | (rxByte(4) << 8)) + MB_TCP_PREFIX_SZ;
+        if ((sz < 8) || (sz > MBCLIENTTCP_BUFF_SZ)) // stream can't be synchronized anymore
+        {
+            flushTxBuffer();
+            close();
+            return setError(Status_BadNotCorrectRequest, QStringLiteral("TCP. Not correct read-buffer's TCP-prefix. Wrong size of the frame"));
+        }
+        if (c >= sz)
+        {
+            uint32_t pos = m_rxHead & (MBSERVERTCP_RX_BUFF_SZ-1);
+            uint32_t part = MBSERVERTCP_RX_BUFF_SZ - pos;
+            if (part >= sz)
+                memcpy(m_buff, &m_rxBuff[pos], sz);
+            else // frame is wrapped around the end of the ring buffer
+            {
+                memcpy(m_buff, &m_rxBuff[pos], part);
+                memcpy(m_buff+part, m_rxBuff, sz-part);
+            }
+            m_rxHead += sz;
+            m_sz = static_cast<uint16_t>(sz);
+            emitRx(m_buff, m_sz);
+            m_state = STATE_BEGIN;
+            return Status_Good;
+        }
+    }
+    // there is no complete request yet so responses for the previous ones must be sent
+    r = flushTxBuffer();
+    if (StatusIsBad(r))
+        return r;
+    if (monotonicTime()-m_timestamp >= m_timeout * 1000LL)
+    {
+        close();
+        return setError(Status_BadTcpRead, QStringLiteral("TCP. Error while reading - timeout"));
+    }
+    return Status_Processing;
+}
+
+StatusCode PortTCP::writeFrame()
+{
+    if (m_txSz + m_sz > MBSERVERTCP_TX_BUFF_SZ)
+    {
+        StatusCode r = flushTxBuffer();
+        if (StatusIsBad(r))
+        {
+            m_state = STATE_BEGIN;
+            return r;
+        }
+    }
+    memcpy(&m_txBuff[m_txSz], m_buff, m_sz);
+    m_txSz += m_sz;
+    emitTx(m_buff, m_sz);
+    m_state = STATE_BEGIN;
+    if (hasPendingFrame()) // response will be sent together with the responses for the next requests
+        return Status_Good;
+    return flushTxBuffer();
+}
+
+StatusCode PortTCP::fillRxBuffer()
+{
+    while (m_socket->bytesAvailable() > 0)
+    {
+        uint32_t free = MBSERVERTCP_RX_BUFF_SZ - (m_rxTail - m_rxHead);
+        if (free == 0)
+            break;
+        uint32_t pos = m_rxTail & (MBSERVERTCP_RX_BUFF_SZ-1);
+        uint32_t part = MBSERVERTCP_RX_BUFF_SZ - pos;
+        if (part > free)
+            part = free;
+        qint64 c = m_socket->read(reinterpret_cast<char*>(&m_rxBuff[pos]), part);
+        if (c < 0)
+            return setError(Status_BadTcpRead, QString("TCP. Error while reading - %1").arg(m_socket->errorString()));
+        if (c == 0)
+            break;
+        m_rxTail += static_cast<uint32_t>(c);
+    }
+    return Status_Good;
+}
+
+StatusCode PortTCP::flushTxBuffer()
+{
+    if (m_txSz == 0)
+        return Status_Good;
+    qint64 c = m_socket->write(reinterpret_cast<char*>(m_txBuff), m_txSz);
+    m_txSz = 0;
+    if (c == -1)
+        return setError(Status_BadTcpWrite, QString("TCP. Error while writing - %1").arg(m_socket->errorString()));
+    return Status_Good;
+}
+
+StatusCode PortTCP::writeTransaction(uint16_t transaction, uint8_t unit, uint8_t func, const uint8_t *buff, uint16_t szInBuff)
+{
+    uint8_t adu[MBCLIENTTCP_BUFF_SZ];
+
+    // 8 = 6(TCP prefix size in bytes) + 2(slave and function bytes)
+    if (szInBuff > MBCLIENTTCP_BUFF_SZ - 8)
+        return setError(Status_BadWriteBufferOverflow, QStringLiteral("TCP. Write-buffer overflow"));
+    // standart TCP message prefix
+    adu[0] = static_cast<uint8_t>(transaction >> 8);  // transaction id
+    adu[1] = static_cast<uint8_t>(transaction);       // transaction id
+    adu[2] = 0;
+    adu[3] = 0;
+    uint16_t cBytes = szInBuff + 2; // quantity of next bytes
+    adu[4] = static_cast<uint8_t>(cBytes >> 8);       // quantity of next bytes (MSB)
+    adu[5] = static_cast<uint8_t>(cBytes);            // quantity of next bytes (LSB)
+    // slave, function, data
+    adu[6] = unit;
+    adu[7] = func;
+    memcpy(&adu[8], buff, szInBuff);
+    uint16_t sz = szInBuff + 8;
+    if (m_socket->write(reinterpret_cast<char*>(adu), sz) == -1)
+        return setError(Status_BadTcpWrite, QString("TCP. Error while writing - %1").arg(m_socket->errorString()));
+    emitTx(adu, sz);
+    return Status_Good;
+}
+
+StatusCode PortTCP::readTransaction(uint16_t *transaction)
+{
+    if (m_state != STATE_WAIT_FOR_READ_ALL) // previous frame was processed, begin to read the next one
+    {
+        m_sz = 0;
+        m_packetSz = 0;
+        m_state = STATE_WAIT_FOR_READ_ALL;
+    }
+    if (m_sz < MB_TCP_PREFIX_SZ)
+    {
+        qint64 c = m_socket->read(reinterpret_cast<char*>(m_buff+m_sz), MB_TCP_PREFIX_SZ-m_sz);
+        if (c < 0)
+        {
+            m_state = STATE_BEGIN;
+            return setError(Status_BadTcpRead, QString("TCP. Error while reading - %1").arg(m_socket->errorString()));
+        }
+        m_sz += static_cast<uint16_t>(c);
+        if (m_sz < MB_TCP_PREFIX_SZ)
+            return Status_Processing;
+        m_packetSz = (m_buff[5] | (m_buff[4] << 8)) + MB_TCP_PREFIX_SZ;
+        if ((m_packetSz < 8) || (m_packetSz > MBCLIENTTCP_BUFF_SZ))
+        {
+            m_state = STATE_BEGIN;
+            return setError(Status_BadNotCorrectResponse, QStringLiteral("TCP. Not correct read-buffer's TCP-prefix. Wrong size of the frame"));
+        }
+    }
+    if (m_sz < m_packetSz)
+    {
+        qint64 c = m_socket->read(reinterpret_cast<char*>(m_buff+m_sz), m_packetSz-m_sz);
+        if (c < 0)
+        {
+            m_state = STATE_BEGIN;
+            return setError(Status_BadTcpRead, QString("TCP. Error while reading - %1").arg(m_socket->errorString()));
+        }
+        m_sz += static_cast<uint16_t>(c);
+        if (m_sz < m_packetSz)
+            return Status_Processing;
+    }
+    m_state = STATE_BEGIN;
+    *transaction = m_buff[1] | (m_buff[0] << 8);
+    return Status_Good;
+}
+
+StatusCode PortTCP::readTransactionBuffer(uint8_t unit, uint8_t func, uint8_t *buff, uint16_t maxSzBuff, uint16_t *szOutBuff)
+{
+    emitRx(m_buff, m_sz);
+    // Note: readBuffer() checks up the response against the expected values
+    m_transaction = m_buff[1] | (m_buff[0] << 8);
+    m_unit = unit;
+    m_func = func;
+    return readBuffer(unit, func, buff, maxSzBuff, szOutBuff);
+}
+
 StatusCode PortTCP::writeBuffer(uint8_t slave, uint8_t func, uint8_t *buff, uint16_t szInBuff)
 {
     if (!m_modeServer)
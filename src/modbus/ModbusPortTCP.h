@@ -29,6 +29,12 @@ class QTcpSocket;
 
 #define MBCLIENTTCP_BUFF_SZ MB_TCP_IO_BUFF_SZ
 
+// Size of receive ring buffer of the server connection (must be power of 2)
+#define MBSERVERTCP_RX_BUFF_SZ 4096
+
+// Size of the buffer where responses of the server connection are collected before sending
+#define MBSERVERTCP_TX_BUFF_SZ 4096
+
 namespace Modbus {
 
 class MODBUS_EXPORT PortTCP : public Port
@@ -71,14 +77,24 @@ public:
     void setHost(const QString &host);
     inline uint16_t port() const { return m_port; }
     void setPort(uint16_t port);
-    inline uint32_t timeout() const { return m_timeout; }
-    inline void setTimeout(uint32_t timeout) { m_timeout = timeout; }
+    // timeout in milliseconds
+    inline uint32_t timeout() const { return m_timeout / 1000; }
+    inline void setTimeout(uint32_t timeout) { m_timeout = timeoutMsToUs(timeout); }
+    // timeout in microseconds
+    inline uint32_t timeoutUs() const { return m_timeout; }
+    inline void setTimeoutUs(uint32_t timeout) { m_timeout = timeout; }
     // settings
     Settings settings() const override;
     bool setSettings(const Settings &settings) override;
     void setNextRequestRepeated(bool v) override;
     // autoincrement transaction id
     inline bool autoIncrement() const { return m_autoIncrement; }
+    bool hasPendingFrame() const override;
+
+public: // pipelined transactions (client mode)
+    StatusCode writeTransaction(uint16_t transaction, uint8_t unit, uint8_t func, const uint8_t *buff, uint16_t szInBuff);
+    StatusCode readTransaction(uint16_t *transaction);
+    StatusCode readTransactionBuffer(uint8_t unit, uint8_t func, uint8_t *buff, uint16_t maxSzBuff, uint16_t *szOutBuff);
 
 protected:
     StatusCode write() override;
@@ -86,17 +102,30 @@ protected:
     StatusCode writeBuffer(uint8_t slave, uint8_t func, uint8_t *buff, uint16_t szInBuff) override;
     StatusCode readBuffer(uint8_t &slave, uint8_t &func, uint8_t *buff, uint16_t maxSzBuff, uint16_t *szOutBuff) override;
 
+private: // server mode
+    StatusCode readFrame();
+    StatusCode writeFrame();
+    StatusCode fillRxBuffer();
+    StatusCode flushTxBuffer();
+    inline uint8_t rxByte(uint32_t i) const { return m_rxBuff[(m_rxHead+i) & (MBSERVERTCP_RX_BUFF_SZ-1)]; }
+
 private:
     QTcpSocket *m_socket;
     QString m_host;
     uint16_t m_port;
     uint16_t m_transaction;
     bool m_autoIncrement;
-    uint32_t m_timeout;
-    qint64 m_timestamp;
+    uint32_t m_timeout;   // microseconds
+    qint64 m_timestamp;   // monotonic, nanoseconds
     uint8_t m_buff[MBCLIENTTCP_BUFF_SZ];
     uint16_t m_sz;
     uint16_t m_packetSz;
+    // server mode
+    uint8_t m_rxBuff[MBSERVERTCP_RX_BUFF_SZ];
+    uint32_t m_rxHead;
+    uint32_t m_rxTail;
+    uint8_t m_txBuff[MBSERVERTCP_TX_BUFF_SZ];
+    uint16_t m_txSz;
 };
 
 } // namespace Modbus
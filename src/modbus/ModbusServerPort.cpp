@@ -50,11 +50,36 @@ const ServerPort::Defaults &ServerPort::Defaults::instance()
 }
 
 
+ServerPort::Statistics::Statistics()
+{
+    memset(this, 0, sizeof(*this));
+}
+
+void ServerPort::Statistics::add(const Statistics &other)
+{
+    requests    += other.requests   ;
+    errors      += other.errors     ;
+    ignored     += other.ignored    ;
+    responses   += other.responses  ;
+    exceptions  += other.exceptions ;
+    bytesIn     += other.bytesIn    ;
+    bytesOut    += other.bytesOut   ;
+    processTime += other.processTime;
+    discarded   += other.discarded  ;
+    for (int i = 0; i < FunctionCount; i++)
+    {
+        functionRequests  [i] += other.functionRequests  [i];
+        functionExceptions[i] += other.functionExceptions[i];
+    }
+}
+
 ServerPort::ServerPort(Port *port, Interface *device, QObject *parent) :
     QObject (parent)
 {
     m_state = STATE_UNKNOWN;
     m_cmdClose = false;
+    m_trace = true;
+    m_queued = false;
     m_port = port;
     if (port) // TODO: find better descision
     {
@@ -66,6 +91,8 @@ ServerPort::ServerPort(Port *port, Interface *device, QObject *parent) :
         connect(m_port, &Port::signalMessage, this, &ServerPort::setMessage );
     }
     m_device = device;
+    m_timer.start();
+    m_requestStart = 0;
 }
 
 Modbus::Type ServerPort::type() const
@@ -170,10 +197,17 @@ StatusCode ServerPort::process()
             m_state = STATE_READ;
             // no need break
         case STATE_READ:
+            m_requestStart = m_timer.nsecsElapsed();
             // verify slave id
             r = m_port->readBuffer(m_unit, m_func, buff, szBuff, &outBytes);
+            m_stats.discarded = m_port->discardedBytes();
             if (StatusIsGood(r))
+            {
+                m_stats.requests++;
+                m_stats.bytesIn += outBytes;
+                m_stats.functionRequests[m_func & (FunctionCount-1)]++;
                 r = processInputData(buff, outBytes);
+            }
             if (StatusIsBad(r)) // data error
             {
                 if (StatusIsStandardError(r)) // return standard error to device
@@ -184,6 +218,7 @@ StatusCode ServerPort::process()
                 }
                 else
                 {
+                    m_stats.errors++;
                     m_state = STATE_BEGIN_READ;
                     return r;
                 }
@@ -196,6 +231,7 @@ StatusCode ServerPort::process()
                 return r;
             if (r == Status_BadUnknownUnit)
             {
+                m_stats.ignored++;
                 m_state = STATE_BEGIN_READ;
                 return r;
             }
@@ -211,9 +247,12 @@ StatusCode ServerPort::process()
                 else
                     buff[0] = static_cast<uint8_t>(Status_BadSlaveDeviceFailure & 0xFF);
                 outCount = 1;
+                m_stats.exceptions++;
+                m_stats.functionExceptions[m_func & (FunctionCount-1)]++;
             }
             else
                 processOutputData(buff, outCount);
+            m_stats.bytesOut += outCount;
             m_port->writeBuffer(m_unit, func, buff, outCount);
             m_state = STATE_BEGIN_WRITE;
             // no need break
@@ -221,7 +260,14 @@ StatusCode ServerPort::process()
             r = m_port->write();
             if (StatusIsProcessing(r))
                 return r;
+            m_stats.responses++;
+            m_stats.processTime += static_cast<uint64_t>(m_timer.nsecsElapsed() - m_requestStart);
             m_state = STATE_BEGIN_READ;
+            if (StatusIsGood(r) && m_port->hasPendingFrame()) // next request is already received
+            {
+                fRepeatAgain = true;
+                break;
+            }
             return r;
         default:
             if (m_cmdClose && isOpen())
@@ -243,6 +289,23 @@ StatusCode ServerPort::process()
     return Status_Processing;
 }
 
+void ServerPort::setTraceEnabled(bool enable)
+{
+    m_trace = enable;
+    if (m_port)
+        m_port->setTraceEnabled(enable);
+}
+
+int ServerPort::idleTimeout() const
+{
+    return 0;
+}
+
+ServerPort::Statistics ServerPort::totalStatistics() const
+{
+    return m_stats;
+}
+
 void ServerPort::slotTx(const QByteArray &bytes)
 {
     Q_EMIT signalTx(name(), bytes);
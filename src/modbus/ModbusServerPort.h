@@ -23,6 +23,8 @@
 #ifndef MODBUSSERVERPORT_H
 #define MODBUSSERVERPORT_H
 
+#include <QElapsedTimer>
+
 #include "ModbusPort.h"
 
 #define MBSLAVE_SZ_VALUE_BUFF MB_VALUE_BUFF_SZ
@@ -79,6 +81,28 @@ public:
     };
     Q_ENUM(Status)
 
+    static const int FunctionCount = 128;
+
+    // Request counters. Counters are plain integers written by the thread of the port only,
+    // so they must be read (e.g. copied to a snapshot) within the same thread
+    struct Statistics
+    {
+        uint64_t requests   ; // requests received (correct frames)
+        uint64_t errors     ; // broken frames and incorrect requests (no response)
+        uint64_t ignored    ; // requests for unknown unit (no response)
+        uint64_t responses  ; // responses sent (including exceptions)
+        uint64_t exceptions ; // exception responses
+        uint64_t bytesIn    ; // data bytes of requests
+        uint64_t bytesOut   ; // data bytes of responses
+        uint64_t processTime; // nanoseconds from request received to response sent (total of all responses)
+        uint64_t discarded  ; // bytes discarded by frame resynchronization
+        uint64_t functionRequests  [FunctionCount];
+        uint64_t functionExceptions[FunctionCount];
+
+        Statistics();
+        void add(const Statistics &other);
+    };
+
 public:
     explicit ServerPort(Port *port, Interface *device, QObject* parent = nullptr);
 
@@ -102,9 +126,22 @@ public:
     // settings
     virtual Settings settings();
     virtual bool setSettings(const Settings &settings);
+    // 'signalTx'/'signalRx' are emitted only when trace is enabled (enabled by default)
+    inline bool isTraceEnabled() const { return m_trace; }
+    virtual void setTraceEnabled(bool enable);
+    // counters of requests processed by this port
+    inline const Statistics &statistics() const { return m_stats; }
+    // total counters including the connections of TCP-server
+    virtual Statistics totalStatistics() const;
+    // connection is queued for processing by event driven TCP-server
+    inline bool isQueued() const { return m_queued; }
+    inline void setQueued(bool queued) { m_queued = queued; }
 
 public:
     virtual StatusCode process();
+    // time (milliseconds) caller can wait for I/O events before next 'process()' call, 0 - call 'process()' immediately,
+    // -1 - there are no timed events, so caller can wait for I/O events only
+    virtual int idleTimeout() const;
 
 Q_SIGNALS:
     void signalTx(const QString& source, const QByteArray& bytes);
@@ -131,8 +168,13 @@ protected:
     uint16_t m_count;
     uint8_t m_valueBuff[MBSLAVE_SZ_VALUE_BUFF];
     bool m_cmdClose;
+    bool m_trace;
+    bool m_queued;
     Port *m_port;
     Interface *m_device;
+    Statistics m_stats;
+    QElapsedTimer m_timer;
+    qint64 m_requestStart;
 };
 
 } // namespace Modbus
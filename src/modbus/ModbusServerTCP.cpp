@@ -25,7 +25,6 @@
 #include <QTcpServer>
 #include <QTcpSocket>
 
-#include <QDateTime>
 #include <QDebug>
 #include "ModbusPortTCP.h"
 
@@ -33,7 +32,8 @@ namespace Modbus {
 
 ServerTCP::Strings::Strings() :
     port(QStringLiteral("port")),
-    timeout(QStringLiteral("timeout"))
+    timeout(QStringLiteral("timeout")),
+    eventDriven(QStringLiteral("eventDriven"))
 {
 }
 
@@ -45,7 +45,8 @@ const ServerTCP::Strings &ServerTCP::Strings::instance()
 
 ServerTCP::Defaults::Defaults() :
     port(static_cast<quint16>(Modbus::STANDARD_TCP_PORT)),
-    timeout(3000)
+    timeout(3000),
+    eventDriven(false)
 {
 }
 
@@ -62,7 +63,9 @@ ServerTCP::ServerTCP(QTcpServer *server, Interface *device, QObject *parent) :
     Defaults d = Defaults::instance();
 
     m_tcpPort = d.port;
-    m_timeout = d.timeout;
+    setTimeout(d.timeout);
+    m_eventDriven = d.eventDriven;
+    m_timestampSweep = 0;
 }
 
 ServerTCP::ServerTCP(Interface *device, QObject *parent) :
@@ -86,8 +89,14 @@ StatusCode ServerTCP::open()
                 m_state = STATE_OPENED;
                 return Status_Good;
             }
+            if (!m_server) // connections are appended externally
+            {
+                m_cmdClose = false;
+                m_state = STATE_OPENED;
+                return Status_Good;
+            }
             m_server->listen(QHostAddress::Any, port());
-            m_timestamp = QDateTime::currentMSecsSinceEpoch();
+            m_timestamp = monotonicTime();
             m_state = STATE_WAIT_FOR_OPEN;
             //fRepeatAgain = true;
             // no need break
@@ -97,7 +106,7 @@ StatusCode ServerTCP::open()
                 setMessage(QString("Start to listen successfully"));
                 return Status_Good;
             }
-            else if (QDateTime::currentMSecsSinceEpoch() - m_timestamp >= m_timeout)
+            else if (monotonicTime() - m_timestamp >= m_timeout * 1000LL)
             {
                 m_server->close();
                 m_state = STATE_CLOSED;
@@ -121,7 +130,7 @@ StatusCode ServerTCP::open()
 
 StatusCode ServerTCP::close()
 {
-    if (m_server->isListening())
+    if (m_server && m_server->isListening())
         m_server->close();
     m_cmdClose = true;
     Q_FOREACH (ServerPort *c, m_connections)
@@ -144,7 +153,9 @@ StatusCode ServerTCP::close()
 
 bool ServerTCP::isOpen() const
 {
-    return m_server->isListening();
+    if (m_server)
+        return m_server->isListening();
+    return !m_cmdClose;
 }
 
 Settings ServerTCP::settings()
@@ -152,7 +163,8 @@ Settings ServerTCP::settings()
     Settings params;
     Strings s = Strings::instance();
     params.insert(s.port, port());
-    params.insert(s.timeout, timeout());
+    params.insert(s.timeout, timeoutFromUs(timeoutUs()));
+    params.insert(s.eventDriven, isEventDriven());
     return params;
 }
 
@@ -174,7 +186,14 @@ bool ServerTCP::setSettings(const Settings &settings)
     if (it != end)
     {
         QVariant v = it.value();
-        setTimeout(v.toUInt());
+        setTimeoutUs(timeoutToUs(v));
+    }
+
+    it = settings.find(s.eventDriven);
+    if (it != end)
+    {
+        QVariant v = it.value();
+        setEventDriven(v.toBool());
     }
 
     return true;
@@ -212,8 +231,11 @@ StatusCode ServerTCP::process()
             if (r) // if not OK it's mean that an error occured or in process
                 return r;
             m_state = STATE_CLOSED;
+            Q_FOREACH (ServerPort *c, m_connections)
+                m_closedStats.add(c->totalStatistics());
             qDeleteAll(m_connections);
             m_connections.clear();
+            m_ready.clear();
             setMessage("Finalized");
             break;
         case STATE_OPENED:
@@ -229,30 +251,17 @@ StatusCode ServerTCP::process()
                 break;
             }
             // check up new connection
-            if (QTcpSocket* s = m_server->nextPendingConnection())
+            while (QTcpSocket* s = (m_server ? m_server->nextPendingConnection() : nullptr))
             {
-                ServerPort *c = createPortTCP(s);
-                m_connections.append(c);
-                connect(c, &ServerPort::signalTx     , this, &ServerPort::signalTx     );
-                connect(c, &ServerPort::signalRx     , this, &ServerPort::signalRx     );
-                connect(c, &ServerPort::signalError  , this, &ServerPort::signalError  );
-                connect(c, &ServerPort::signalMessage, this, &ServerPort::signalMessage);
-                setMessage(QString("New connection from '%1'").arg(c->name()));
+                appendConnection(s);
+                if (!m_eventDriven) // polling mode accepts one connection per cycle
+                    break;
             }
             // process current connections
-            for (Connections_t::iterator it = m_connections.begin(); it != m_connections.end(); )
-            {
-                ServerPort *c = *it;
-                c->process();
-                if (!c->isOpen())
-                {
-                    setMessage(QString("Close connection from '%1'").arg(c->name()));
-                    it = m_connections.erase(it);
-                    delete c;
-                    continue;
-                }
-                it++;
-            }
+            if (m_eventDriven)
+                processReadyConnections();
+            else
+                processAllConnections();
         }
             break;
         default:
@@ -275,12 +284,128 @@ StatusCode ServerTCP::process()
     return Status_Processing;
 }
 
+int ServerTCP::idleTimeout() const
+{
+    if (!m_eventDriven || (m_state != STATE_PROCESS_DEVICE) || m_cmdClose || !m_ready.isEmpty())
+        return 0;
+    // Note: there is nothing to sweep, so only new connection (or external one) can wake up the caller
+    if (m_connections.isEmpty())
+        return -1;
+    qint64 t = m_timestampSweep + IdleSweepPeriod * 1000000LL - monotonicTime();
+    if (t > 0)
+        return static_cast<int>((t + 999999) / 1000000); // nanoseconds to milliseconds rounded up
+    return 0;
+}
+
+ServerPort::Statistics ServerTCP::totalStatistics() const
+{
+    Statistics r = m_closedStats;
+    Q_FOREACH (ServerPort *c, m_connections)
+        r.add(c->totalStatistics());
+    return r;
+}
+
+void ServerTCP::setTraceEnabled(bool enable)
+{
+    ServerPort::setTraceEnabled(enable);
+    Q_FOREACH (ServerPort *c, m_connections)
+        c->setTraceEnabled(enable);
+}
+
 ServerPort *ServerTCP::createPortTCP(QTcpSocket *socket)
 {
     PortTCP *tcp = new PortTCP(socket);
     ServerPort *port = new ServerPort(tcp, device());
-    port->setName(socket->localAddress().toString());
+    // Note: remote address and port identify the client
+    port->setName(QString("%1:%2").arg(socket->peerAddress().toString()).arg(socket->peerPort()));
     return port;
 }
 
+void ServerTCP::appendConnection(QTcpSocket *socket)
+{
+    ServerPort *c = createPortTCP(socket);
+    socket->setParent(c);
+    c->setTraceEnabled(isTraceEnabled());
+    m_connections.append(c);
+    connect(c, &ServerPort::signalTx     , this, &ServerPort::signalTx     );
+    connect(c, &ServerPort::signalRx     , this, &ServerPort::signalRx     );
+    connect(c, &ServerPort::signalError  , this, &ServerPort::signalError  );
+    connect(c, &ServerPort::signalMessage, this, &ServerPort::signalMessage);
+    setMessage(QString("New connection from '%1'").arg(c->name()));
+    if (m_eventDriven)
+    {
+        // Note: 'readyRead' and 'disconnected' are emitted within the event loop of the current thread
+        connect(socket, &QTcpSocket::readyRead   , c, [this, c]() { setReady(c); });
+        connect(socket, &QTcpSocket::disconnected, c, [this, c]() { setReady(c); });
+        setReady(c);
+    }
+}
+
+void ServerTCP::processAllConnections()
+{
+    for (Connections_t::iterator it = m_connections.begin(); it != m_connections.end(); )
+    {
+        ServerPort *c = *it;
+        c->process();
+        if (!c->isOpen())
+        {
+            it = m_connections.erase(it);
+            deleteConnection(c);
+            continue;
+        }
+        it++;
+    }
+}
+
+void ServerTCP::processReadyConnections()
+{
+    qint64 timestamp = monotonicTime();
+    if (timestamp - m_timestampSweep >= IdleSweepPeriod * 1000000LL)
+    {
+        // idle connections have no I/O events but still must check up its timeouts
+        for (int i = 0; i < m_connections.count(); i++)
+            setReady(m_connections.at(i));
+        m_timestampSweep = timestamp;
+    }
+    m_processing.swap(m_ready);
+    for (int i = 0; i < m_processing.count(); i++)
+    {
+        ServerPort *c = m_processing.at(i);
+        StatusCode r = c->process();
+        // Note: flag is cleared after 'process()', so 'disconnected' emitted while connection
+        // is closed doesn't queue it again
+        c->setQueued(false);
+        if (!c->isOpen())
+        {
+            m_connections.removeOne(c);
+            deleteConnection(c);
+            continue;
+        }
+        // Note: connection that waits for incoming data has read all available bytes from socket
+        // so it will be signaled by 'readyRead' when next data is received
+        if (!(StatusIsProcessing(r) && (c->state() == STATE_BEGIN_READ)))
+            setReady(c);
+    }
+    m_processing.clear();
+}
+
+void ServerTCP::deleteConnection(ServerPort *c)
+{
+    setMessage(QString("Close connection from '%1'").arg(c->name()));
+    // Note: socket emits 'disconnected' synchronously while it's closed or destroyed,
+    // so its signals must not refer to the connection being deleted
+    if (QTcpSocket *socket = c->findChild<QTcpSocket*>(QString(), Qt::FindDirectChildrenOnly))
+        socket->disconnect(c);
+    m_closedStats.add(c->totalStatistics());
+    delete c;
+}
+
+void ServerTCP::setReady(ServerPort *c)
+{
+    if (c->isQueued())
+        return;
+    c->setQueued(true);
+    m_ready.append(c);
+}
+
 } // namespace Modbus
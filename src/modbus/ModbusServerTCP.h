@@ -23,6 +23,8 @@
 #ifndef MODBUSSERVERTCP_H
 #define MODBUSSERVERTCP_H
 
+#include <QVector>
+
 #include "ModbusServerPort.h"
 
 class QTcpServer;
@@ -37,6 +39,7 @@ public:
     {
         const QString port;
         const QString timeout;
+        const QString eventDriven;
 
         Strings();
         static const Strings &instance();
@@ -46,12 +49,14 @@ public:
     {
         const quint16 port;
         const int timeout;
+        const bool eventDriven;
 
         Defaults();
         static const Defaults &instance();
     };
 
 public:
+    // Note: if 'server' is nullptr then port doesn't listen and serves connections appended by 'appendConnection()'
     ServerTCP(QTcpServer* server, Interface *device, QObject *parent = nullptr);
     ServerTCP(Interface *device, QObject *parent = nullptr);
 
@@ -63,25 +68,56 @@ public:
     Settings settings() override;
     bool setSettings(const Settings &settings) override;
     StatusCode process() override;
+    int idleTimeout() const override;
+    void setTraceEnabled(bool enable) override;
+    // counters of closed connections and current connections
+    Statistics totalStatistics() const override;
     
 public:
     virtual ServerPort *createPortTCP(QTcpSocket *socket);
+    // port takes ownership of the connected 'socket', must be called within the thread of the port
+    void appendConnection(QTcpSocket *socket);
+    // current connections, must be used within the thread of the port
+    inline int connectionCount() const { return m_connections.count(); }
+    inline ServerPort *connection(int i) const { return m_connections.at(i); }
     
 public:
     inline QTcpServer* server() const { return m_server; }
     inline quint16 port() const { return m_tcpPort; }
     inline void setPort(quint16 port) { m_tcpPort = port; }
-    inline int timeout() const { return m_timeout; }
-    inline void setTimeout(int timeout) { m_timeout = timeout; }
+    // timeout in milliseconds
+    inline int timeout() const { return static_cast<int>(m_timeout / 1000); }
+    inline void setTimeout(int timeout) { m_timeout = timeoutMsToUs(timeout); }
+    // timeout in microseconds
+    inline uint32_t timeoutUs() const { return m_timeout; }
+    inline void setTimeoutUs(uint32_t timeout) { m_timeout = timeout; }
+    inline bool isEventDriven() const { return m_eventDriven; }
+    inline void setEventDriven(bool eventDriven) { m_eventDriven = eventDriven; }
+
+private:
+    void processAllConnections();
+    void processReadyConnections();
+    void deleteConnection(ServerPort *c);
+    void setReady(ServerPort *c);
 
 private:
     typedef QList<ServerPort*> Connections_t;
+    // Note: vectors keep its capacity, so ready connections are tracked without heap allocations
+    typedef QVector<ServerPort*> ReadyConnections_t;
+
+    // period (milliseconds) to check up idle connections (e.g. for read timeout) in event driven mode
+    static const int IdleSweepPeriod = 100;
 
     QTcpServer* m_server;
     quint16 m_tcpPort;
-    int m_timeout;
+    uint32_t m_timeout; // microseconds
+    bool m_eventDriven;
     Connections_t m_connections;
-    qint64 m_timestamp;
+    ReadyConnections_t m_ready;
+    ReadyConnections_t m_processing;
+    qint64 m_timestamp;      // monotonic, nanoseconds
+    qint64 m_timestampSweep; // monotonic, nanoseconds
+    Statistics m_closedStats;
 };
 
 } // namespace Modbus
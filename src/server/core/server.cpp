@@ -53,6 +53,7 @@ mbServer::mbServer() :
     mbCore(Strings::instance().settings_application)
 {
     Strings s = Strings::instance();
+    m_statsPeriod = 0;
 }
 
 mbServer::~mbServer()
@@ -87,8 +88,22 @@ mbCoreBuilder *mbServer::createBuilder()
     return new mbServerBuilder;
 }
 
+int mbServer::parseArg(int argc, char **argv, int &arg)
+{
+    // '-stats <seconds>': dump runtime statistics to the log periodically (e.g. for console mode)
+    if (!qstrcmp(argv[arg], "-stats"))
+    {
+        if (++arg < argc)
+            m_statsPeriod = QString(argv[arg]).toInt();
+        return 0;
+    }
+    return mbCore::parseArg(argc, argv, arg);
+}
+
 mbCoreRuntime *mbServer::createRuntime()
 {
-    return new mbServerRuntime(this);
+    mbServerRuntime *runtime = new mbServerRuntime(this);
+    runtime->setStatsPeriod(m_statsPeriod);
+    return runtime;
 }
 
@@ -66,12 +66,18 @@ public:
     inline mbServerRuntime* runtime() const { return reinterpret_cast<mbServerRuntime*>(coreRuntime()); }
     inline void setProject(mbServerProject* project) { setProjectCore(reinterpret_cast<mbCoreProject*>(project)); }
 
+protected:
+    int parseArg(int argc, char **argv, int &arg) override;
+
 private:
     QString createGUID();
     mbCoreUi* createUi();
     mbCoreProject* createProject();
     mbCoreBuilder* createBuilder();
     mbCoreRuntime *createRuntime();
+
+private:
+    int m_statsPeriod; // seconds, 0 - statistics is not dumped periodically
 };
 
 #endif // SERVER_H
@@ -149,6 +149,13 @@ mbServerDialogPort::mbServerDialogPort(QWidget *parent) :
     sp->setMinimum(0);
     sp->setMaximum(INT_MAX);
     sp->setValue(td.timeout);
+    // Event driven
+    ui->chbEventDriven->setChecked(d.eventDriven);
+    // Workers
+    sp = ui->spWorkerCount;
+    sp->setMinimum(1);
+    sp->setMaximum(256);
+    sp->setValue(d.workerCount);
     connect(ui->buttonBox, SIGNAL(accepted()), this, SLOT(accept()));
     connect(ui->buttonBox, SIGNAL(rejected()), this, SLOT(reject()));
 }
@@ -196,6 +203,8 @@ void mbServerDialogPort::fillForm(const Modbus::Settings &m)
     //--------------------- TCP ---------------------
     ui->spPort   ->setValue(m.value(ts.port   ).toInt());
     ui->spTimeout->setValue(m.value(ts.timeout).toInt());
+    ui->chbEventDriven->setChecked(m.value(ms.eventDriven).toBool());
+    ui->spWorkerCount->setValue(m.value(ms.workerCount).toInt());
 }
 
 void mbServerDialogPort::fillData(Modbus::Settings &m)
@@ -218,6 +227,8 @@ void mbServerDialogPort::fillData(Modbus::Settings &m)
     //--------------------- TCP ---------------------
     m[ts.port   ] = ui->spPort   ->value();
     m[ts.timeout] = ui->spTimeout->value();
+    m[ms.eventDriven] = ui->chbEventDriven->isChecked();
+    m[ms.workerCount] = ui->spWorkerCount->value();
 }
 
 void mbServerDialogPort::setType(int type)
@@ -29,6 +29,7 @@
 */
 
 #include <QSet>
+#include <QThread>
 
 mbServerDevice::Strings::Strings() :
     count0x                  (QStringLiteral("count0x")),
@@ -72,45 +73,123 @@ const mbServerDevice::Defaults &mbServerDevice::Defaults::instance()
 
 mbServerDevice::MemoryBlock::MemoryBlock()
 {
-    m_sizeBits = 0;
-    m_changeCounter = 0;
+    Data *d = new Data;
+    d->sizeBits = 0;
+    m_data.store(d, std::memory_order_release);
+    m_seq.store(0, std::memory_order_relaxed);
+    m_changeCounter.store(0, std::memory_order_relaxed);
+    m_readers.store(0, std::memory_order_relaxed);
+}
+
+mbServerDevice::MemoryBlock::~MemoryBlock()
+{
+    qDeleteAll(m_retired);
+    delete m_data.load(std::memory_order_relaxed);
+}
+
+int mbServerDevice::MemoryBlock::size() const
+{
+    ReadGuard _(this);
+    return m_data.load()->bytes.size();
+}
+
+int mbServerDevice::MemoryBlock::sizeBits() const
+{
+    ReadGuard _(this);
+    return static_cast<int>(m_data.load()->sizeBits);
 }
 
 void mbServerDevice::MemoryBlock::resize(int bytes)
 {
-    QWriteLocker _(&m_lock);
-    m_data.resize(bytes);
-    memset(m_data.data(), 0, m_data.size());
-    m_sizeBits = m_data.size() * MB_BYTE_SZ_BITES;
+    Data *d = new Data;
+    d->bytes.resize(bytes);
+    memset(d->bytes.data(), 0, d->bytes.size());
+    d->sizeBits = d->bytes.size() * MB_BYTE_SZ_BITES;
+    replaceData(d);
 }
 
 void mbServerDevice::MemoryBlock::resizeBits(int bits)
 {
-    QWriteLocker _(&m_lock);
-    m_data.resize((bits+7)/8);
-    memset(m_data.data(), 0, m_data.size());
-    m_sizeBits = bits;
+    Data *d = new Data;
+    d->bytes.resize((bits+7)/8);
+    memset(d->bytes.data(), 0, d->bytes.size());
+    d->sizeBits = bits;
+    replaceData(d);
+}
+
+void mbServerDevice::MemoryBlock::replaceData(Data *d)
+{
+    QMutexLocker _(&m_writeLock);
+    beginWrite();
+    // Note: previous data can't be freed now because it can be still used by concurrent reader
+    m_retired.append(m_data.load(std::memory_order_relaxed));
+    m_data.store(d);
+    endWrite();
+    // Note: reader registers itself before it loads the data, so when there is no reader at this point
+    // (grace period) nobody can use retired data anymore, otherwise it's freed by the next replacement
+    if (m_readers.load() == 0)
+    {
+        qDeleteAll(m_retired);
+        m_retired.clear();
+    }
+}
+
+uint mbServerDevice::MemoryBlock::beginRead() const
+{
+    uint seq = m_seq.load(std::memory_order_acquire);
+    while (seq & 1) // writer is in progress
+    {
+        QThread::yieldCurrentThread();
+        seq = m_seq.load(std::memory_order_acquire);
+    }
+    return seq;
+}
+
+bool mbServerDevice::MemoryBlock::endRead(uint seq) const
+{
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return m_seq.load(std::memory_order_relaxed) == seq;
+}
+
+void mbServerDevice::MemoryBlock::beginWrite()
+{
+    m_seq.store(m_seq.load(std::memory_order_relaxed)+1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void mbServerDevice::MemoryBlock::endWrite()
+{
+    m_seq.store(m_seq.load(std::memory_order_relaxed)+1, std::memory_order_release);
 }
 
 void mbServerDevice::MemoryBlock::zerroAll()
 {
-    QWriteLocker _(&m_lock);
-    m_changeCounter++;
-    memset(m_data.data(), 0, m_data.size());
+    QMutexLocker _(&m_writeLock);
+    QByteArray &data = m_data.load(std::memory_order_relaxed)->bytes;
+    beginWrite();
+    memset(data.data(), 0, data.size());
+    endWrite();
+    m_changeCounter.fetch_add(1, std::memory_order_release);
 }
 
 Modbus::StatusCode mbServerDevice::MemoryBlock::read(uint offset, uint count, void *buff, uint *fact) const
 {
-    QReadLocker _(&m_lock);
-    uint c;
-    if (offset >= static_cast<uint>(static_cast<uint>(m_data.size())))
-        return Modbus::Status_BadIllegalDataAddress;
-
-    if ((offset+count) > static_cast<uint>(m_data.size()))
-        c = static_cast<uint>(static_cast<uint>(m_data.size())) - offset;
-    else
-        c = count;
-    memcpy(buff, m_data.data()+offset, c);
+    ReadGuard _(this);
+    uint seq, c;
+    do
+    {
+        seq = beginRead();
+        const QByteArray &data = m_data.load()->bytes;
+        if (offset >= static_cast<uint>(data.size()))
+            return Modbus::Status_BadIllegalDataAddress;
+
+        if ((offset+count) > static_cast<uint>(data.size()))
+            c = static_cast<uint>(data.size()) - offset;
+        else
+            c = count;
+        memcpy(buff, data.constData()+offset, c);
+    }
+    while (!endRead(seq));
     if (fact)
         *fact = c;
     return Modbus::Status_Good;
@@ -118,19 +197,22 @@ Modbus::StatusCode mbServerDevice::MemoryBlock::read(uint offset, uint count, vo
 
 Modbus::StatusCode mbServerDevice::MemoryBlock::write(uint offset, uint count, const void *buff, uint *fact)
 {
-    QWriteLocker _(&m_lock);
+    QMutexLocker _(&m_writeLock);
+    QByteArray &data = m_data.load(std::memory_order_relaxed)->bytes;
     uint c;
-    if (offset >= static_cast<uint>(m_data.size()))
+    if (offset >= static_cast<uint>(data.size()))
         return Modbus::Status_BadIllegalDataAddress;
 
-    if ((offset+count) > static_cast<uint>(m_data.size()))
-        c = static_cast<uint>(m_data.size()) - offset;
+    if ((offset+count) > static_cast<uint>(data.size()))
+        c = static_cast<uint>(data.size()) - offset;
     else
         c = count;
     if (c == 0)
         return Modbus::Status_BadIllegalDataAddress;
-    memcpy(m_data.data()+offset, buff, c);
-    m_changeCounter++;
+    beginWrite();
+    memcpy(data.data()+offset, buff, c);
+    endWrite();
+    m_changeCounter.fetch_add(1, std::memory_order_release);
     if (fact)
         *fact = c;
     return Modbus::Status_Good;
@@ -138,50 +220,56 @@ Modbus::StatusCode mbServerDevice::MemoryBlock::write(uint offset, uint count, c
 
 Modbus::StatusCode mbServerDevice::MemoryBlock::readBits(uint bitOffset, uint bitCount, void *buff, uint *fact) const
 {
-    QReadLocker _(&m_lock);
-    uint c;
-    if (bitOffset >= m_sizeBits)
-        return Modbus::Status_BadIllegalDataAddress;
-
-    if ((bitOffset+bitCount) > m_sizeBits)
-        c = m_sizeBits - bitOffset;
-    else
-        c = bitCount;
-
-    uint byteOffset = bitOffset/MB_BYTE_SZ_BITES;
-    uint bytes = c/MB_BYTE_SZ_BITES;
-    uint shift = bitOffset%MB_BYTE_SZ_BITES;
-    const quint8 *mem = reinterpret_cast<const quint8*>(m_data.data());
-    if (shift)
+    ReadGuard _(this);
+    uint seq, c;
+    do
     {
-        for (uint i = 0; i < bytes; i++)
+        seq = beginRead();
+        const Data *d = m_data.load();
+        if (bitOffset >= d->sizeBits)
+            return Modbus::Status_BadIllegalDataAddress;
+
+        if ((bitOffset+bitCount) > d->sizeBits)
+            c = d->sizeBits - bitOffset;
+        else
+            c = bitCount;
+
+        uint byteOffset = bitOffset/MB_BYTE_SZ_BITES;
+        uint bytes = c/MB_BYTE_SZ_BITES;
+        uint shift = bitOffset%MB_BYTE_SZ_BITES;
+        const quint8 *mem = reinterpret_cast<const quint8*>(d->bytes.constData());
+        if (shift)
         {
-            quint16 v = *(reinterpret_cast<const quint16*>(mem[byteOffset+i])) >> shift;
-            reinterpret_cast<quint8*>(buff)[i] = static_cast<quint8>(v);
-        }
-        if (quint16 resid = c%MB_BYTE_SZ_BITES)
-        {
-            qint8 mask = static_cast<qint8>(0x80);
-            mask = ~(mask>>(7-resid));
-            if ((shift+resid) > MB_BYTE_SZ_BITES)
+            for (uint i = 0; i < bytes; i++)
             {
-                quint16 v = ((*reinterpret_cast<const quint16*>(&reinterpret_cast<const quint8*>(mem)[byteOffset+bytes])) >> shift) & mask;
-                reinterpret_cast<quint8*>(buff)[bytes] = static_cast<quint8>(v);
+                quint16 v = *(reinterpret_cast<const quint16*>(&mem[byteOffset+i])) >> shift;
+                reinterpret_cast<quint8*>(buff)[i] = static_cast<quint8>(v);
+            }
+            if (quint16 resid = c%MB_BYTE_SZ_BITES)
+            {
+                qint8 mask = static_cast<qint8>(0x80);
+                mask = ~(mask>>(7-resid));
+                if ((shift+resid) > MB_BYTE_SZ_BITES)
+                {
+                    quint16 v = ((*reinterpret_cast<const quint16*>(&reinterpret_cast<const quint8*>(mem)[byteOffset+bytes])) >> shift) & mask;
+                    reinterpret_cast<quint8*>(buff)[bytes] = static_cast<quint8>(v);
+                }
+                else
+                    reinterpret_cast<quint8*>(buff)[bytes] = (reinterpret_cast<const quint8*>(mem)[byteOffset+bytes]>>shift) & mask;
             }
-            else
-                reinterpret_cast<quint8*>(buff)[bytes] = (reinterpret_cast<const quint8*>(mem)[byteOffset+bytes]>>shift) & mask;
         }
-    }
-    else
-    {
-        memcpy(buff, &reinterpret_cast<const quint8*>(mem)[byteOffset], static_cast<size_t>(bytes));
-        if (quint16 resid = c%MB_BYTE_SZ_BITES)
+        else
         {
-            qint8 mask = static_cast<qint8>(0x80);
-            mask = ~(mask>>(7-resid));
-            reinterpret_cast<quint8*>(buff)[bytes] = reinterpret_cast<const quint8*>(mem)[byteOffset+bytes] & mask;
+            memcpy(buff, &reinterpret_cast<const quint8*>(mem)[byteOffset], static_cast<size_t>(bytes));
+            if (quint16 resid = c%MB_BYTE_SZ_BITES)
+            {
+                qint8 mask = static_cast<qint8>(0x80);
+                mask = ~(mask>>(7-resid));
+                reinterpret_cast<quint8*>(buff)[bytes] = reinterpret_cast<const quint8*>(mem)[byteOffset+bytes] & mask;
+            }
         }
     }
+    while (!endRead(seq));
     if (fact)
         *fact = c;
     return Modbus::Status_Good;
@@ -189,13 +277,14 @@ Modbus::StatusCode mbServerDevice::MemoryBlock::readBits(uint bitOffset, uint bi
 
 Modbus::StatusCode mbServerDevice::MemoryBlock::writeBits(uint bitOffset, uint bitCount, const void *buff, uint *fact)
 {
-    QWriteLocker _(&m_lock);
+    QMutexLocker _(&m_writeLock);
+    Data *d = m_data.load(std::memory_order_relaxed);
     uint c;
-    if (bitOffset >= m_sizeBits)
+    if (bitOffset >= d->sizeBits)
         return Modbus::Status_BadIllegalDataAddress;
 
-    if ((bitOffset+bitCount) > m_sizeBits)
-        c = m_sizeBits - bitOffset;
+    if ((bitOffset+bitCount) > d->sizeBits)
+        c = d->sizeBits - bitOffset;
     else
         c = bitCount;
     if (c == 0)
@@ -203,7 +292,8 @@ Modbus::StatusCode mbServerDevice::MemoryBlock::writeBits(uint bitOffset, uint b
     uint byteOffset = bitOffset/MB_BYTE_SZ_BITES;
     uint bytes = c/MB_BYTE_SZ_BITES;
     uint shift = bitOffset%MB_BYTE_SZ_BITES;
-    quint8 *mem = reinterpret_cast<quint8*>(m_data.data());
+    quint8 *mem = reinterpret_cast<quint8*>(d->bytes.data());
+    beginWrite();
     if (shift)
     {
         for (uint i = 0; i < bytes; i++)
@@ -249,7 +339,8 @@ Modbus::StatusCode mbServerDevice::MemoryBlock::writeBits(uint bitOffset, uint b
             reinterpret_cast<quint8*>(mem)[byteOffset+bytes] |= (reinterpret_cast<const quint8*>(buff)[bytes] & mask);
         }
     }
-    m_changeCounter++;
+    endWrite();
+    m_changeCounter.fetch_add(1, std::memory_order_release);
     if (fact)
         *fact = c;
     return Modbus::Status_Good;
@@ -257,24 +348,30 @@ Modbus::StatusCode mbServerDevice::MemoryBlock::writeBits(uint bitOffset, uint b
 
 Modbus::StatusCode mbServerDevice::MemoryBlock::readBools(uint bitOffset, uint bitCount, bool *values, uint *fact) const
 {
-    QReadLocker _(&m_lock);
-    uint c;
-    if (bitOffset >= m_sizeBits)
-        return Modbus::Status_BadIllegalDataAddress;
-
-    if ((bitOffset+bitCount) > m_sizeBits)
-        c = m_sizeBits - bitOffset;
-    else
-        c = bitCount;
-    uint byte = bitOffset / MB_BYTE_SZ_BITES;
-    uint bit  = bitOffset % MB_BYTE_SZ_BITES;
-    const quint8 *mem = reinterpret_cast<const quint8*>(m_data.data());
-    for (uint by = byte, i = 0; i < c; by++)
+    ReadGuard _(this);
+    uint seq, c;
+    do
     {
-        for (uint bi = bit; bi < MB_BYTE_SZ_BITES && i < c; bi++, i++)
-            values[i] = (mem[by] & (1<<bi)) != 0;
-        bit = 0;
+        seq = beginRead();
+        const Data *d = m_data.load();
+        if (bitOffset >= d->sizeBits)
+            return Modbus::Status_BadIllegalDataAddress;
+
+        if ((bitOffset+bitCount) > d->sizeBits)
+            c = d->sizeBits - bitOffset;
+        else
+            c = bitCount;
+        uint byte = bitOffset / MB_BYTE_SZ_BITES;
+        uint bit  = bitOffset % MB_BYTE_SZ_BITES;
+        const quint8 *mem = reinterpret_cast<const quint8*>(d->bytes.constData());
+        for (uint by = byte, i = 0; i < c; by++)
+        {
+            for (uint bi = bit; bi < MB_BYTE_SZ_BITES && i < c; bi++, i++)
+                values[i] = (mem[by] & (1<<bi)) != 0;
+            bit = 0;
+        }
     }
+    while (!endRead(seq));
     if (fact)
         *fact = c;
     return Modbus::Status_Good;
@@ -282,18 +379,20 @@ Modbus::StatusCode mbServerDevice::MemoryBlock::readBools(uint bitOffset, uint b
 
 Modbus::StatusCode mbServerDevice::MemoryBlock::writeBools(uint bitOffset, uint bitCount, const bool *values, uint *fact)
 {
-    QWriteLocker _(&m_lock);
+    QMutexLocker _(&m_writeLock);
+    Data *d = m_data.load(std::memory_order_relaxed);
     uint c;
-    if (bitOffset >= m_sizeBits)
+    if (bitOffset >= d->sizeBits)
         return Modbus::Status_BadIllegalDataAddress;
 
-    if ((bitOffset+bitCount) > m_sizeBits)
-        c = m_sizeBits - bitOffset;
+    if ((bitOffset+bitCount) > d->sizeBits)
+        c = d->sizeBits - bitOffset;
     else
         c = bitCount;
     uint byte = bitOffset / MB_BYTE_SZ_BITES;
     uint bit  = bitOffset % MB_BYTE_SZ_BITES;
-    quint8 *mem = reinterpret_cast<quint8*>(m_data.data());
+    quint8 *mem = reinterpret_cast<quint8*>(d->bytes.data());
+    beginWrite();
     for (uint by = byte, i = 0; i < c; by++)
     {
         for (uint bi = bit; bi < MB_BYTE_SZ_BITES && i < c; bi++, i++)
@@ -305,7 +404,8 @@ Modbus::StatusCode mbServerDevice::MemoryBlock::writeBools(uint bitOffset, uint
         }
         bit = 0;
     }
-    m_changeCounter++;
+    endWrite();
+    m_changeCounter.fetch_add(1, std::memory_order_release);
     if (fact)
         *fact = c;
     return Modbus::Status_Good;
@@ -424,18 +524,19 @@ mbServerDevice::mbServerDevice(QObject * /*parent*/)
     this->realloc_4x(d.count4x);
     setExceptionStatusAddressInt(d.exceptionStatusAddress);
     setReadOnly(d.isReadOnly);
-    m_settings.isSaveData = d.isSaveData;
-    m_settings.delay = d.delay;
+    setSaveData(d.isSaveData);
+    setDelay(d.delay);
 }
 
 quint8 mbServerDevice::exceptionStatus() const
 {
-    switch (m_settings.exceptionStatusAddress.type)
+    const mb::Address address = exceptionStatusAddress();
+    switch (address.type)
     {
-    case Modbus::Memory_0x: return uint8_0x(m_settings.exceptionStatusAddress.offset);
-    case Modbus::Memory_1x: return uint8_1x(m_settings.exceptionStatusAddress.offset);
-    case Modbus::Memory_3x: return uint8_3x(m_settings.exceptionStatusAddress.offset*MB_REGE_SZ_BYTES);
-    case Modbus::Memory_4x: return uint8_4x(m_settings.exceptionStatusAddress.offset*MB_REGE_SZ_BYTES);
+    case Modbus::Memory_0x: return uint8_0x(address.offset);
+    case Modbus::Memory_1x: return uint8_1x(address.offset);
+    case Modbus::Memory_3x: return uint8_3x(address.offset*MB_REGE_SZ_BYTES);
+    case Modbus::Memory_4x: return uint8_4x(address.offset*MB_REGE_SZ_BYTES);
     }
     return 0;
 }
@@ -598,47 +699,54 @@ void mbServerDevice::writeData(const mb::Address &address, quint16 count, const
 
 Modbus::StatusCode mbServerDevice::readCoils(uint16_t offset, uint16_t count, void *values)
 {
-    QReadLocker _(&m_lock);
     if (count > maxReadCoils())
         return Modbus::Status_BadIllegalDataAddress;
-    if ((offset+count) > this->count_0x())
+    // Note: bounds are checked up by memory block within the same snapshot
+    uint fact = 0;
+    Modbus::StatusCode r = this->read_0x(offset, count, values, &fact);
+    if (Modbus::StatusIsGood(r) && (fact != count))
         return Modbus::Status_BadIllegalDataAddress;
-    return this->read_0x(offset, count, values);
+    return r;
 }
 
 Modbus::StatusCode mbServerDevice::readDiscreteInputs(uint16_t offset, uint16_t count, void *values)
 {
-    QReadLocker _(&m_lock);
     if (count > maxReadDiscreteInputs())
         return Modbus::Status_BadIllegalDataAddress;
-    if ((offset+count) > this->count_1x())
+    // Note: bounds are checked up by memory block within the same snapshot
+    uint fact = 0;
+    Modbus::StatusCode r = this->read_1x(offset, count, values, &fact);
+    if (Modbus::StatusIsGood(r) && (fact != count))
         return Modbus::Status_BadIllegalDataAddress;
-    return this->read_1x(offset, count, values);
+    return r;
 }
 
 Modbus::StatusCode mbServerDevice::readHoldingRegisters(uint16_t offset, uint16_t count, uint16_t *values)
 {
-    QReadLocker _(&m_lock);
     if (count > maxReadHoldingRegisters())
         return Modbus::Status_BadIllegalDataAddress;
-    if ((offset+count) > this->count_4x())
+    // Note: bounds are checked up by memory block within the same snapshot
+    uint fact = 0;
+    Modbus::StatusCode r = this->read_4x(offset, count, values, &fact);
+    if (Modbus::StatusIsGood(r) && (fact != count))
         return Modbus::Status_BadIllegalDataAddress;
-    return this->read_4x(offset, count, values);
+    return r;
 }
 
 Modbus::StatusCode mbServerDevice::readInputRegisters(uint16_t offset, uint16_t count, uint16_t *values)
 {
-    QReadLocker _(&m_lock);
     if (count > maxReadInputRegisters())
         return Modbus::Status_BadIllegalDataAddress;
-    if ((offset+count) > this->count_3x())
+    // Note: bounds are checked up by memory block within the same snapshot
+    uint fact = 0;
+    Modbus::StatusCode r = this->read_3x(offset, count, values, &fact);
+    if (Modbus::StatusIsGood(r) && (fact != count))
         return Modbus::Status_BadIllegalDataAddress;
-    return this->read_3x(offset, count, values);
+    return r;
 }
 
 Modbus::StatusCode mbServerDevice::writeSingleCoil(uint16_t offset, bool value)
 {
-    QReadLocker _(&m_lock);
     if (isReadOnly())
         return Modbus::Status_BadIllegalFunction;
     if (offset >= this->count_0x())
@@ -649,7 +757,6 @@ Modbus::StatusCode mbServerDevice::writeSingleCoil(uint16_t offset, bool value)
 
 Modbus::StatusCode mbServerDevice::writeSingleRegister(uint16_t offset, uint16_t value)
 {
-    QReadLocker _(&m_lock);
     if (isReadOnly())
         return Modbus::Status_BadIllegalFunction;
     if (offset >= this->count_4x())
@@ -660,14 +767,12 @@ Modbus::StatusCode mbServerDevice::writeSingleRegister(uint16_t offset, uint16_t
 
 Modbus::StatusCode mbServerDevice::readExceptionStatus(uint8_t *status)
 {
-    QReadLocker _(&m_lock);
     *status = this->exceptionStatus();
     return Modbus::Status_Good;
 }
 
 Modbus::StatusCode mbServerDevice::writeMultipleCoils(uint16_t offset, uint16_t count, const void *values)
 {
-    QReadLocker _(&m_lock);
     if (isReadOnly())
         return Modbus::Status_BadIllegalFunction;
     if (count > maxWriteMultipleCoils())
@@ -679,7 +784,6 @@ Modbus::StatusCode mbServerDevice::writeMultipleCoils(uint16_t offset, uint16_t
 
 Modbus::StatusCode mbServerDevice::writeMultipleRegisters(uint16_t offset, uint16_t count, const uint16_t *values)
 {
-    QReadLocker _(&m_lock);
     if (isReadOnly())
         return Modbus::Status_BadIllegalFunction;
     if (count > maxWriteMultipleRegisters())
@@ -23,7 +23,10 @@
 #ifndef SERVER_DEVICE_H
 #define SERVER_DEVICE_H
 
+#include <atomic>
+
 #include <QReadWriteLock>
+#include <QMutex>
 
 #include <project/core_device.h>
 
@@ -67,23 +70,27 @@ public:
         static const Defaults &instance();
     };
 
+    // Readers never lock: data is protected by sequence counter (seqlock) and reader repeats
+    // its copy if writer changed memory during it, so every read is consistent snapshot.
+    // Writers are serialized by mutex.
     class MemoryBlock
     {
     public:
         MemoryBlock();
+        ~MemoryBlock();
 
     public:
-        inline int size() const { QReadLocker _(&m_lock); return m_data.size(); }
-        inline int sizeBits() const { QReadLocker _(&m_lock); return m_sizeBits; }
+        int size() const;
+        int sizeBits() const;
         inline int sizeBytes() const { return size(); }
-        inline int sizeRegs() const { QReadLocker _(&m_lock); return m_data.size() / MB_REGE_SZ_BYTES; }
+        inline int sizeRegs() const { return size() / MB_REGE_SZ_BYTES; }
         void resize(int bytes);
         void resizeBits(int bits);
         inline void resizeBytes(int bytes) { resize(bytes); }
         inline void resizeRegs(int regs) { resize(regs*MB_REGE_SZ_BYTES); }
 
     public:
-        inline uint changeCounter() const { QReadLocker _(&m_lock); return m_changeCounter; }
+        inline uint changeCounter() const { return m_changeCounter.load(std::memory_order_acquire); }
         void zerroAll();
         Modbus::StatusCode read(uint offset, uint count, void *values, uint *fact = nullptr) const;
         Modbus::StatusCode write(uint offset, uint count, const void *values, uint *fact = nullptr);
@@ -99,10 +106,37 @@ public:
         Modbus::StatusCode writeFrameRegs(uint regOffset, int columns, const QByteArray &values, int maxColumns);
 
     private:
-        mutable QReadWriteLock m_lock;
-        QByteArray m_data;
-        uint m_sizeBits;
-        uint m_changeCounter;
+        // Note: memory is never resized in place, 'resize()' replaces whole data
+        struct Data
+        {
+            QByteArray bytes;
+            uint sizeBits;
+        };
+
+        // Note: retired data is freed by writer only when there are no readers, so reader
+        // which holds the guard can use any data it has loaded
+        struct ReadGuard
+        {
+            inline explicit ReadGuard(const MemoryBlock *b) : block(b) { block->m_readers.fetch_add(1); }
+            inline ~ReadGuard() { block->m_readers.fetch_sub(1, std::memory_order_release); }
+            const MemoryBlock *block;
+        };
+
+    private:
+        Q_DISABLE_COPY(MemoryBlock)
+        void replaceData(Data *d);
+        uint beginRead() const;
+        bool endRead(uint seq) const;
+        void beginWrite();
+        void endWrite();
+
+    private:
+        std::atomic<Data*> m_data;
+        std::atomic<uint> m_seq;
+        std::atomic<uint> m_changeCounter;
+        mutable std::atomic<int> m_readers;
+        QMutex m_writeLock;
+        QList<Data*> m_retired;
     };
 
 public:
@@ -113,10 +147,10 @@ public:
     inline void setProject(mbServerProject* project) { mbCoreDevice::setProjectCore(reinterpret_cast<mbCoreProject*>(project)); }
 
 public: // Exception Status
-    inline mb::Address exceptionStatusAddress() const { return m_settings.exceptionStatusAddress; }
-    inline int exceptionStatusAddressInt() const { return mb::toInt(exceptionStatusAddress()); }
+    inline mb::Address exceptionStatusAddress() const { return mb::toAddress(exceptionStatusAddressInt()); }
+    inline int exceptionStatusAddressInt() const { return m_settings.exceptionStatusAddress.load(std::memory_order_relaxed); }
     inline QString exceptionStatusAddressStr() const { return mb::toString(exceptionStatusAddress()); }
-    inline void setExceptionStatusAddress(mb::Address exceptionStatusAddress) { m_settings.exceptionStatusAddress = exceptionStatusAddress; }
+    inline void setExceptionStatusAddress(mb::Address exceptionStatusAddress) { m_settings.exceptionStatusAddress.store(mb::toInt(exceptionStatusAddress), std::memory_order_relaxed); }
     inline void setExceptionStatusAddressInt(int address) { setExceptionStatusAddress(mb::toAddress(address)); }
     inline void setExceptionStatusAddressStr(const QString& address) { setExceptionStatusAddress(mb::toAddress(address)); }
     inline void setExceptionStatusAddress(int address) { setExceptionStatusAddressInt(address); }
@@ -125,12 +159,12 @@ public: // Exception Status
 
 
 public: // settings
-    inline bool isReadOnly() const { return m_settings.isReadOnly; }
-    inline void setReadOnly(bool v) { m_settings.isReadOnly = v; }
-    inline bool isSaveData() const { return m_settings.isSaveData; }
-    inline void setSaveData(bool save) { m_settings.isSaveData = save; }
-    inline uint delay() const { return m_settings.delay; }
-    inline void setDelay(uint delay) { m_settings.delay = delay; }
+    inline bool isReadOnly() const { return m_settings.isReadOnly.load(std::memory_order_relaxed); }
+    inline void setReadOnly(bool v) { m_settings.isReadOnly.store(v, std::memory_order_relaxed); }
+    inline bool isSaveData() const { return m_settings.isSaveData.load(std::memory_order_relaxed); }
+    inline void setSaveData(bool save) { m_settings.isSaveData.store(save, std::memory_order_relaxed); }
+    inline uint delay() const { return m_settings.delay.load(std::memory_order_relaxed); }
+    inline void setDelay(uint delay) { m_settings.delay.store(delay, std::memory_order_relaxed); }
 
     Modbus::Settings settings() const;
     bool setSettings(const Modbus::Settings& settings);
@@ -336,12 +370,13 @@ private: // Memory
     MemoryBlock m_mem_4x;
 
 private: // settings
+    // Note: settings are read by the port threads while GUI can change them, so every field is atomic
     struct
     {
-        bool        isSaveData            ;
-        bool        isReadOnly            ;
-        mb::Address exceptionStatusAddress;
-        uint        delay                 ;
+        std::atomic<bool> isSaveData            ;
+        std::atomic<bool> isReadOnly            ;
+        std::atomic<int>  exceptionStatusAddress; // 'mb::toInt()' of the address
+        std::atomic<uint> delay                 ;
     } m_settings;
 };
 
@@ -26,6 +26,7 @@
 
 #include <ModbusPortTCP.h>
 #include <ModbusPortSerial.h>
+#include <ModbusServerTCP.h>
 #include <server.h>
 
 #include "server_deviceref.h"
@@ -33,16 +34,84 @@
 #define MAX_DISCRETS 1600
 #define MAX_REGISTERS 100
 
+mbServerPort::Strings::Strings() :
+    mbCorePort::Strings(),
+    eventDriven(Modbus::ServerTCP::Strings::instance().eventDriven),
+    workerCount(QStringLiteral("workerCount"))
+{
+}
+
+const mbServerPort::Strings &mbServerPort::Strings::instance()
+{
+    static const Strings s;
+    return s;
+}
+
+mbServerPort::Defaults::Defaults() :
+    mbCorePort::Defaults(),
+    eventDriven(Modbus::ServerTCP::Defaults::instance().eventDriven),
+    workerCount(1)
+{
+}
+
+const mbServerPort::Defaults &mbServerPort::Defaults::instance()
+{
+    static const Defaults d;
+    return d;
+}
+
 mbServerPort::mbServerPort(QObject *parent) :
     mbCorePort(parent)
 {
     memset(m_units, 0, sizeof(m_units));
+    m_settingsServer.eventDriven = Defaults::instance().eventDriven;
+    m_settingsServer.workerCount = Defaults::instance().workerCount;
 }
 
 mbServerPort::~mbServerPort()
 {
 }
 
+MBSETTINGS mbServerPort::settings() const
+{
+    const Strings &s = Strings::instance();
+
+    MBSETTINGS r = mbCorePort::settings();
+    r.insert(s.eventDriven, isEventDriven());
+    r.insert(s.workerCount, workerCount());
+    return r;
+}
+
+bool mbServerPort::setSettings(const MBSETTINGS &settings)
+{
+    const Strings &s = Strings::instance();
+
+    MBSETTINGS::const_iterator it;
+    MBSETTINGS::const_iterator end = settings.end();
+
+    it = settings.find(s.eventDriven);
+    if (it != end)
+    {
+        QVariant var = it.value();
+        setEventDriven(var.toBool());
+    }
+
+    it = settings.find(s.workerCount);
+    if (it != end)
+    {
+        QVariant var = it.value();
+        setWorkerCount(var.toInt());
+    }
+
+    return mbCorePort::setSettings(settings);
+}
+
+void mbServerPort::setWorkerCount(int workerCount)
+{
+    if (workerCount > 0)
+        m_settingsServer.workerCount = workerCount;
+}
+
 int mbServerPort::freeDeviceUnit() const
 {
     for (int i = 1; i < 255; i++)
@@ -38,6 +38,25 @@ class mbServerPort : public mbCorePort
 {
     Q_OBJECT
 
+public:
+    struct Strings : public mbCorePort::Strings
+    {
+        const QString eventDriven;
+        const QString workerCount;
+
+        Strings();
+        static const Strings &instance();
+    };
+
+    struct Defaults : public mbCorePort::Defaults
+    {
+        const bool eventDriven;
+        const int workerCount;
+
+        Defaults();
+        static const Defaults &instance();
+    };
+
 public:
     explicit mbServerPort(QObject* parent = nullptr);
     virtual ~mbServerPort();
@@ -46,6 +65,16 @@ public:
     inline mbServerProject* project() const { return reinterpret_cast<mbServerProject*>(mbCorePort::projectCore()); }
     inline void setProject(mbServerProject* project) { mbCorePort::setProjectCore(reinterpret_cast<mbCoreProject*>(project)); }
 
+public: // tcp settings
+    inline bool isEventDriven() const { return m_settingsServer.eventDriven; }
+    inline void setEventDriven(bool eventDriven) { m_settingsServer.eventDriven = eventDriven; }
+    inline int workerCount() const { return m_settingsServer.workerCount; }
+    void setWorkerCount(int workerCount);
+
+public: // settings
+    MBSETTINGS settings() const override;
+    bool setSettings(const MBSETTINGS &settings) override;
+
 public: // devices
     int freeDeviceUnit() const;
     inline bool hasDevice(mbServerDeviceRef* device) const { return m_devices.contains(device); }
@@ -76,6 +105,13 @@ Q_SIGNALS:
 private:
     void deviceRemoveUnits(mbServerDeviceRef *device);
 
+private:
+    struct
+    {
+        bool eventDriven;
+        int workerCount;
+    } m_settingsServer;
+
 private: // devices
     static const int UnitsSize = 256;
     mbServerDeviceRef* m_units[UnitsSize];
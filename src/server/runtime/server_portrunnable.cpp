@@ -23,6 +23,7 @@
 #include "server_portrunnable.h"
 
 #include <ModbusServerPort.h>
+#include <ModbusServerTCP.h>
 
 #include <server.h>
 
@@ -30,12 +31,27 @@
 
 #include "server_rundevice.h"
 
-mbServerPortRunnable::mbServerPortRunnable(const Modbus::Settings &settings, mbServerRunDevice *device, QObject *parent)
+static void fillStatisticsRow(mbServerStats::Row &row, const Modbus::ServerPort::Statistics &s)
+{
+    row.requests    = s.requests   ;
+    row.errors      = s.errors     ;
+    row.ignored     = s.ignored    ;
+    row.responses   = s.responses  ;
+    row.exceptions  = s.exceptions ;
+    row.bytesIn     = s.bytesIn    ;
+    row.bytesOut    = s.bytesOut   ;
+    row.processTime = s.processTime;
+    row.discarded   = s.discarded  ;
+}
+
+mbServerPortRunnable::mbServerPortRunnable(const Modbus::Settings &settings, Modbus::ServerPort *port, QObject *parent)
     : QObject(parent)
 {
-    m_device = device;
-    m_port = Modbus::createServerPort(settings, device);
+    m_port = port;
+    m_device = nullptr;
+    m_stats = nullptr;
     // Note: m_port can NOT be nullptr
+    m_port->setTraceEnabled(false);
     if (m_port->type() == Modbus::ASC)
     {
         connect(m_port, &Modbus::ServerPort::signalTx, this, &mbServerPortRunnable::slotAsciiTx);
@@ -62,36 +78,140 @@ void mbServerPortRunnable::setName(const QString &name)
 {
     m_port->setName(name);
     setObjectName(name);
+    // Note: connections of the port are traced under the source of the port
+    m_traceSource = mbServer::TraceSource(name);
 }
 
 void mbServerPortRunnable::run()
 {
+    // Note: Port doesn't copy Tx/Rx bytes when trace is disabled
+    bool trace = mbServer::IsTraceTxRx();
+    if (m_port->isTraceEnabled() != trace)
+        m_port->setTraceEnabled(trace);
     m_port->process();
+    if (m_stats && m_statsTimer.elapsed() >= mbServerStats::SnapshotPeriod)
+        publishStatistics();
 }
 
 void mbServerPortRunnable::close()
 {
     m_port->close();
+    if (m_stats)
+        publishStatistics();
+}
+
+void mbServerPortRunnable::setStatistics(mbServerRunDevice *device, mbServerStats *stats)
+{
+    m_device = device;
+    m_stats = stats;
+    m_statsTimer.start();
+}
+
+void mbServerPortRunnable::publishStatistics()
+{
+    double elapsed = static_cast<double>(m_statsTimer.restart()) / 1000.0;
+    const QString name = this->name();
+    mbServerStats::Rows_t rows;
+    mbServerStats::Row row;
+
+    const Modbus::ServerPort::Statistics total = m_port->totalStatistics();
+    row.port = name;
+    fillStatisticsRow(row, total);
+    rows.append(row);
+    for (int func = 0; func < Modbus::ServerPort::FunctionCount; func++)
+    {
+        if (!total.functionRequests[func])
+            continue;
+        mbServerStats::Row r;
+        r.port = name;
+        r.function = func;
+        r.requests = total.functionRequests[func];
+        r.exceptions = total.functionExceptions[func];
+        rows.append(r);
+    }
+    if (m_device)
+    {
+        for (int unit = 0; unit <= 255; unit++)
+        {
+            const mbServerRunDevice::UnitStatistics &s = m_device->unitStatistics(static_cast<uint8_t>(unit));
+            if (!s.requests)
+                continue;
+            mbServerStats::Row r;
+            r.port = name;
+            r.unit = unit;
+            r.requests = s.requests;
+            r.responses = s.requests;
+            r.exceptions = s.exceptions;
+            r.processTime = s.processTime;
+            rows.append(r);
+        }
+    }
+    // Note: closed connections are counted within the port total only
+    if (m_port->type() == Modbus::TCP)
+    {
+        Modbus::ServerTCP *tcp = static_cast<Modbus::ServerTCP*>(m_port);
+        for (int i = 0; i < tcp->connectionCount(); i++)
+        {
+            Modbus::ServerPort *c = tcp->connection(i);
+            mbServerStats::Row r;
+            r.port = name;
+            r.connection = c->name();
+            fillStatisticsRow(r, c->totalStatistics());
+            rows.append(r);
+        }
+    }
+
+    QHash<QString, quint64> last;
+    for (mbServerStats::Rows_t::iterator it = rows.begin(); it != rows.end(); ++it)
+    {
+        QString key = it->key();
+        quint64 prev = m_statsLast.value(key, 0);
+        it->requestsPerSec = ((elapsed > 0) && (it->requests >= prev)) ? static_cast<double>(it->requests - prev) / elapsed : 0;
+        last.insert(key, it->requests);
+    }
+    m_statsLast.swap(last);
+    m_stats->publish(this, rows);
+}
+
+int mbServerPortRunnable::idleTimeout() const
+{
+    int timeout = m_port->idleTimeout();
+    if (m_stats)
+    {
+        // Note: snapshot must be published in time even if the port has no timed events
+        qint64 t = mbServerStats::SnapshotPeriod - m_statsTimer.elapsed();
+        int statsTimeout = (t > 0) ? static_cast<int>(t) : 0;
+        if ((timeout < 0) || (statsTimeout < timeout))
+            timeout = statsTimeout;
+    }
+    return timeout;
 }
 
 void mbServerPortRunnable::slotBytesTx(const QString &source, const QByteArray &bytes)
 {
-    mbServer::LogTxRx(source, "Tx: " + Modbus::bytesToString(bytes));
+    trace(source, mbCoreTraceRing::Tx, mbCoreTraceRing::Bytes, bytes);
 }
 
 void mbServerPortRunnable::slotBytesRx(const QString &source, const QByteArray &bytes)
 {
-    mbServer::LogTxRx(source, "Rx: " + Modbus::bytesToString(bytes));
+    trace(source, mbCoreTraceRing::Rx, mbCoreTraceRing::Bytes, bytes);
 }
 
 void mbServerPortRunnable::slotAsciiTx(const QString &source, const QByteArray &bytes)
 {
-    mbServer::LogTxRx(source, "Tx: " + Modbus::asciiToString(bytes));
+    trace(source, mbCoreTraceRing::Tx, mbCoreTraceRing::Ascii, bytes);
 }
 
 void mbServerPortRunnable::slotAsciiRx(const QString &source, const QByteArray &bytes)
 {
-    mbServer::LogTxRx(source, "Rx: " + Modbus::asciiToString(bytes));
+    trace(source, mbCoreTraceRing::Rx, mbCoreTraceRing::Ascii, bytes);
+}
+
+void mbServerPortRunnable::trace(const QString &source, mbCoreTraceRing::Direction direction, mbCoreTraceRing::Format format, const QByteArray &bytes)
+{
+    if (!mbServer::IsTraceTxRx())
+        return;
+    mbServer::TraceTxRx(m_traceSource, direction, format, bytes, source);
 }
 
 void mbServerPortRunnable::slotError(const QString &source, int code, const QString &message)
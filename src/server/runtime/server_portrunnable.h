@@ -24,25 +24,35 @@
 #define SERVER_PORTRUNNABLE_H
 
 #include <QObject>
+#include <QElapsedTimer>
 
 #include <Modbus.h>
 
+#include <runtime/core_tracering.h>
+
+#include "server_stats.h"
+
 class mbServerRunDevice;
 
 class mbServerPortRunnable : public QObject
 {
     Q_OBJECT
 public:
-    explicit mbServerPortRunnable(const Modbus::Settings &settings, mbServerRunDevice *device, QObject *parent = nullptr);
+    // Note: runnable takes ownership of the 'port'
+    explicit mbServerPortRunnable(const Modbus::Settings &settings, Modbus::ServerPort *port, QObject *parent = nullptr);
     ~mbServerPortRunnable();
 
 public:
+    inline Modbus::ServerPort *port() const { return m_port; }
     inline QString name() const { return objectName(); }
     void setName(const QString &name);
     
 public:
     void run();
     void close();
+    int idleTimeout() const;
+    // snapshot of request counters is published to 'stats' every 'mbServerStats::SnapshotPeriod'
+    void setStatistics(mbServerRunDevice *device, mbServerStats *stats);
 
 private Q_SLOTS:
     void slotBytesTx(const QString& source, const QByteArray &bytes);
@@ -53,10 +63,18 @@ private Q_SLOTS:
     void slotMessage(const QString& source, const QString& message);
 
 private:
-    Modbus::ServerPort *m_port;
+    void trace(const QString &source, mbCoreTraceRing::Direction direction, mbCoreTraceRing::Format format, const QByteArray &bytes);
+    void publishStatistics();
 
 private:
+    Modbus::ServerPort *m_port;
+    int m_traceSource;
+
+private: // statistics
     mbServerRunDevice *m_device;
+    mbServerStats *m_stats;
+    QElapsedTimer m_statsTimer;
+    QHash<QString, quint64> m_statsLast; // requests of every row at the last snapshot
 };
 
 #endif // SERVER_PORTRUNNABLE_H
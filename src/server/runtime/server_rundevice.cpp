@@ -27,13 +27,25 @@
 mbServerRunDevice::mbServerRunDevice()
 {
     memset(m_units, 0, sizeof(m_units));
+    memset(m_unitStats, 0, sizeof(m_unitStats));
     m_timestamp = 0;
+    m_timer.start();
 }
 
 mbServerRunDevice::~mbServerRunDevice()
 {
 }
 
+Modbus::StatusCode mbServerRunDevice::record(uint8_t unit, qint64 start, Modbus::StatusCode status)
+{
+    UnitStatistics &st = m_unitStats[unit];
+    st.requests++;
+    if (Modbus::StatusIsBad(status))
+        st.exceptions++;
+    st.processTime += static_cast<quint64>(m_timer.nsecsElapsed() - start);
+    return status;
+}
+
 #define CHECK_DELAY                                                 \
     uint delay = device->delay();                                   \
     if (delay > 0)                                                  \
@@ -54,7 +66,8 @@ Modbus::StatusCode mbServerRunDevice::readCoils(uint8_t unit, uint16_t offset, u
     if (!device)
         return Modbus::Status_BadUnknownUnit;
     CHECK_DELAY
-    return device->readCoils(offset, count, values);
+    qint64 start = m_timer.nsecsElapsed();
+    return record(unit, start, device->readCoils(offset, count, values));
 }
 
 Modbus::StatusCode mbServerRunDevice::readDiscreteInputs(uint8_t unit, uint16_t offset, uint16_t count, void *values)
@@ -63,7 +76,8 @@ Modbus::StatusCode mbServerRunDevice::readDiscreteInputs(uint8_t unit, uint16_t
     if (!device)
         return Modbus::Status_BadUnknownUnit;
     CHECK_DELAY
-    return device->readDiscreteInputs(offset, count, values);
+    qint64 start = m_timer.nsecsElapsed();
+    return record(unit, start, device->readDiscreteInputs(offset, count, values));
 }
 
 Modbus::StatusCode mbServerRunDevice::readHoldingRegisters(uint8_t unit, uint16_t offset, uint16_t count, uint16_t *values)
@@ -72,7 +86,8 @@ Modbus::StatusCode mbServerRunDevice::readHoldingRegisters(uint8_t unit, uint16_
     if (!device)
         return Modbus::Status_BadUnknownUnit;
     CHECK_DELAY
-    return device->readHoldingRegisters(offset, count, values);
+    qint64 start = m_timer.nsecsElapsed();
+    return record(unit, start, device->readHoldingRegisters(offset, count, values));
 }
 
 Modbus::StatusCode mbServerRunDevice::readInputRegisters(uint8_t unit, uint16_t offset, uint16_t count, uint16_t *values)
@@ -81,7 +96,8 @@ Modbus::StatusCode mbServerRunDevice::readInputRegisters(uint8_t unit, uint16_t
     if (!device)
         return Modbus::Status_BadUnknownUnit;
     CHECK_DELAY
-    return device->readInputRegisters(offset, count, values);
+    qint64 start = m_timer.nsecsElapsed();
+    return record(unit, start, device->readInputRegisters(offset, count, values));
 }
 
 Modbus::StatusCode mbServerRunDevice::writeSingleCoil(uint8_t unit, uint16_t offset, bool value)
@@ -90,7 +106,8 @@ Modbus::StatusCode mbServerRunDevice::writeSingleCoil(uint8_t unit, uint16_t off
     if (!device)
         return Modbus::Status_BadUnknownUnit;
     CHECK_DELAY
-    return device->writeSingleCoil(offset, value);
+    qint64 start = m_timer.nsecsElapsed();
+    return record(unit, start, device->writeSingleCoil(offset, value));
 }
 
 Modbus::StatusCode mbServerRunDevice::writeSingleRegister(uint8_t unit, uint16_t offset, uint16_t value)
@@ -99,7 +116,8 @@ Modbus::StatusCode mbServerRunDevice::writeSingleRegister(uint8_t unit, uint16_t
     if (!device)
         return Modbus::Status_BadUnknownUnit;
     CHECK_DELAY
-    return device->writeSingleRegister(offset, value);
+    qint64 start = m_timer.nsecsElapsed();
+    return record(unit, start, device->writeSingleRegister(offset, value));
 }
 
 Modbus::StatusCode mbServerRunDevice::readExceptionStatus(uint8_t unit, uint8_t *status)
@@ -108,7 +126,8 @@ Modbus::StatusCode mbServerRunDevice::readExceptionStatus(uint8_t unit, uint8_t
     if (!device)
         return Modbus::Status_BadUnknownUnit;
     CHECK_DELAY
-    return device->readExceptionStatus(status);
+    qint64 start = m_timer.nsecsElapsed();
+    return record(unit, start, device->readExceptionStatus(status));
 }
 
 Modbus::StatusCode mbServerRunDevice::writeMultipleCoils(uint8_t unit, uint16_t offset, uint16_t count, const void *values)
@@ -117,7 +136,8 @@ Modbus::StatusCode mbServerRunDevice::writeMultipleCoils(uint8_t unit, uint16_t
     if (!device)
         return Modbus::Status_BadUnknownUnit;
     CHECK_DELAY
-    return device->writeMultipleCoils(offset, count, values);
+    qint64 start = m_timer.nsecsElapsed();
+    return record(unit, start, device->writeMultipleCoils(offset, count, values));
 }
 
 Modbus::StatusCode mbServerRunDevice::writeMultipleRegisters(uint8_t unit, uint16_t offset, uint16_t count, const uint16_t *values)
@@ -126,5 +146,6 @@ Modbus::StatusCode mbServerRunDevice::writeMultipleRegisters(uint8_t unit, uint1
     if (!device)
         return Modbus::Status_BadUnknownUnit;
     CHECK_DELAY
-    return device->writeMultipleRegisters(offset, count, values);
+    qint64 start = m_timer.nsecsElapsed();
+    return record(unit, start, device->writeMultipleRegisters(offset, count, values));
 }
@@ -23,6 +23,8 @@
 #ifndef SERVER_RUNDEVICE_H
 #define SERVER_RUNDEVICE_H
 
+#include <QElapsedTimer>
+
 #include <mbcore.h>
 
 class mbServerDevice;
@@ -48,12 +50,27 @@ public:
     inline mbServerDevice *device(uint8_t unit) const { return m_units[unit]; }
     inline void setDevice(uint8_t unit, mbServerDevice *device) { m_units[unit] = device; }
 
+public:
+    // Note: counters are written by the thread of the port only and must be read within the same thread
+    struct UnitStatistics
+    {
+        quint64 requests   ; // requests processed by the device of the unit
+        quint64 exceptions ; // requests the device has returned an error for
+        quint64 processTime; // nanoseconds spent by the device (simulated delay is not included)
+    };
+    inline const UnitStatistics &unitStatistics(uint8_t unit) const { return m_unitStats[unit]; }
+
+private:
+    Modbus::StatusCode record(uint8_t unit, qint64 start, Modbus::StatusCode status);
+
 Q_SIGNALS:
 
 private: // devices
     static const int UnitsSize = 256;
     mbServerDevice *m_units[UnitsSize];
+    UnitStatistics m_unitStats[UnitsSize];
     mb::Timestamp_t m_timestamp;
+    QElapsedTimer m_timer;
 };
 
 #endif // SERVER_RUNDEVICE_H
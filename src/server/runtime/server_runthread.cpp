@@ -23,8 +23,18 @@
 #include "server_runthread.h"
 
 #include <QEventLoop>
+#include <QAbstractEventDispatcher>
+#include <QTimer>
+#include <QTcpServer>
+#include <QTcpSocket>
 
-#include <ModbusServerPort.h>
+#ifdef Q_OS_WIN
+#include <winsock2.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <ModbusServerTCP.h>
 
 #include <server.h>
 
@@ -33,31 +43,168 @@
 #include "server_portrunnable.h"
 #include "server_rundevice.h"
 
+// TCP server which doesn't serve accepted connections itself but hands them over to the worker threads
+class mbServerRunAcceptor : public QTcpServer
+{
+public:
+    mbServerRunAcceptor(const QList<mbServerRunThread*> &workers) : m_workers(workers), m_next(0) {}
+
+protected:
+    void incomingConnection(qintptr socketDescriptor) override
+    {
+        m_workers.at(m_next)->appendConnection(socketDescriptor);
+        m_next = (m_next + 1) % m_workers.count();
+    }
+
+private:
+    QList<mbServerRunThread*> m_workers;
+    int m_next;
+};
+
 mbServerRunThread::mbServerRunThread(const Modbus::Settings &settings, mbServerRunDevice *device, QObject *parent)
     : QThread(parent)
 {
     m_ctrlRun = true;
     m_device = device;
+    m_stats = nullptr;
     m_settings = settings;
+    m_worker = false;
 }
 
 mbServerRunThread::~mbServerRunThread()
 {
+    qDeleteAll(m_workers);
     delete m_device;
 }
 
+void mbServerRunThread::stop()
+{
+    m_ctrlRun = false;
+    // wake up thread if it's blocked while waiting for I/O events
+    if (QAbstractEventDispatcher *dispatcher = eventDispatcher())
+        dispatcher->wakeUp();
+}
+
+void mbServerRunThread::setWorkers(const QList<mbServerRunThread*> &workers)
+{
+    qDeleteAll(m_workers);
+    m_workers = workers;
+}
+
+void mbServerRunThread::appendConnection(qintptr socketDescriptor)
+{
+    m_lock.lock();
+    m_descriptors.append(socketDescriptor);
+    m_lock.unlock();
+    if (QAbstractEventDispatcher *dispatcher = eventDispatcher())
+        dispatcher->wakeUp();
+}
+
 void mbServerRunThread::run()
 {
     QEventLoop loop;
-    mbServerPortRunnable port(m_settings, m_device);
-    m_ctrlRun = true;
-    mbServer::LogInfo(port.name(), QStringLiteral("Start"));
+    QTimer timer;
+    timer.setSingleShot(true);
+    mbServerPortRunnable port(m_settings, createServerPort());
+    if (m_stats)
+        port.setStatistics(m_device, m_stats);
+    // Note: 'm_ctrlRun' is not set here, so 'stop()' called before the thread started is not lost
+    if (!m_worker)
+        mbServer::LogInfo(port.name(), QStringLiteral("Start"));
+    Q_FOREACH (mbServerRunThread *w, m_workers)
+        w->start();
     while (m_ctrlRun)
     {
+        // Note: internal timing of the iteration uses the same monotonic time
+        Modbus::updateMonotonicTime();
         loop.processEvents();
+        if (m_worker)
+            takeConnections(port.port());
         port.run();
-        QThread::usleep(1);
+        int timeout = port.idleTimeout();
+        if (timeout > 0)
+        {
+            // block until socket activity or idle timeout elapsed
+            timer.start(timeout);
+            loop.processEvents(QEventLoop::WaitForMoreEvents);
+        }
+        else if (timeout < 0)
+        {
+            // port without connections (e.g. acceptor of TCP workers):
+            // block until socket activity, new connection or 'stop()'
+            timer.stop();
+            loop.processEvents(QEventLoop::WaitForMoreEvents);
+        }
+        else
+            QThread::usleep(1);
+    }
+    Q_FOREACH (mbServerRunThread *w, m_workers)
+        w->stop();
+    Q_FOREACH (mbServerRunThread *w, m_workers)
+    {
+        w->wait();
+        // Note: connections accepted for the worker but never taken by it are closed here
+        w->closeConnections();
     }
     port.close();
-    mbServer::LogInfo(port.name(), QStringLiteral("Stop"));
+    if (!m_worker)
+        mbServer::LogInfo(port.name(), QStringLiteral("Stop"));
+}
+
+Modbus::ServerPort *mbServerRunThread::createServerPort()
+{
+    if (m_worker) // connections are accepted by another thread
+    {
+        Modbus::ServerPort *port = new Modbus::ServerTCP(nullptr, m_device);
+        port->setSettings(m_settings);
+        return port;
+    }
+    if (m_workers.count())
+    {
+        mbServerRunAcceptor *server = new mbServerRunAcceptor(m_workers);
+        Modbus::ServerPort *port = new Modbus::ServerTCP(server, m_device);
+        server->setParent(port);
+        port->setSettings(m_settings);
+        return port;
+    }
+    return Modbus::createServerPort(m_settings, m_device);
+}
+
+void mbServerRunThread::takeConnections(Modbus::ServerPort *port)
+{
+    m_lock.lock();
+    QList<qintptr> descriptors;
+    descriptors.swap(m_descriptors);
+    m_lock.unlock();
+    Modbus::ServerTCP *tcp = static_cast<Modbus::ServerTCP*>(port);
+    Q_FOREACH (qintptr d, descriptors)
+    {
+        QTcpSocket *socket = new QTcpSocket;
+        if (socket->setSocketDescriptor(d))
+            tcp->appendConnection(socket);
+        else
+        {
+            delete socket;
+            closeDescriptor(d);
+        }
+    }
+}
+
+void mbServerRunThread::closeConnections()
+{
+    m_lock.lock();
+    QList<qintptr> descriptors;
+    descriptors.swap(m_descriptors);
+    m_lock.unlock();
+    Q_FOREACH (qintptr d, descriptors)
+        closeDescriptor(d);
+}
+
+void mbServerRunThread::closeDescriptor(qintptr socketDescriptor)
+{
+#ifdef Q_OS_WIN
+    closesocket(static_cast<SOCKET>(socketDescriptor));
+#else
+    ::close(static_cast<int>(socketDescriptor));
+#endif
 }
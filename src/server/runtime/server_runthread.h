@@ -24,10 +24,12 @@
 #define SERVER_RUNTHREAD_H
 
 #include <QThread>
+#include <QMutex>
 
 #include <Modbus.h>
 
 class mbServerRunDevice;
+class mbServerStats;
 
 class mbServerRunThread : public QThread
 {
@@ -36,17 +38,41 @@ public:
     ~mbServerRunThread();
 
 public:
-    inline void stop() { m_ctrlRun = false; }
+    void stop();
+    // statistics of the port is published to 'stats' while thread is running
+    inline void setStats(mbServerStats *stats) { m_stats = stats; }
+
+public: // TCP workers
+    // Note: thread takes ownership of the 'workers', starts them and distributes accepted connections between them
+    void setWorkers(const QList<mbServerRunThread*> &workers);
+    inline bool isWorker() const { return m_worker; }
+    inline void setWorker(bool worker) { m_worker = worker; }
+    // can be called from any thread, connection is served within the thread of the worker
+    void appendConnection(qintptr socketDescriptor);
 
 protected:
     void run() override;
 
+private:
+    Modbus::ServerPort *createServerPort();
+    void takeConnections(Modbus::ServerPort *port);
+    void closeConnections();
+    // closes socket descriptor that is not owned by any socket object
+    static void closeDescriptor(qintptr socketDescriptor);
+
 private:
     bool m_ctrlRun;
 
 private:
     mbServerRunDevice *m_device;
+    mbServerStats *m_stats;
     Modbus::Settings m_settings;
+
+private: // TCP workers
+    bool m_worker;
+    QList<mbServerRunThread*> m_workers;
+    QMutex m_lock;
+    QList<qintptr> m_descriptors;
 };
 
 #endif // SERVER_RUNTHREAD_H
@@ -24,6 +24,8 @@
 
 #include <QCoreApplication>
 
+#include <ModbusServerTCP.h>
+
 #include <server.h>
 
 #include <project/server_project.h>
@@ -38,11 +40,14 @@
 mbServerRuntime::mbServerRuntime(QObject *parent)
     : mbCoreRuntime{parent}
 {
+    m_statsPeriod = 0;
+    m_statsTimer = 0;
 }
 
 void mbServerRuntime::createComponents()
 {
     mbCoreRuntime::createComponents();
+    m_stats.clear();
 
     mbServerRunActionTask *actionTask = new mbServerRunActionTask;
     actionTask->setActions(project()->actions());
@@ -58,6 +63,8 @@ void mbServerRuntime::startComponents()
     mbCoreRuntime::startComponents();
     Q_FOREACH (mbServerRunThread *t, m_threads)
         t->start();
+    if (m_statsPeriod > 0)
+        m_statsTimer = startTimer(m_statsPeriod * 1000);
 }
 
 void mbServerRuntime::beginStopComponents()
@@ -65,6 +72,11 @@ void mbServerRuntime::beginStopComponents()
     mbCoreRuntime::beginStopComponents();
     Q_FOREACH (mbServerRunThread *t, m_threads)
         t->stop();
+    if (m_statsTimer)
+    {
+        killTimer(m_statsTimer);
+        m_statsTimer = 0;
+    }
 }
 
 bool mbServerRuntime::tryStopComponents()
@@ -84,9 +96,50 @@ void mbServerRuntime::clearComponents()
     mbCoreRuntime::clearComponents();
     qDeleteAll(m_threads);
     m_threads.clear();
+    // Note: final snapshots are published when port threads are finished
+    if (m_statsPeriod > 0)
+        dumpStatistics();
+}
+
+void mbServerRuntime::timerEvent(QTimerEvent * /*event*/)
+{
+    dumpStatistics();
+}
+
+void mbServerRuntime::dumpStatistics()
+{
+    const QStringList lines = m_stats.dump();
+    Q_FOREACH (const QString &line, lines)
+        mbServer::LogInfo(QStringLiteral("Statistics"), line);
 }
 
 mbServerRunThread *mbServerRuntime::createRunThread(mbServerPort *port)
+{
+    Modbus::Settings settings = port->settings();
+    // Note: TCP workers and acceptor must block while waiting for I/O events, otherwise
+    // every thread of the port would spin in polling mode
+    if ((port->type() == Modbus::TCP) && (port->workerCount() > 1))
+        settings[Modbus::ServerTCP::Strings::instance().eventDriven] = true;
+    mbServerRunThread *t = new mbServerRunThread(settings, createRunDevice(port));
+    t->setStats(&m_stats);
+    if ((port->type() == Modbus::TCP) && (port->workerCount() > 1))
+    {
+        // Note: every worker has its own run device but device memory is shared between them
+        QList<mbServerRunThread*> workers;
+        for (int i = 0; i < port->workerCount(); i++)
+        {
+            mbServerRunThread *w = new mbServerRunThread(settings, createRunDevice(port));
+            w->setWorker(true);
+            w->setStats(&m_stats);
+            workers.append(w);
+        }
+        t->setWorkers(workers);
+    }
+    m_threads.insert(port, t);
+    return t;
+}
+
+mbServerRunDevice *mbServerRuntime::createRunDevice(mbServerPort *port)
 {
     mbServerRunDevice *device = new mbServerRunDevice();
     for (int unit = 0; unit <= 255; unit++)
@@ -95,8 +148,6 @@ mbServerRunThread *mbServerRuntime::createRunThread(mbServerPort *port)
         if (ref)
             device->setDevice(static_cast<quint8>(unit), ref->device());
     }
-    mbServerRunThread *t = new mbServerRunThread(port->settings(), device);
-    m_threads.insert(port, t);
-    return t;
+    return device;
 }
 
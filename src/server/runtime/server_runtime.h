@@ -27,9 +27,12 @@
 #include <project/server_project.h>
 #include <runtime/core_runtime.h>
 
+#include "server_stats.h"
+
 class mbServerProject;
 class mbServerPort;
 class mbServerRunThread;
+class mbServerRunDevice;
 
 class mbServerRuntime : public mbCoreRuntime
 {
@@ -44,15 +47,25 @@ public:
     void start();
     void stop();
 
+public:
+    // Note: statistics of the last run is kept until the next start
+    inline mbServerStats *stats() { return &m_stats; }
+    void dumpStatistics();
+    // period (seconds) to dump statistics to the log while runtime is running, 0 - disabled
+    inline int statsPeriod() const { return m_statsPeriod; }
+    inline void setStatsPeriod(int seconds) { m_statsPeriod = seconds; }
+
 private:
     void createComponents() override;
     void startComponents() override;
     void beginStopComponents() override;
     bool tryStopComponents() override;
     void clearComponents() override;
+    void timerEvent(QTimerEvent *event) override;
 
 private:
     mbServerRunThread *createRunThread(mbServerPort *port);
+    mbServerRunDevice *createRunDevice(mbServerPort *port);
 
 private:
     mbServerProject *m_project;
@@ -60,6 +73,11 @@ private:
 private: // threads
     typedef QHash<mbServerPort*, mbServerRunThread*> Threads_t;
     Threads_t m_threads;
+
+private:
+    mbServerStats m_stats;
+    int m_statsPeriod;
+    int m_statsTimer;
 };
 
 #endif // SERVER_RUNTIME_H
@@ -0,0 +1,145 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "server_stats.h"
+
+mbServerStats::Row::Row() :
+    unit          (-1),
+    function      (-1),
+    requests      (0),
+    errors        (0),
+    ignored       (0),
+    responses     (0),
+    exceptions    (0),
+    bytesIn       (0),
+    bytesOut      (0),
+    processTime   (0),
+    discarded     (0),
+    requestsPerSec(0)
+{
+}
+
+QString mbServerStats::Row::key() const
+{
+    return QString("%1/%2/%3/%4").arg(port, connection).arg(unit).arg(function);
+}
+
+void mbServerStats::Row::add(const Row &other)
+{
+    requests       += other.requests      ;
+    errors         += other.errors        ;
+    ignored        += other.ignored       ;
+    responses      += other.responses     ;
+    exceptions     += other.exceptions    ;
+    bytesIn        += other.bytesIn       ;
+    bytesOut       += other.bytesOut      ;
+    processTime    += other.processTime   ;
+    discarded      += other.discarded     ;
+    requestsPerSec += other.requestsPerSec;
+}
+
+mbServerStats::mbServerStats()
+{
+}
+
+void mbServerStats::publish(const void *source, const Rows_t &rows)
+{
+    // Note: the lock is held only to find the slot of the source (inserted once) and swap the pointers
+    // of implicitly shared rows, previous rows are released by 'r' after the lock
+    Rows_t r(rows);
+    m_lock.lock();
+    QHash<const void*, Rows_t>::iterator it = m_snapshots.find(source);
+    if (it == m_snapshots.end())
+    {
+        m_sources.append(source);
+        it = m_snapshots.insert(source, Rows_t());
+    }
+    it.value().swap(r);
+    m_lock.unlock();
+}
+
+void mbServerStats::clear()
+{
+    QMutexLocker _(&m_lock);
+    m_sources.clear();
+    m_snapshots.clear();
+}
+
+mbServerStats::Rows_t mbServerStats::snapshot() const
+{
+    // Note: rows are implicitly shared, so lock is held only to copy the references
+    QList<Rows_t> snapshots;
+    m_lock.lock();
+    Q_FOREACH (const void *source, m_sources)
+        snapshots.append(m_snapshots.value(source));
+    m_lock.unlock();
+
+    Rows_t r;
+    QHash<QString, int> index;
+    Q_FOREACH (const Rows_t &rows, snapshots)
+    {
+        Q_FOREACH (const Row &row, rows)
+        {
+            QString key = row.key();
+            QHash<QString, int>::const_iterator it = index.constFind(key);
+            if (it != index.constEnd())
+                r[it.value()].add(row);
+            else
+            {
+                index.insert(key, r.count());
+                r.append(row);
+            }
+        }
+    }
+    return r;
+}
+
+QStringList mbServerStats::dump() const
+{
+    const Rows_t rows = snapshot();
+    QStringList r;
+    r.append(QStringLiteral("Port/Connection/Unit/Function: requests, req/s, errors, ignored, responses, exceptions, bytes in, bytes out, avg process time (us), discarded bytes"));
+    Q_FOREACH (const Row &row, rows)
+    {
+        QString name = row.port;
+        if (row.connection.count())
+            name += QStringLiteral("/") + row.connection;
+        if (row.unit >= 0)
+            name += QString("/Unit %1").arg(row.unit);
+        if (row.function >= 0)
+            name += QStringLiteral("/") + mb::ModbusFunctionString(static_cast<uint8_t>(row.function));
+        double avg = row.responses ? static_cast<double>(row.processTime) / row.responses / 1000.0 : 0;
+        r.append(QString("%1: %2, %3, %4, %5, %6, %7, %8, %9, %10, %11")
+                     .arg(name)
+                     .arg(row.requests)
+                     .arg(row.requestsPerSec, 0, 'f', 1)
+                     .arg(row.errors)
+                     .arg(row.ignored)
+                     .arg(row.responses)
+                     .arg(row.exceptions)
+                     .arg(row.bytesIn)
+                     .arg(row.bytesOut)
+                     .arg(avg, 0, 'f', 1)
+                     .arg(row.discarded));
+    }
+    return r;
+}
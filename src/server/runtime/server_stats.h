@@ -0,0 +1,85 @@
+/*
+    Modbus Tools
+
+    Created: 2023
+    Author: Serhii Marchuk, https://github.com/serhmarch
+
+    Copyright (C) 2023  Serhii Marchuk
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#ifndef SERVER_STATS_H
+#define SERVER_STATS_H
+
+#include <QMutex>
+#include <QHash>
+#include <QVector>
+#include <QStringList>
+
+#include <server_global.h>
+
+// Snapshots of request counters of the server ports: totals per port, per function code,
+// per unit and per TCP connection. Counters are written and copied to snapshot by the port thread
+// (no locks within 'Modbus::ServerPort::process()'), every 'SnapshotPeriod' the snapshot is published here.
+class mbServerStats
+{
+public:
+    // period (milliseconds) to publish snapshot by the port thread
+    static const int SnapshotPeriod = 1000;
+
+    struct Row
+    {
+        QString port;
+        QString connection; // empty if it's not the row of TCP connection
+        int unit;           // -1 if it's not the row of unit
+        int function;       // -1 if it's not the row of function
+        quint64 requests;
+        quint64 errors;
+        quint64 ignored;
+        quint64 responses;
+        quint64 exceptions;
+        quint64 bytesIn;
+        quint64 bytesOut;
+        quint64 processTime; // nanoseconds, total of all responses
+        quint64 discarded;   // bytes discarded by frame resynchronization
+        double requestsPerSec;
+
+        Row();
+        QString key() const;
+        void add(const Row &other);
+    };
+    typedef QVector<Row> Rows_t;
+
+public:
+    mbServerStats();
+
+public:
+    // replaces previous snapshot of the 'source' (port runnable), can be called from any thread
+    void publish(const void *source, const Rows_t &rows);
+    void clear();
+
+public:
+    // latest snapshots of all sources, rows with the same key are summed up (e.g. for TCP workers of the same port)
+    Rows_t snapshot() const;
+    // text table of 'snapshot()'
+    QStringList dump() const;
+
+private:
+    mutable QMutex m_lock;
+    QList<const void*> m_sources;
+    QHash<const void*, Rows_t> m_snapshots;
+};
+
+#endif // SERVER_STATS_H
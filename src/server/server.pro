@@ -30,5 +30,6 @@ SOURCES += \
 
 LIBS  += -L../bin -lcore
 LIBS  += -L../bin -lModbus
+win32:LIBS += -lws2_32
 
 RC_ICONS = gui/icons/server.ico